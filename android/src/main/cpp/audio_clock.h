@@ -0,0 +1,106 @@
+#ifndef AUDIO_CLOCK_H
+#define AUDIO_CLOCK_H
+
+#include <atomic>
+#include <cstdint>
+#include <time.h>
+
+// Clock state published by the audio thread every callback. The layout
+// matches AudioClockState in the Dart FFI layer, which reads it in place.
+// frame is the first frame of the callback's block on the render frame
+// counter and hostTimeNanos the CLOCK_MONOTONIC time it was rendered, when
+// it also starts playing out of the buffer queue; beat is the transport
+// position at that frame.
+struct AudioClockState {
+    std::atomic<uint32_t> sequence;  // Odd while a publish is in progress
+    std::atomic<int32_t> playing;
+    std::atomic<int32_t> sampleRate;
+    std::atomic<int32_t> sequenceId;  // Playing sequence, or -1
+    std::atomic<int64_t> frame;
+    std::atomic<int64_t> hostTimeNanos;
+    std::atomic<double> beat;
+    std::atomic<double> beatsPerSecond;  // 0 while stopped
+};
+
+static_assert(sizeof(AudioClockState) == 48, "AudioClockState layout is shared with Dart");
+static_assert(std::atomic<int64_t>::is_always_lock_free && std::atomic<double>::is_always_lock_free,
+              "AudioClockState fields must be plain memory for Dart");
+
+// Correlates the render frame counter and transport with the host's monotonic
+// clock. The audio thread publishes once per callback; native readers and Dart
+// read the latest snapshot through a seqlock, so neither side ever blocks.
+class AudioClock {
+public:
+    struct Snapshot {
+        bool playing = false;
+        int sampleRate = 0;
+        int sequenceId = -1;
+        int64_t frame = 0;
+        int64_t hostTimeNanos = 0;
+        double beat = 0.0;
+        double beatsPerSecond = 0.0;
+    };
+
+    AudioClock() {
+        m_state.sequence.store(0);
+        m_state.playing.store(0);
+        m_state.sampleRate.store(0);
+        m_state.sequenceId.store(-1);
+        m_state.frame.store(0);
+        m_state.hostTimeNanos.store(0);
+        m_state.beat.store(0.0);
+        m_state.beatsPerSecond.store(0.0);
+    }
+
+    AudioClock(const AudioClock&) = delete;
+    AudioClock& operator=(const AudioClock&) = delete;
+
+    // CLOCK_MONOTONIC in nanoseconds, the clock live note timestamps use
+    static int64_t hostTimeNanos() {
+        timespec ts;
+        clock_gettime(CLOCK_MONOTONIC, &ts);
+        return static_cast<int64_t>(ts.tv_sec) * 1000000000LL + ts.tv_nsec;
+    }
+
+    // Audio thread only
+    void publish(const Snapshot& snapshot) {
+        uint32_t sequence = m_state.sequence.load(std::memory_order_relaxed);
+        m_state.sequence.store(sequence + 1, std::memory_order_relaxed);
+        std::atomic_thread_fence(std::memory_order_release);
+        m_state.playing.store(snapshot.playing ? 1 : 0, std::memory_order_relaxed);
+        m_state.sampleRate.store(snapshot.sampleRate, std::memory_order_relaxed);
+        m_state.sequenceId.store(snapshot.sequenceId, std::memory_order_relaxed);
+        m_state.frame.store(snapshot.frame, std::memory_order_relaxed);
+        m_state.hostTimeNanos.store(snapshot.hostTimeNanos, std::memory_order_relaxed);
+        m_state.beat.store(snapshot.beat, std::memory_order_relaxed);
+        m_state.beatsPerSecond.store(snapshot.beatsPerSecond, std::memory_order_relaxed);
+        m_state.sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // Any thread; false until the first callback has published
+    bool read(Snapshot& snapshot) const {
+        uint32_t before;
+        uint32_t after;
+        do {
+            before = m_state.sequence.load(std::memory_order_acquire);
+            snapshot.playing = m_state.playing.load(std::memory_order_relaxed) != 0;
+            snapshot.sampleRate = m_state.sampleRate.load(std::memory_order_relaxed);
+            snapshot.sequenceId = m_state.sequenceId.load(std::memory_order_relaxed);
+            snapshot.frame = m_state.frame.load(std::memory_order_relaxed);
+            snapshot.hostTimeNanos = m_state.hostTimeNanos.load(std::memory_order_relaxed);
+            snapshot.beat = m_state.beat.load(std::memory_order_relaxed);
+            snapshot.beatsPerSecond = m_state.beatsPerSecond.load(std::memory_order_relaxed);
+            std::atomic_thread_fence(std::memory_order_acquire);
+            after = m_state.sequence.load(std::memory_order_relaxed);
+        } while ((before & 1) != 0 || before != after);
+        return before != 0;
+    }
+
+    // The shared state, for readers outside C++; valid as long as the clock
+    const AudioClockState* state() const { return &m_state; }
+
+private:
+    alignas(64) AudioClockState m_state;
+};
+
+#endif // AUDIO_CLOCK_H
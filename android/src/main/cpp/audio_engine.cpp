@@ -37,6 +37,9 @@ AudioEngine::AudioEngine()
 {
     LOGI("AudioEngine: Constructor called");
     
+    m_instrumentManager->setEventPublisher(&m_events);
+    m_sequenceManager->setEventPublisher(&m_events);
+    
     // Initialize audio buffers to nullptr
     for (int i = 0; i < BUFFER_COUNT; i++) {
         m_audioBuffers[i] = nullptr;
@@ -111,14 +114,14 @@ bool AudioEngine::init(int sampleRate) {
             2  // number of buffers
         };
         
-        // PCM format
+        // PCM format (interleaved stereo, matching InstrumentManager::renderAudio)
         SLDataFormat_PCM format_pcm = {
             SL_DATAFORMAT_PCM,
-            1,                                // numChannels
+            2,                                // numChannels
             static_cast<SLuint32>(sampleRate * 1000), // Sample rate in milli-Hz
             SL_PCMSAMPLEFORMAT_FIXED_16,      // bitsPerSample
             SL_PCMSAMPLEFORMAT_FIXED_16,      // containerSize
-            SL_SPEAKER_FRONT_CENTER,          // channelMask
+            SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT, // channelMask
             SL_BYTEORDER_LITTLEENDIAN         // endianness
         };
         
@@ -171,9 +174,9 @@ bool AudioEngine::init(int sampleRate) {
             return false;
         }
         
-        // Initialize audio buffers
+        // Initialize audio buffers (interleaved stereo)
         LOGI("Initializing audio buffers");
-        int bufferSize = BUFFER_SIZE; // Default buffer size
+        int bufferSize = m_framesPerBuffer * 2;
         for (int i = 0; i < BUFFER_COUNT; i++) {
             m_audioBuffers[i] = new short[bufferSize];
             memset(m_audioBuffers[i], 0, bufferSize * sizeof(short));
@@ -190,11 +193,15 @@ bool AudioEngine::init(int sampleRate) {
         if (!m_instrumentManager) {
             m_instrumentManager = std::make_unique<InstrumentManager>();
         }
+        m_instrumentManager->setAudioEngine(this);
+        m_instrumentManager->init();
+        m_limiter.init(m_sampleRate);
         
         // Initialize the sequence manager
         LOGI("Initializing sequence manager");
         if (!m_sequenceManager) {
             m_sequenceManager = std::make_unique<SequenceManager>(nullptr, m_instrumentManager.get());
+            m_sequenceManager->setEventPublisher(&m_events);
         }
         
         // Enqueue an empty buffer to start things
@@ -222,6 +229,12 @@ void AudioEngine::cleanup() {
     LOGI("AudioEngine: Cleaning up resources");
     
     try {
+        // The recorder lives on the engine object, so it goes first
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_recorder.reset();
+        }
+        
         // Clean up OpenSL ES objects in reverse order of creation
         if (m_playerObj) {
             (*m_playerObj)->Destroy(m_playerObj);
@@ -331,8 +344,9 @@ void AudioEngine::stop() {
             }
         }
         
-        // Set running flag to false
+        // Set running flag to false; the gap until a restart isn't an underrun
         m_isRunning.store(false);
+        m_lastCallbackNanos = 0;
         LOGI("Audio engine stopped successfully");
     } catch (const std::exception& e) {
         LOGE("Exception in stop(): %s", e.what());
@@ -341,6 +355,12 @@ void AudioEngine::stop() {
     }
 }
 
+void AudioEngine::setLimiter(float ceilingDb, float releaseMs) {
+    LOGD("Setting limiter ceiling to %f dB, release to %f ms", ceilingDb, releaseMs);
+    m_limiter.setCeiling(ceilingDb);
+    m_limiter.setRelease(releaseMs);
+}
+
 void AudioEngine::setMasterVolume(float volume) {
     LOGD("Setting master volume to %f", volume);
     
@@ -383,6 +403,103 @@ float AudioEngine::getMasterVolume() const {
     return m_masterVolume;
 }
 
+int64_t AudioEngine::hostTimeToFrame(int64_t hostNanos) const {
+    AudioClock::Snapshot clock;
+    if (!m_clock.read(clock)) {
+        return -1;
+    }
+    
+    // A tap made just after a callback still lands within the next block
+    int latency = m_liveLatencyFrames.load(std::memory_order_relaxed);
+    if (latency < 0) {
+        latency = m_framesPerBuffer;
+    }
+    double elapsedFrames = static_cast<double>(hostNanos - clock.hostTimeNanos) * m_sampleRate / 1e9;
+    return clock.frame + static_cast<int64_t>(std::llround(elapsedFrames)) + latency;
+}
+
+NoteInputRing* AudioEngine::getNoteInput(int capacity) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_noteInputRing) {
+        try {
+            m_noteInputRing = std::make_unique<NoteInputRing>(static_cast<uint32_t>(std::max(0, capacity)));
+        } catch (const std::bad_alloc&) {
+            LOGE("Failed to allocate note input ring");
+            return nullptr;
+        }
+        m_noteInput.store(m_noteInputRing.get(), std::memory_order_release);
+        LOGI("Note input ring created with %u events", m_noteInputRing->capacity());
+    }
+    return m_noteInputRing.get();
+}
+
+AudioTap* AudioEngine::getAudioTap(int trackId, int capacityFrames) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int source = trackId < 0 ? AudioTap::MASTER_SOURCE : trackId;
+    for (const auto& tap : m_audioTaps) {
+        if (tap->source() == source) {
+            return tap.get();
+        }
+    }
+    if (source != AudioTap::MASTER_SOURCE && !m_instrumentManager) {
+        LOGE("No instrument manager to tap track %d from", trackId);
+        return nullptr;
+    }
+    
+    std::unique_ptr<AudioTap> tap;
+    try {
+        tap = std::make_unique<AudioTap>(source, static_cast<uint32_t>(std::max(0, capacityFrames)));
+    } catch (const std::bad_alloc&) {
+        LOGE("Failed to allocate audio tap for source %d", source);
+        return nullptr;
+    }
+    
+    if (source == AudioTap::MASTER_SOURCE) {
+        m_masterTap.store(tap.get(), std::memory_order_release);
+    } else if (!m_instrumentManager->getMixer().addTap(tap.get())) {
+        LOGE("No free tap slot for track %d", trackId);
+        return nullptr;
+    }
+    LOGI("Audio tap for source %d created with %u frames", source, tap->capacity());
+    m_audioTaps.push_back(std::move(tap));
+    return m_audioTaps.back().get();
+}
+
+bool AudioEngine::startRecording(const std::string& path, int channels, float latencyMs) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (!m_isInitialized || !m_engine) {
+        LOGE("Cannot record: audio engine not initialized");
+        return false;
+    }
+    if (!m_recorder) {
+        m_recorder = std::make_unique<InputRecorder>(m_engine, m_sampleRate, m_clock);
+    }
+    return m_recorder->start(path, channels, latencyMs);
+}
+
+bool AudioEngine::stopRecording() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    return m_recorder && m_recorder->stop();
+}
+
+RecordingStatus AudioEngine::getRecordingStatus() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_recorder) {
+        return m_recorder->getStatus();
+    }
+    RecordingStatus status = {};
+    status.startFrame = -1;
+    status.sequenceId = -1;
+    status.state = RecordingStatus::IDLE;
+    return status;
+}
+
+void AudioEngine::setLiveLatency(float latencyMs) {
+    int frames = latencyMs < 0.0f ? -1 : static_cast<int>(latencyMs * m_sampleRate / 1000.0f);
+    m_liveLatencyFrames.store(frames, std::memory_order_relaxed);
+    LOGI("Live note latency set to %d frames", frames);
+}
+
 void AudioEngine::renderAudio(float* buffer, int numFrames) {
     if (!buffer || numFrames <= 0) {
         return;
@@ -412,6 +529,20 @@ void AudioEngine::processNextBuffer() {
     }
     
     try {
+        // A callback arriving well over a buffer period after the last one
+        // means the device ran out of queued audio
+        int64_t now = AudioClock::hostTimeNanos();
+        int64_t periodNanos = static_cast<int64_t>(m_framesPerBuffer) * 1000000000LL / m_sampleRate;
+        if (m_lastCallbackNanos > 0 && now - m_lastCallbackNanos > periodNanos * 3 / 2) {
+            EngineEvent underrun = {};
+            underrun.frame = m_instrumentManager->getRenderedFrames();
+            underrun.value = static_cast<double>(now - m_lastCallbackNanos - periodNanos) / 1e6;
+            underrun.id = -1;
+            underrun.type = EngineEvent::UNDERRUN;
+            m_events.pushAudio(underrun);
+        }
+        m_lastCallbackNanos = now;
+        
         // Clear the temporary buffer
         std::memset(m_tempBuffer, 0, m_framesPerBuffer * 2 * sizeof(float));
         
@@ -457,83 +588,51 @@ SequenceManager* AudioEngine::getSequenceManager() const {
     return m_sequenceManager.get();
 }
 
-void AudioEngine::onProcessSamples(float* buffer, int numSamples) {
+void AudioEngine::onProcessSamples(float* buffer, int numFrames) {
     // Lock the audio mutex to prevent concurrent modifications
     std::lock_guard<std::mutex> lock(m_audioMutex);
     
-    // Clear the buffer initially
-    std::fill(buffer, buffer + numSamples, 0.0f);
-    
     if (!m_instrumentManager) {
         LOGW("No instrument manager available for rendering");
+        std::fill(buffer, buffer + numFrames * 2, 0.0f);
         return;
     }
     
-    // Generate sine wave samples for active notes with simple additive synthesis
-    try {
-        // Get all active instruments and their notes
-        auto activeInstruments = m_instrumentManager->getActiveInstruments();
-        LOGD("Rendering audio for %zu active instruments", activeInstruments.size());
-        
-        for (auto instrumentId : activeInstruments) {
-            auto activeNotes = m_instrumentManager->getActiveNotes(instrumentId);
-            
-            if (activeNotes.empty()) {
-                continue;
+    // Live notes Dart wrote into shared memory start at the top of the block
+    if (NoteInputRing* noteInput = m_noteInput.load(std::memory_order_acquire)) {
+        noteInput->drain([this](const NoteInputRing::Event& event) {
+            if (event.type == NoteInputRing::NOTE_ON) {
+                m_instrumentManager->sendNoteOn(event.instrumentId, event.noteNumber, event.velocity);
+            } else if (event.type == NoteInputRing::NOTE_OFF) {
+                m_instrumentManager->sendNoteOff(event.instrumentId, event.noteNumber);
             }
-            
-            LOGD("Rendering instrument %d with %zu active notes", instrumentId, activeNotes.size());
-            
-            // Get the instrument settings
-            auto instrument = m_instrumentManager->getInstrument(instrumentId);
-            if (!instrument.has_value()) {
-                continue;
-            }
-            
-            float instrumentVolume = instrument->volume;
-            
-            // For each active note, generate sine wave and add to buffer
-            for (int noteNumber : activeNotes) {
-                // Get the velocity (0-127) for this note and normalize to 0.0-1.0
-                float velocity = m_instrumentManager->getNoteVelocity(instrumentId, noteNumber) / 127.0f;
-                
-                // Convert MIDI note to frequency
-                // Formula: f = 440 * 2^((n-69)/12) where n is MIDI note number
-                float frequency = 440.0f * std::pow(2.0f, (noteNumber - 69.0f) / 12.0f);
-                
-                // Get the current phase for this note
-                float& phase = m_instrumentManager->getNotePhase(instrumentId, noteNumber);
-                
-                // Generate sine wave samples
-                for (int i = 0; i < numSamples; i++) {
-                    // Generate sine sample: amplitude * sin(2π * frequency * time)
-                    float sample = velocity * instrumentVolume * std::sin(phase);
-                    
-                    // Add sample to buffer (additive synthesis)
-                    buffer[i] += sample * 0.2f; // Scale to avoid clipping
-                    
-                    // Update phase for next sample
-                    // phase += 2π * frequency / sampleRate
-                    phase += 2.0f * M_PI * frequency / m_sampleRate;
-                    
-                    // Wrap phase to stay within 0 to 2π
-                    while (phase >= 2.0f * M_PI) {
-                        phase -= 2.0f * M_PI;
-                    }
-                }
-                
-                LOGD("Generated sine wave for note %d at %.2f Hz", noteNumber, frequency);
-            }
-        }
-    } catch (const std::exception& e) {
-        LOGE("Exception in audio processing: %s", e.what());
-    } catch (...) {
-        LOGE("Unknown exception in audio processing");
+        });
     }
     
-    // Clipping prevention for final output
-    for (int i = 0; i < numSamples; i++) {
-        // Clamp values to avoid distortion
-        buffer[i] = std::max(-1.0f, std::min(1.0f, buffer[i]));
+    // Apply the sequencer events due in this block; the scheduler thread
+    // has already worked them out
+    AudioClock::Snapshot clock;
+    clock.hostTimeNanos = AudioClock::hostTimeNanos();
+    if (m_sequenceManager) {
+        m_sequenceManager->renderEvents(numFrames, m_sampleRate);
+        clock.playing = m_sequenceManager->getAudiblePosition(clock.beat, clock.beatsPerSecond, clock.sequenceId);
     }
-} 
\ No newline at end of file
+    
+    // Stamp the block start for live notes and the Dart playhead
+    clock.sampleRate = m_sampleRate;
+    clock.frame = m_instrumentManager->getRenderedFrames();
+    m_clock.publish(clock);
+    
+    // Render all voices (interleaved stereo); polyphony limits bound the cost
+    m_instrumentManager->renderAudio(buffer, numFrames, m_masterVolume);
+    
+    // Keep the master output under the limiter ceiling
+    m_limiter.process(buffer, numFrames);
+    m_instrumentManager->getMixer().meterMaster(buffer, numFrames);
+    
+    // Hand the final mix to the master tap, stamped with the block's frame
+    if (AudioTap* tap = m_masterTap.load(std::memory_order_acquire)) {
+        tap->write(buffer, numFrames);
+        tap->commit(numFrames, clock.frame);
+    }
+}
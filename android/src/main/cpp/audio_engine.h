@@ -4,10 +4,18 @@
 #include <thread>
 #include <atomic>
 #include <memory>
+#include <string>
+#include <vector>
 #include <SLES/OpenSLES.h>
 #include <SLES/OpenSLES_Android.h>
 #include "instrument_manager.h"
 #include "sequence_manager.h"
+#include "limiter.h"
+#include "audio_clock.h"
+#include "note_input_ring.h"
+#include "audio_tap.h"
+#include "input_recorder.h"
+#include "event_publisher.h"
 
 class AudioEngine {
 public:
@@ -25,7 +33,7 @@ public:
     
     // Audio processing
     void processNextBuffer();
-    void onProcessSamples(float* buffer, int numSamples);
+    void onProcessSamples(float* buffer, int numFrames);
     void renderAudio(float* buffer, int numFrames);
     
     // Getters
@@ -37,6 +45,41 @@ public:
     void setMasterVolume(float volume);
     float getMasterVolume() const;
     
+    // Master limiter settings (lock-free)
+    void setLimiter(float ceilingDb, float releaseMs);
+    
+    // Live note timing. hostTimeToFrame maps a CLOCK_MONOTONIC timestamp
+    // (AudioClock::hostTimeNanos) onto the render frame counter, adding a
+    // constant latency so events between callbacks land on their own frame
+    // in the next block instead of at its start. -1 before the first callback.
+    int64_t hostTimeToFrame(int64_t hostNanos) const;
+    void setLiveLatency(float latencyMs);
+    
+    // Clock state republished every callback; Dart maps it to extrapolate the
+    // playhead without calling in. Lives as long as the engine.
+    const AudioClockState* getClockState() const { return m_clock.state(); }
+    
+    // Shared-memory note input (see NoteInputRing), drained at the start of
+    // every callback. Created on first use and kept until the engine goes;
+    // later calls return the same ring. Null if it can't be allocated.
+    NoteInputRing* getNoteInput(int capacity);
+    
+    // Rendered audio tap (see AudioTap) of the master output (trackId -1,
+    // post-limiter) or one track's bus (post-fader). A track that doesn't exist
+    // yet reads as silence. One tap per source, created on first use and kept
+    // until the engine goes; later calls return the same tap. Null if it can't
+    // be allocated or every track tap slot is taken.
+    AudioTap* getAudioTap(int trackId, int capacityFrames);
+    
+    // Input recording (see InputRecorder) to a WAV file at path, aligned to the
+    // render timeline less latencyMs of round-trip latency. One take at a time.
+    bool startRecording(const std::string& path, int channels, float latencyMs);
+    bool stopRecording();
+    RecordingStatus getRecordingStatus();
+    
+    // Engine events for Dart; started and stopped through the FFI layer
+    EventPublisher& getEventPublisher() { return m_events; }
+    
     // Is audio engine running?
     bool isRunning() const { return m_isRunning.load(); }
     
@@ -54,6 +97,28 @@ private:
     // Master volume
     float m_masterVolume = 1.0f;
     
+    // Master bus limiter
+    Limiter m_limiter;
+    
+    // Engine events; declared before the managers that push into it
+    EventPublisher m_events;
+    int64_t m_lastCallbackNanos = 0;  // For underrun detection
+    
+    // Note input written by Dart; published to the audio thread once created
+    std::unique_ptr<NoteInputRing> m_noteInputRing;
+    std::atomic<NoteInputRing*> m_noteInput{nullptr};
+    
+    // Audio taps read by Dart; the master tap is fed here, track taps by the mixer
+    std::vector<std::unique_ptr<AudioTap>> m_audioTaps;
+    std::atomic<AudioTap*> m_masterTap{nullptr};
+    
+    // Input recorder, created on first use on the output engine's OpenSL engine
+    std::unique_ptr<InputRecorder> m_recorder;
+    
+    // Render frame, transport and host time correlation, published every callback
+    AudioClock m_clock;
+    std::atomic<int> m_liveLatencyFrames{-1};  // -1 = one buffer
+    
     // Audio thread synchronization
     std::mutex m_audioMutex;
     std::mutex m_mutex;
@@ -0,0 +1,131 @@
+#ifndef AUDIO_TAP_H
+#define AUDIO_TAP_H
+
+#include <algorithm>
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+
+// Rendered audio copied into native memory that Dart reads in place, for
+// waveform displays and recording previews. The audio thread is the only
+// writer and never waits for readers: each reader keeps its own cursor, so any
+// number of them can follow the same tap, and one that falls more than a
+// capacity behind has been overwritten. The block is a 64-byte header followed
+// by capacity interleaved stereo float frames; the layout matches AudioTap in
+// the Dart FFI layer:
+//
+//   offset 0   int64   written     frames published, advanced once per callback
+//   offset 8   int64   startFrame  render frame of tap frame 0, -1 until written
+//   offset 16  uint32  capacity    frames, power of two
+//   offset 20  uint32  channels    always 2
+//   offset 24  int32   source      track ID, or -1 for the master output
+//   offset 28  uint32  guard       frames below the lap point readers must avoid
+//   offset 64  float   samples[capacity * channels]
+//
+// Tap frame n was rendered at render frame startFrame + n, the counter the
+// shared AudioClock publishes, so readers can line samples up with the
+// transport. Samples are published a whole callback at a time: the written
+// count is only stored (with release ordering) once the block is in place.
+// The next block is copied in before its count is published, overwriting the
+// oldest frames unannounced, so readers treat the guard frames at the old end
+// of the ring (one maximum callback block) as already gone.
+class AudioTap {
+public:
+    static constexpr int MASTER_SOURCE = -1;
+    static constexpr uint32_t CHANNELS = 2;
+    static constexpr uint32_t MAX_BLOCK_FRAMES = 4096;  // Largest callback block written
+    static constexpr uint32_t MIN_CAPACITY = 4 * MAX_BLOCK_FRAMES;
+    static constexpr uint32_t MAX_CAPACITY = 1 << 20;
+    static constexpr size_t HEADER_BYTES = 64;
+
+    // capacity (frames) is rounded up to a power of two within MIN/MAX_CAPACITY
+    AudioTap(int source, uint32_t capacity) {
+        uint32_t size = MIN_CAPACITY;
+        while (size < capacity && size < MAX_CAPACITY) {
+            size <<= 1;
+        }
+        m_capacity = size;
+        m_source = source;
+        size_t bytes = HEADER_BYTES + static_cast<size_t>(size) * CHANNELS * sizeof(float);
+        void* memory = nullptr;
+        if (posix_memalign(&memory, 64, bytes) != 0) {
+            throw std::bad_alloc();
+        }
+        m_memory = static_cast<uint8_t*>(memory);
+        std::memset(m_memory, 0, bytes);
+        new (m_memory) std::atomic<int64_t>(0);
+        new (m_memory + 8) std::atomic<int64_t>(-1);
+        *reinterpret_cast<uint32_t*>(m_memory + 16) = size;
+        *reinterpret_cast<uint32_t*>(m_memory + 20) = CHANNELS;
+        *reinterpret_cast<int32_t*>(m_memory + 24) = source;
+        *reinterpret_cast<uint32_t*>(m_memory + 28) = MAX_BLOCK_FRAMES;
+        m_samples = reinterpret_cast<float*>(m_memory + HEADER_BYTES);
+    }
+
+    ~AudioTap() { std::free(m_memory); }
+
+    AudioTap(const AudioTap&) = delete;
+    AudioTap& operator=(const AudioTap&) = delete;
+
+    uint8_t* data() const { return m_memory; }
+    uint32_t capacity() const { return m_capacity; }
+    int source() const { return m_source; }
+
+    // Audio thread only: append interleaved stereo frames to the pending block
+    void write(const float* frames, int numFrames) {
+        int64_t position = written().load(std::memory_order_relaxed) + m_pending;
+        for (int done = 0; done < numFrames;) {
+            uint32_t offset = static_cast<uint32_t>(position + done) & (m_capacity - 1);
+            int count = std::min(numFrames - done, static_cast<int>(m_capacity - offset));
+            std::memcpy(m_samples + offset * CHANNELS, frames + done * CHANNELS,
+                        sizeof(float) * CHANNELS * count);
+            done += count;
+        }
+        m_pending += numFrames;
+    }
+
+    // Audio thread only: append silent frames to the pending block
+    void writeSilence(int numFrames) {
+        int64_t position = written().load(std::memory_order_relaxed) + m_pending;
+        for (int done = 0; done < numFrames;) {
+            uint32_t offset = static_cast<uint32_t>(position + done) & (m_capacity - 1);
+            int count = std::min(numFrames - done, static_cast<int>(m_capacity - offset));
+            std::memset(m_samples + offset * CHANNELS, 0, sizeof(float) * CHANNELS * count);
+            done += count;
+        }
+        m_pending += numFrames;
+    }
+
+    // Audio thread only: publish the callback's block, padding it with silence
+    // to numFrames so the tap stays in step with the render frame counter.
+    // blockStartFrame is the render frame the block began at.
+    void commit(int numFrames, int64_t blockStartFrame) {
+        if (m_pending < numFrames) {
+            writeSilence(numFrames - m_pending);
+        }
+        int64_t position = written().load(std::memory_order_relaxed);
+        if (startFrame().load(std::memory_order_relaxed) < 0) {
+            startFrame().store(blockStartFrame - position, std::memory_order_relaxed);
+        }
+        written().store(position + m_pending, std::memory_order_release);
+        m_pending = 0;
+    }
+
+private:
+    std::atomic<int64_t>& written() { return *reinterpret_cast<std::atomic<int64_t>*>(m_memory); }
+    std::atomic<int64_t>& startFrame() { return *reinterpret_cast<std::atomic<int64_t>*>(m_memory + 8); }
+
+    uint8_t* m_memory = nullptr;
+    float* m_samples = nullptr;
+    uint32_t m_capacity = 0;
+    int m_source = MASTER_SOURCE;
+    int m_pending = 0;  // Frames written this callback, not yet published
+
+    static_assert(sizeof(std::atomic<int64_t>) == 8 && std::atomic<int64_t>::is_always_lock_free,
+                  "Tap indices must be plain memory for Dart");
+};
+
+#endif // AUDIO_TAP_H
@@ -0,0 +1,78 @@
+#include "command_buffer.h"
+#include <cstring>
+
+namespace {
+
+// Sequential little-endian reader over the command bytes
+class Reader {
+public:
+    Reader(const uint8_t* data, size_t length) : m_data(data), m_remaining(length) {}
+
+    bool done() const { return m_remaining == 0; }
+
+    template <typename T>
+    bool read(T& value) {
+        if (m_remaining < sizeof(T)) {
+            return false;
+        }
+        std::memcpy(&value, m_data, sizeof(T));
+        m_data += sizeof(T);
+        m_remaining -= sizeof(T);
+        return true;
+    }
+
+private:
+    const uint8_t* m_data;
+    size_t m_remaining;
+};
+
+} // namespace
+
+bool decodeCommands(const uint8_t* data, size_t length, std::vector<EditCommand>& commands, std::string& error) {
+    if (!data && length > 0) {
+        error = "Null command buffer";
+        return false;
+    }
+
+    Reader reader(data, length);
+    while (!reader.done()) {
+        uint8_t opcode;
+        reader.read(opcode);
+
+        EditCommand command;
+        command.type = static_cast<CommandType>(opcode);
+        bool ok = reader.read(command.sequenceId);
+        switch (command.type) {
+            case CommandType::SET_TRACK_VOLUME:
+            case CommandType::SET_TRACK_PAN:
+                ok = ok && reader.read(command.trackId) && reader.read(command.floatValue);
+                break;
+            case CommandType::DELETE_NOTE:
+                ok = ok && reader.read(command.trackId) && reader.read(command.noteId);
+                break;
+            case CommandType::MOVE_NOTE:
+                ok = ok && reader.read(command.trackId) && reader.read(command.noteId) &&
+                     reader.read(command.startBeat) && reader.read(command.durationBeats);
+                break;
+            case CommandType::TRANSPOSE_NOTE:
+            case CommandType::SET_NOTE_VELOCITY:
+                ok = ok && reader.read(command.trackId) && reader.read(command.noteId) &&
+                     reader.read(command.intValue);
+                break;
+            case CommandType::SET_TEMPO:
+                ok = ok && reader.read(command.bpm);
+                break;
+            default:
+                error = "Unknown command opcode " + std::to_string(opcode) +
+                        " at command " + std::to_string(commands.size());
+                return false;
+        }
+
+        if (!ok) {
+            error = "Truncated command " + std::to_string(commands.size());
+            return false;
+        }
+        commands.push_back(command);
+    }
+    return true;
+}
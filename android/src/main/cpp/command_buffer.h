@@ -0,0 +1,47 @@
+#ifndef COMMAND_BUFFER_H
+#define COMMAND_BUFFER_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Edit commands submitted from Dart in one batch.
+//
+// Wire format: commands back to back, each a one-byte opcode followed by its
+// payload; little-endian, no padding. Payloads (i32 = int32, f32 = float,
+// f64 = double):
+//   1 SET_TRACK_VOLUME   i32 sequence, i32 track, f32 volume
+//   2 SET_TRACK_PAN      i32 sequence, i32 track, f32 pan
+//   3 DELETE_NOTE        i32 sequence, i32 track, i32 note
+//   4 MOVE_NOTE          i32 sequence, i32 track, i32 note, f64 startBeat, f64 durationBeats
+//   5 TRANSPOSE_NOTE     i32 sequence, i32 track, i32 note, i32 semitones
+//   6 SET_NOTE_VELOCITY  i32 sequence, i32 track, i32 note, i32 velocity
+//   7 SET_TEMPO          i32 sequence, f64 bpm (the tempo at beat 0)
+enum class CommandType : uint8_t {
+    SET_TRACK_VOLUME = 1,
+    SET_TRACK_PAN = 2,
+    DELETE_NOTE = 3,
+    MOVE_NOTE = 4,
+    TRANSPOSE_NOTE = 5,
+    SET_NOTE_VELOCITY = 6,
+    SET_TEMPO = 7,
+};
+
+struct EditCommand {
+    CommandType type;
+    int32_t sequenceId = -1;
+    int32_t trackId = -1;
+    int32_t noteId = -1;
+    int32_t intValue = 0;      // Semitones or velocity
+    float floatValue = 0.0f;   // Volume or pan
+    double startBeat = 0.0;
+    double durationBeats = 0.0;
+    double bpm = 0.0;
+};
+
+// Decode a whole buffer up front so a malformed one is rejected before
+// anything is applied
+bool decodeCommands(const uint8_t* data, size_t length, std::vector<EditCommand>& commands, std::string& error);
+
+#endif // COMMAND_BUFFER_H
@@ -0,0 +1,118 @@
+#ifndef DSP_KERNELS_H
+#define DSP_KERNELS_H
+
+// Small inner-loop kernels shared by the mixer and renderers.
+// Each has a NEON path (arm64-v8a, armeabi-v7a with NEON), an SSE path
+// (x86, x86_64) and a scalar fallback.
+
+#if defined(__ARM_NEON) || defined(__ARM_NEON__)
+#include <arm_neon.h>
+#define DSP_USE_NEON 1
+#elif defined(__SSE2__)
+#include <emmintrin.h>
+#define DSP_USE_SSE 1
+#endif
+
+namespace dsp {
+
+// Add a mono signal into an interleaved stereo buffer with per-channel gains
+// that ramp linearly: sample i uses gainLeft + i * stepLeft (and likewise right).
+inline void mixMonoToStereo(const float* in, float* out, int numFrames,
+                            float gainLeft, float stepLeft,
+                            float gainRight, float stepRight) {
+    int i = 0;
+
+#if defined(DSP_USE_NEON)
+    const float ramp[4] = {0.0f, 1.0f, 2.0f, 3.0f};
+    float32x4_t offsets = vld1q_f32(ramp);
+    float32x4_t gl = vmlaq_n_f32(vdupq_n_f32(gainLeft), offsets, stepLeft);
+    float32x4_t gr = vmlaq_n_f32(vdupq_n_f32(gainRight), offsets, stepRight);
+    float32x4_t dl = vdupq_n_f32(stepLeft * 4.0f);
+    float32x4_t dr = vdupq_n_f32(stepRight * 4.0f);
+
+    for (; i + 4 <= numFrames; i += 4) {
+        float32x4_t x = vld1q_f32(in + i);
+        float32x4x2_t o = vld2q_f32(out + i * 2);
+        o.val[0] = vmlaq_f32(o.val[0], x, gl);
+        o.val[1] = vmlaq_f32(o.val[1], x, gr);
+        vst2q_f32(out + i * 2, o);
+        gl = vaddq_f32(gl, dl);
+        gr = vaddq_f32(gr, dr);
+    }
+#elif defined(DSP_USE_SSE)
+    __m128 offsets = _mm_set_ps(3.0f, 2.0f, 1.0f, 0.0f);
+    __m128 gl = _mm_add_ps(_mm_set1_ps(gainLeft), _mm_mul_ps(offsets, _mm_set1_ps(stepLeft)));
+    __m128 gr = _mm_add_ps(_mm_set1_ps(gainRight), _mm_mul_ps(offsets, _mm_set1_ps(stepRight)));
+    __m128 dl = _mm_set1_ps(stepLeft * 4.0f);
+    __m128 dr = _mm_set1_ps(stepRight * 4.0f);
+
+    for (; i + 4 <= numFrames; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        __m128 l = _mm_mul_ps(x, gl);
+        __m128 r = _mm_mul_ps(x, gr);
+        float* o = out + i * 2;
+        _mm_storeu_ps(o, _mm_add_ps(_mm_loadu_ps(o), _mm_unpacklo_ps(l, r)));
+        _mm_storeu_ps(o + 4, _mm_add_ps(_mm_loadu_ps(o + 4), _mm_unpackhi_ps(l, r)));
+        gl = _mm_add_ps(gl, dl);
+        gr = _mm_add_ps(gr, dr);
+    }
+#endif
+
+    for (; i < numFrames; i++) {
+        out[i * 2] += in[i] * (gainLeft + stepLeft * i);
+        out[i * 2 + 1] += in[i] * (gainRight + stepRight * i);
+    }
+}
+
+// Peak absolute value and sum of squares of a buffer, for metering
+inline void peakAndSumSquares(const float* in, int numSamples, float& peak, float& sumSquares) {
+    int i = 0;
+    float maxAbs = 0.0f;
+    float sum = 0.0f;
+
+#if defined(DSP_USE_NEON)
+    float32x4_t vmax = vdupq_n_f32(0.0f);
+    float32x4_t vsum = vdupq_n_f32(0.0f);
+    for (; i + 4 <= numSamples; i += 4) {
+        float32x4_t x = vld1q_f32(in + i);
+        vmax = vmaxq_f32(vmax, vabsq_f32(x));
+        vsum = vmlaq_f32(vsum, x, x);
+    }
+    float lanes[4];
+    vst1q_f32(lanes, vmax);
+    maxAbs = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    maxAbs = maxAbs > lanes[2] ? maxAbs : lanes[2];
+    maxAbs = maxAbs > lanes[3] ? maxAbs : lanes[3];
+    vst1q_f32(lanes, vsum);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#elif defined(DSP_USE_SSE)
+    const __m128 absMask = _mm_castsi128_ps(_mm_set1_epi32(0x7fffffff));
+    __m128 vmax = _mm_setzero_ps();
+    __m128 vsum = _mm_setzero_ps();
+    for (; i + 4 <= numSamples; i += 4) {
+        __m128 x = _mm_loadu_ps(in + i);
+        vmax = _mm_max_ps(vmax, _mm_and_ps(x, absMask));
+        vsum = _mm_add_ps(vsum, _mm_mul_ps(x, x));
+    }
+    float lanes[4];
+    _mm_storeu_ps(lanes, vmax);
+    maxAbs = lanes[0] > lanes[1] ? lanes[0] : lanes[1];
+    maxAbs = maxAbs > lanes[2] ? maxAbs : lanes[2];
+    maxAbs = maxAbs > lanes[3] ? maxAbs : lanes[3];
+    _mm_storeu_ps(lanes, vsum);
+    sum = lanes[0] + lanes[1] + lanes[2] + lanes[3];
+#endif
+
+    for (; i < numSamples; i++) {
+        float a = in[i] < 0.0f ? -in[i] : in[i];
+        maxAbs = a > maxAbs ? a : maxAbs;
+        sum += in[i] * in[i];
+    }
+
+    peak = maxAbs;
+    sumSquares = sum;
+}
+
+} // namespace dsp
+
+#endif // DSP_KERNELS_H
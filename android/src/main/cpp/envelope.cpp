@@ -0,0 +1,166 @@
+#include "envelope.h"
+#include <algorithm>
+#include <cmath>
+
+// Overshoot ratios for exponential segments: the curve aims slightly past its
+// target so it arrives in finite time. A large ratio keeps the attack close to
+// linear; a small one gives decay and release their natural exponential shape.
+static constexpr float ATTACK_TARGET_RATIO = 0.3f;
+static constexpr float DECAY_RELEASE_TARGET_RATIO = 0.001f;
+
+EnvelopeBank::EnvelopeBank() {
+    for (int v = 0; v < CAPACITY; v++) {
+        reset(v);
+    }
+}
+
+void EnvelopeBank::setSampleRate(int sampleRate) {
+    m_sampleRate = std::max(1, sampleRate);
+}
+
+void EnvelopeBank::noteOn(int voice, const EnvelopeParams& params) {
+    m_params[voice] = params;
+    m_params[voice].sustainLevel = std::max(0.0f, std::min(1.0f, params.sustainLevel));
+    startSegment(voice, EnvelopeStage::ATTACK, 1.0f, params.attackMs, params.curve);
+}
+
+void EnvelopeBank::noteOff(int voice) {
+    if (m_stage[voice] == EnvelopeStage::IDLE || m_stage[voice] == EnvelopeStage::RELEASE) {
+        return;
+    }
+    startSegment(voice, EnvelopeStage::RELEASE, 0.0f, m_params[voice].releaseMs, m_params[voice].curve);
+}
+
+void EnvelopeBank::forceRelease(int voice, float timeMs) {
+    if (m_stage[voice] == EnvelopeStage::IDLE) {
+        return;
+    }
+    startSegment(voice, EnvelopeStage::RELEASE, 0.0f, timeMs, EnvelopeCurve::LINEAR);
+}
+
+void EnvelopeBank::reset(int voice) {
+    m_level[voice] = 0.0f;
+    m_blockStart[voice] = 0.0f;
+    m_target[voice] = 0.0f;
+    m_direction[voice] = 0.0f;
+    m_blockMult[voice] = 1.0f;
+    m_blockAdd[voice] = 0.0f;
+    m_sampleCoef[voice] = 1.0f;
+    m_sampleAsymptote[voice] = 0.0f;
+    m_sampleStep[voice] = 0.0f;
+    m_reached[voice] = 0;
+    m_stage[voice] = EnvelopeStage::IDLE;
+    m_params[voice] = EnvelopeParams();
+}
+
+void EnvelopeBank::startSegment(int voice, EnvelopeStage stage, float target, float timeMs, EnvelopeCurve curve) {
+    float start = m_level[voice];
+    float samples = std::max(1.0f, timeMs * 0.001f * static_cast<float>(m_sampleRate));
+
+    m_stage[voice] = stage;
+    m_target[voice] = target;
+    m_direction[voice] = target > start ? 1.0f : (target < start ? -1.0f : 0.0f);
+
+    if (curve == EnvelopeCurve::LINEAR || m_direction[voice] == 0.0f) {
+        m_sampleCoef[voice] = 1.0f;
+        m_sampleAsymptote[voice] = 0.0f;
+        m_sampleStep[voice] = (target - start) / samples;
+        m_blockMult[voice] = 1.0f;
+        m_blockAdd[voice] = m_sampleStep[voice] * BLOCK_SIZE;
+        return;
+    }
+
+    float ratio = stage == EnvelopeStage::ATTACK ? ATTACK_TARGET_RATIO : DECAY_RELEASE_TARGET_RATIO;
+    float range = std::fabs(target - start);
+    float asymptote = target + m_direction[voice] * ratio * range;
+    float coef = std::exp(-std::log((1.0f + ratio) / ratio) / samples);
+
+    m_sampleCoef[voice] = coef;
+    m_sampleAsymptote[voice] = asymptote;
+    m_sampleStep[voice] = 0.0f;
+    m_blockMult[voice] = std::pow(coef, static_cast<float>(BLOCK_SIZE));
+    m_blockAdd[voice] = asymptote * (1.0f - m_blockMult[voice]);
+}
+
+void EnvelopeBank::advanceStage(int voice) {
+    const EnvelopeParams& params = m_params[voice];
+
+    switch (m_stage[voice]) {
+        case EnvelopeStage::ATTACK:
+            startSegment(voice, EnvelopeStage::DECAY, params.sustainLevel, params.decayMs, params.curve);
+            break;
+        case EnvelopeStage::DECAY:
+            m_stage[voice] = EnvelopeStage::SUSTAIN;
+            m_direction[voice] = 0.0f;
+            m_blockMult[voice] = 1.0f;
+            m_blockAdd[voice] = 0.0f;
+            m_sampleCoef[voice] = 1.0f;
+            m_sampleAsymptote[voice] = 0.0f;
+            m_sampleStep[voice] = 0.0f;
+            break;
+        case EnvelopeStage::RELEASE: {
+            // Keep this block's start level so the final ramp down still renders
+            float start = m_blockStart[voice];
+            reset(voice);
+            m_blockStart[voice] = start;
+            break;
+        }
+        default:
+            break;
+    }
+}
+
+void EnvelopeBank::process(int numFrames) {
+    float partialMult[CAPACITY];
+    float partialAdd[CAPACITY];
+    const float* mult = m_blockMult;
+    const float* add = m_blockAdd;
+
+    // Blocks cut short by the end of a buffer or a sample-accurate note event
+    // derive their step from the per-sample terms. coef^n is built by binary
+    // exponentiation over the bits of numFrames (at most BLOCK_SIZE), so each
+    // pass is a plain multiply across all voices rather than a pow per voice.
+    if (numFrames != BLOCK_SIZE) {
+        float power[CAPACITY];
+        for (int v = 0; v < CAPACITY; v++) {
+            partialMult[v] = 1.0f;
+            power[v] = m_sampleCoef[v];
+        }
+        for (int bit = 1; bit <= numFrames; bit <<= 1) {
+            if (numFrames & bit) {
+                for (int v = 0; v < CAPACITY; v++) {
+                    partialMult[v] *= power[v];
+                }
+            }
+            for (int v = 0; v < CAPACITY; v++) {
+                power[v] *= power[v];
+            }
+        }
+
+        float n = static_cast<float>(numFrames);
+        for (int v = 0; v < CAPACITY; v++) {
+            partialAdd[v] = m_sampleAsymptote[v] * (1.0f - partialMult[v]) + m_sampleStep[v] * n;
+        }
+        mult = partialMult;
+        add = partialAdd;
+    }
+
+    // Branch-free update of every voice
+    for (int v = 0; v < CAPACITY; v++) {
+        float current = m_level[v];
+        float next = current * mult[v] + add[v];
+        bool reached = (next - m_target[v]) * m_direction[v] >= 0.0f;
+        m_blockStart[v] = current;
+        m_level[v] = reached ? m_target[v] : next;
+        m_reached[v] = reached ? 1 : 0;
+    }
+
+    // Stage transitions only for voices that finished a segment
+    for (int v = 0; v < CAPACITY; v++) {
+        if (m_reached[v] && (m_stage[v] == EnvelopeStage::ATTACK ||
+                             m_stage[v] == EnvelopeStage::DECAY ||
+                             m_stage[v] == EnvelopeStage::RELEASE)) {
+            advanceStage(v);
+        }
+    }
+}
@@ -0,0 +1,87 @@
+#ifndef ENVELOPE_H
+#define ENVELOPE_H
+
+#include <cstdint>
+
+// Segment shape for envelope stages
+enum class EnvelopeCurve {
+    LINEAR,
+    EXPONENTIAL
+};
+
+// ADSR settings; times are in milliseconds, sustain is a level in [0, 1]
+struct EnvelopeParams {
+    float attackMs = 5.0f;
+    float decayMs = 100.0f;
+    float sustainLevel = 0.8f;
+    float releaseMs = 200.0f;
+    EnvelopeCurve curve = EnvelopeCurve::EXPONENTIAL;
+};
+
+enum class EnvelopeStage : uint8_t {
+    IDLE,
+    ATTACK,
+    DECAY,
+    SUSTAIN,
+    RELEASE
+};
+
+// Block-based ADSR generators for every slot of the voice pool.
+//
+// State is kept as structure-of-arrays so process() advances all voices with
+// one branch-free loop the compiler can vectorize. Each segment is an affine
+// step per control block (level = level * mult + add) clamped at its target;
+// stage changes are handled in a separate scalar pass that only touches voices
+// that reached their target. Callers interpolate between blockStart() and
+// level() to get a per-sample gain ramp.
+class EnvelopeBank {
+public:
+    static constexpr int CAPACITY = 128;
+    static constexpr int BLOCK_SIZE = 32;  // Frames per control block
+
+    EnvelopeBank();
+
+    void setSampleRate(int sampleRate);
+
+    // Start the attack from the current level (0 for a fresh voice)
+    void noteOn(int voice, const EnvelopeParams& params);
+
+    // Enter the release stage with the voice's own release time
+    void noteOff(int voice);
+
+    // Linear release over timeMs, used to fade out stolen voices
+    void forceRelease(int voice, float timeMs);
+
+    // Silence a voice immediately
+    void reset(int voice);
+
+    // Advance every voice by numFrames (at most BLOCK_SIZE)
+    void process(int numFrames);
+
+    float blockStart(int voice) const { return m_blockStart[voice]; }
+    float level(int voice) const { return m_level[voice]; }
+    EnvelopeStage stage(int voice) const { return m_stage[voice]; }
+    bool isIdle(int voice) const { return m_stage[voice] == EnvelopeStage::IDLE; }
+
+private:
+    void startSegment(int voice, EnvelopeStage stage, float target, float timeMs, EnvelopeCurve curve);
+    void advanceStage(int voice);
+
+    int m_sampleRate = 44100;
+
+    // Per-voice state (structure-of-arrays)
+    alignas(16) float m_level[CAPACITY];
+    alignas(16) float m_blockStart[CAPACITY];
+    alignas(16) float m_target[CAPACITY];
+    alignas(16) float m_direction[CAPACITY];   // +1 rising, -1 falling, 0 holding
+    alignas(16) float m_blockMult[CAPACITY];   // Affine step for a full control block
+    alignas(16) float m_blockAdd[CAPACITY];
+    alignas(16) float m_sampleCoef[CAPACITY];  // Per-sample terms for partial blocks
+    alignas(16) float m_sampleAsymptote[CAPACITY];
+    alignas(16) float m_sampleStep[CAPACITY];
+    alignas(16) uint8_t m_reached[CAPACITY];
+    EnvelopeStage m_stage[CAPACITY];
+    EnvelopeParams m_params[CAPACITY];
+};
+
+#endif // ENVELOPE_H
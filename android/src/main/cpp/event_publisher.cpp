@@ -0,0 +1,120 @@
+#include "event_publisher.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include "dart_api_dl.h"
+
+#define LOG_TAG "EventPublisher"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+// Releases a posted batch once Dart has collected its Uint8List
+static void freeBatch(void* /* isolateCallbackData */, void* peer) {
+    std::free(peer);
+}
+
+EventPublisher::EventPublisher()
+    : PortPublisher("event", MAX_RATE_HZ) {
+    m_batch.reserve(QUEUE_CAPACITY);
+}
+
+EventPublisher::~EventPublisher() {
+    stop();
+}
+
+// Drop anything left queued from the previous run
+void EventPublisher::reset() {
+    m_batch.clear();
+    collect(m_audioQueue);
+    collect(m_noteQueue);
+    collect(m_controlQueue);
+    m_batch.clear();
+    m_dropped.store(0, std::memory_order_relaxed);
+}
+
+void EventPublisher::pushAudio(const EngineEvent& event) {
+    if (isRunning() && !m_audioQueue.push(event)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void EventPublisher::pushNote(const EngineEvent& event) {
+    if (isRunning() && !m_noteQueue.push(event)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+void EventPublisher::pushControl(const EngineEvent& event) {
+    if (!isRunning()) {
+        return;
+    }
+    std::lock_guard<std::mutex> lock(m_controlMutex);
+    if (!m_controlQueue.push(event)) {
+        m_dropped.fetch_add(1, std::memory_order_relaxed);
+    }
+}
+
+// Move a queue's events into the batch, keeping only the newest position
+void EventPublisher::collect(SpscQueue<EngineEvent>& queue) {
+    while (const EngineEvent* event = queue.front()) {
+        auto previous = m_batch.end();
+        if (event->type == EngineEvent::POSITION) {
+            previous = std::find_if(m_batch.begin(), m_batch.end(), [](const EngineEvent& e) {
+                return e.type == EngineEvent::POSITION;
+            });
+        }
+        if (previous != m_batch.end()) {
+            *previous = *event;
+        } else {
+            m_batch.push_back(*event);
+        }
+        queue.pop();
+    }
+}
+
+void EventPublisher::publish() {
+    m_batch.clear();
+    collect(m_audioQueue);
+    collect(m_noteQueue);
+    collect(m_controlQueue);
+    if (m_batch.empty()) {
+        return;
+    }
+
+    // Dart takes ownership of the payload and frees it with the Uint8List
+    size_t bytes = m_batch.size() * sizeof(EngineEvent);
+    uint8_t* payload = static_cast<uint8_t*>(std::malloc(bytes));
+    if (!payload) {
+        LOGE("Failed to allocate %zu bytes for an event batch", bytes);
+        return;
+    }
+    std::memcpy(payload, m_batch.data(), bytes);
+
+    Dart_CObject kind;
+    kind.type = Dart_CObject_kString;
+    kind.value.as_string = "events";
+
+    Dart_CObject records;
+    records.type = Dart_CObject_kExternalTypedData;
+    records.value.as_external_typed_data.type = Dart_TypedData_kUint8;
+    records.value.as_external_typed_data.length = static_cast<intptr_t>(bytes);
+    records.value.as_external_typed_data.data = payload;
+    records.value.as_external_typed_data.peer = payload;
+    records.value.as_external_typed_data.callback = freeBatch;
+
+    Dart_CObject* values[] = {&kind, &records};
+    Dart_CObject message;
+    message.type = Dart_CObject_kArray;
+    message.value.as_array.length = 2;
+    message.value.as_array.values = values;
+
+    // On failure the finalizer never runs, so the payload is still ours
+    if (!Dart_PostCObject_DL(dartPort(), &message)) {
+        LOGW("Failed to post %zu engine events to Dart port %lld", m_batch.size(),
+             static_cast<long long>(dartPort()));
+        std::free(payload);
+    }
+}
@@ -0,0 +1,86 @@
+#ifndef EVENT_PUBLISHER_H
+#define EVENT_PUBLISHER_H
+
+#include <atomic>
+#include <cstdint>
+#include <mutex>
+#include <vector>
+#include "port_publisher.h"
+#include "spsc_queue.h"
+
+// Engine event as posted to Dart; 24 bytes, little-endian, layout matches
+// EngineEvent decoding in the Dart FFI layer
+struct EngineEvent {
+    enum Type : uint8_t {
+        NOTE_STARTED = 1,   // id instrument, data1 note, data2 velocity
+        NOTE_ENDED = 2,     // id instrument, data1 note
+        POSITION = 3,       // id sequence, value beat
+        LOOP_WRAPPED = 4,   // id sequence, value loop start beat
+        LOAD_PROGRESS = 5,  // id instrument or sequence once known (else -1), data1 LoadKind, value 0-1
+        UNDERRUN = 6        // value milliseconds the callback was late
+    };
+    enum LoadKind : uint8_t {
+        LOAD_INSTRUMENT = 0,
+        LOAD_MIDI_FILE = 1,
+        LOAD_PROJECT = 2
+    };
+
+    int64_t frame;   // Render frame it takes effect at; -1 if not tied to one
+    double value;
+    int32_t id;
+    uint8_t type;
+    uint8_t data1;
+    uint8_t data2;
+    uint8_t reserved;
+};
+
+static_assert(sizeof(EngineEvent) == 24, "EngineEvent layout is shared with Dart");
+
+// Collects engine events from the audio thread and control threads through
+// lock-free queues and posts them to a Dart port in batches from a
+// PortPublisher thread. Each batch is one message carrying every event since the previous
+// one as an external typed-data payload (freed by Dart's finalizer), with
+// position updates coalesced to the latest, so message count stays at the
+// publish rate however dense the sequence. Events are only collected while
+// running; a full queue drops events rather than blocking.
+//
+// Message layout: ["events", Uint8List records]
+class EventPublisher : public PortPublisher {
+public:
+    static constexpr int DEFAULT_RATE_HZ = 60;
+    static constexpr int MAX_RATE_HZ = 240;
+
+    EventPublisher();
+    ~EventPublisher() override;
+
+    // Audio thread only (under AudioEngine's audio lock)
+    void pushAudio(const EngineEvent& event);
+
+    // Note events; the caller holds the instrument manager's lock, which is
+    // what keeps that queue single-producer
+    void pushNote(const EngineEvent& event);
+
+    // Any other thread
+    void pushControl(const EngineEvent& event);
+
+    // Events lost to full queues since start
+    uint64_t droppedEvents() const { return m_dropped.load(std::memory_order_relaxed); }
+
+private:
+    void publish() override;
+    void reset() override;
+    void collect(SpscQueue<EngineEvent>& queue);
+
+    static constexpr size_t QUEUE_CAPACITY = 4096;
+
+    SpscQueue<EngineEvent> m_audioQueue{QUEUE_CAPACITY};
+    SpscQueue<EngineEvent> m_noteQueue{QUEUE_CAPACITY};
+    SpscQueue<EngineEvent> m_controlQueue{QUEUE_CAPACITY};
+    std::mutex m_controlMutex;  // Serializes pushControl producers
+    std::atomic<uint64_t> m_dropped{0};
+
+    // Batch being assembled, reused between posts
+    std::vector<EngineEvent> m_batch;
+};
+
+#endif // EVENT_PUBLISHER_H
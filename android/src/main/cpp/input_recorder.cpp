@@ -0,0 +1,411 @@
+#include "input_recorder.h"
+#include <android/log.h>
+#include <algorithm>
+#include <cerrno>
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+#include <cstring>
+#include <fcntl.h>
+#include <unistd.h>
+
+#define LOG_TAG "InputRecorder"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+static void recorderCallback(SLAndroidSimpleBufferQueueItf /* bq */, void* context) {
+    static_cast<InputRecorder*>(context)->onBufferCaptured();
+}
+
+// Little-endian field writers for the WAV header
+static void putTag(uint8_t* at, const char* tag) {
+    std::memcpy(at, tag, 4);
+}
+
+static void putU16(uint8_t* at, uint16_t value) {
+    at[0] = static_cast<uint8_t>(value);
+    at[1] = static_cast<uint8_t>(value >> 8);
+}
+
+static void putU32(uint8_t* at, uint32_t value) {
+    for (int i = 0; i < 4; i++) {
+        at[i] = static_cast<uint8_t>(value >> (8 * i));
+    }
+}
+
+InputRecorder::InputRecorder(SLEngineItf engine, int sampleRate, const AudioClock& clock)
+    : m_engine(engine)
+    , m_sampleRate(std::max(1, sampleRate))
+    , m_clock(clock)
+{
+}
+
+InputRecorder::~InputRecorder() {
+    stop();
+    delete[] m_ring;
+    std::free(m_staging);
+}
+
+bool InputRecorder::start(const std::string& path, int channels, float latencyMs) {
+    LOGI("Starting recording to %s (%d channels)", path.c_str(), channels);
+    try {
+        if (m_recording.load()) {
+            LOGE("Already recording");
+            return false;
+        }
+        if (!m_engine) {
+            LOGE("No OpenSL engine to record with");
+            return false;
+        }
+
+        m_channels = std::max(1, std::min(MAX_CHANNELS, channels));
+        m_latencyFrames = latencyMs > 0.0f ? static_cast<int64_t>(latencyMs * m_sampleRate / 1000.0f) : 0;
+        m_aligned = false;
+        m_failed.store(false);
+        m_framesWritten.store(0);
+        m_framesDropped.store(0);
+        m_startFrame.store(-1);
+        m_startBeat.store(0.0);
+        m_sequenceId.store(-1);
+
+        // Enough ring for the writer to ride out a slow storage device
+        size_t ringSamples = 1;
+        while (ringSamples < static_cast<size_t>(m_sampleRate) * RING_SECONDS * m_channels) {
+            ringSamples <<= 1;
+        }
+        if (m_ringMask + 1 != ringSamples) {
+            delete[] m_ring;
+            m_ring = new int16_t[ringSamples];
+            m_ringMask = ringSamples - 1;
+        }
+        m_ringWrite.store(0);
+        m_ringRead.store(0);
+
+        if (!m_staging) {
+            void* memory = nullptr;
+            if (posix_memalign(&memory, HEADER_BYTES, WRITE_CHUNK_BYTES) != 0) {
+                LOGE("Failed to allocate the write buffer");
+                return false;
+            }
+            m_staging = static_cast<uint8_t*>(memory);
+        }
+        m_stagingUsed = 0;
+        m_dataBytes = 0;
+
+        m_fd = ::open(path.c_str(), O_WRONLY | O_CREAT | O_TRUNC | O_CLOEXEC, 0644);
+        if (m_fd < 0) {
+            LOGE("Cannot open %s for recording: %s", path.c_str(), strerror(errno));
+            return false;
+        }
+        if (!writeHeader(0) || !createRecorder()) {
+            destroyRecorder();
+            close(m_fd);
+            m_fd = -1;
+            return false;
+        }
+
+        m_recording.store(true);
+        m_writer = std::thread(&InputRecorder::run, this);
+
+        SLresult result = (*m_recorder)->SetRecordState(m_recorder, SL_RECORDSTATE_RECORDING);
+        if (result != SL_RESULT_SUCCESS) {
+            LOGE("Failed to start recording: %d", result);
+            m_failed.store(true);
+            stop();
+            return false;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in InputRecorder::start: %s", e.what());
+        return false;
+    }
+}
+
+bool InputRecorder::stop() {
+    if (!m_recording.load()) {
+        return false;
+    }
+
+    // Once the recorder is destroyed its callback can no longer run, so the
+    // writer's final drain sees every captured frame
+    if (m_recorder) {
+        (*m_recorder)->SetRecordState(m_recorder, SL_RECORDSTATE_STOPPED);
+    }
+    destroyRecorder();
+
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_recording.store(false);
+    }
+    m_wakeup.notify_all();
+    if (m_writer.joinable()) {
+        m_writer.join();
+    }
+
+    // The tail is shorter than a chunk, so it's the one unaligned write
+    if (m_stagingUsed > 0) {
+        flush(m_stagingUsed);
+        m_stagingUsed = 0;
+    }
+    bool finished = writeHeader(m_dataBytes) && fdatasync(m_fd) == 0;
+    if (close(m_fd) != 0) {
+        finished = false;
+    }
+    m_fd = -1;
+    if (!finished) {
+        fail("finish the file");
+    }
+
+    LOGI("Recording stopped: %lld frames written, %lld dropped",
+         static_cast<long long>(m_framesWritten.load()), static_cast<long long>(m_framesDropped.load()));
+    return finished && !m_failed.load();
+}
+
+RecordingStatus InputRecorder::getStatus() const {
+    RecordingStatus status;
+    status.framesWritten = m_framesWritten.load(std::memory_order_relaxed);
+    status.framesDropped = m_framesDropped.load(std::memory_order_relaxed);
+    status.startFrame = m_startFrame.load(std::memory_order_relaxed);
+    status.startBeat = m_startBeat.load(std::memory_order_relaxed);
+    status.sequenceId = m_sequenceId.load(std::memory_order_relaxed);
+    status.state = m_failed.load() ? RecordingStatus::FAILED
+                 : m_recording.load() ? RecordingStatus::RECORDING
+                 : RecordingStatus::IDLE;
+    return status;
+}
+
+bool InputRecorder::createRecorder() {
+    SLDataLocator_IODevice loc_dev = {
+        SL_DATALOCATOR_IODEVICE,
+        SL_IODEVICE_AUDIOINPUT,
+        SL_DEFAULTDEVICEID_AUDIOINPUT,
+        nullptr
+    };
+    SLDataSource audioSrc = {&loc_dev, nullptr};
+
+    SLDataLocator_AndroidSimpleBufferQueue loc_bufq = {
+        SL_DATALOCATOR_ANDROIDSIMPLEBUFFERQUEUE,
+        BUFFER_COUNT
+    };
+
+    // Captured at the engine's rate so recorded frames map 1:1 onto render frames
+    SLDataFormat_PCM format_pcm = {
+        SL_DATAFORMAT_PCM,
+        static_cast<SLuint32>(m_channels),
+        static_cast<SLuint32>(m_sampleRate * 1000),
+        SL_PCMSAMPLEFORMAT_FIXED_16,
+        SL_PCMSAMPLEFORMAT_FIXED_16,
+        m_channels == 2 ? static_cast<SLuint32>(SL_SPEAKER_FRONT_LEFT | SL_SPEAKER_FRONT_RIGHT)
+                        : static_cast<SLuint32>(SL_SPEAKER_FRONT_CENTER),
+        SL_BYTEORDER_LITTLEENDIAN
+    };
+    SLDataSink audioSnk = {&loc_bufq, &format_pcm};
+
+    const SLInterfaceID ids[] = {SL_IID_ANDROIDSIMPLEBUFFERQUEUE};
+    const SLboolean req[] = {SL_BOOLEAN_TRUE};
+
+    SLresult result = (*m_engine)->CreateAudioRecorder(m_engine, &m_recorderObj, &audioSrc, &audioSnk, 1, ids, req);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to create audio recorder (is RECORD_AUDIO granted?): %d", result);
+        m_recorderObj = nullptr;
+        return false;
+    }
+
+    result = (*m_recorderObj)->Realize(m_recorderObj, SL_BOOLEAN_FALSE);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to realize audio recorder: %d", result);
+        return false;
+    }
+
+    result = (*m_recorderObj)->GetInterface(m_recorderObj, SL_IID_RECORD, &m_recorder);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to get record interface: %d", result);
+        return false;
+    }
+
+    result = (*m_recorderObj)->GetInterface(m_recorderObj, SL_IID_ANDROIDSIMPLEBUFFERQUEUE, &m_bufferQueue);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to get recorder buffer queue interface: %d", result);
+        return false;
+    }
+
+    result = (*m_bufferQueue)->RegisterCallback(m_bufferQueue, recorderCallback, this);
+    if (result != SL_RESULT_SUCCESS) {
+        LOGE("Failed to register recorder callback: %d", result);
+        return false;
+    }
+
+    // Queue every capture buffer; each is re-enqueued as soon as it's copied out
+    int bufferSamples = FRAMES_PER_BUFFER * m_channels;
+    m_nextBuffer = 0;
+    for (int i = 0; i < BUFFER_COUNT; i++) {
+        m_captureBuffers[i] = new int16_t[bufferSamples];
+        result = (*m_bufferQueue)->Enqueue(m_bufferQueue, m_captureBuffers[i], bufferSamples * sizeof(int16_t));
+        if (result != SL_RESULT_SUCCESS) {
+            LOGE("Failed to enqueue capture buffer: %d", result);
+            return false;
+        }
+    }
+    return true;
+}
+
+void InputRecorder::destroyRecorder() {
+    if (m_recorderObj) {
+        (*m_recorderObj)->Destroy(m_recorderObj);
+        m_recorderObj = nullptr;
+        m_recorder = nullptr;
+        m_bufferQueue = nullptr;
+    }
+    for (auto& buffer : m_captureBuffers) {
+        delete[] buffer;
+        buffer = nullptr;
+    }
+}
+
+void InputRecorder::onBufferCaptured() {
+    int64_t now = AudioClock::hostTimeNanos();
+    if (!m_aligned) {
+        m_aligned = true;
+        align(now - static_cast<int64_t>(FRAMES_PER_BUFFER) * 1000000000LL / m_sampleRate);
+    }
+
+    // Whole buffers only, so frames never split; a full ring drops the buffer
+    int16_t* buffer = m_captureBuffers[m_nextBuffer];
+    size_t samples = static_cast<size_t>(FRAMES_PER_BUFFER) * m_channels;
+    if (ringWrite(buffer, samples) < samples) {
+        m_framesDropped.fetch_add(FRAMES_PER_BUFFER, std::memory_order_relaxed);
+    }
+
+    (*m_bufferQueue)->Enqueue(m_bufferQueue, buffer, samples * sizeof(int16_t));
+    m_nextBuffer = (m_nextBuffer + 1) % BUFFER_COUNT;
+}
+
+// Place the first captured frame on the render timeline. The clock says which
+// render frame started playing at its host time; the frame heard at the
+// capture time is that plus the elapsed frames, and the performer was
+// playing along with it one round-trip latency earlier.
+void InputRecorder::align(int64_t captureNanos) {
+    AudioClock::Snapshot clock;
+    if (!m_clock.read(clock) || clock.sampleRate <= 0) {
+        LOGW("Output clock not running, recording won't be aligned");
+        return;
+    }
+    double seconds = static_cast<double>(captureNanos - clock.hostTimeNanos) / 1e9 -
+                     static_cast<double>(m_latencyFrames) / m_sampleRate;
+    m_startBeat.store(clock.beat + clock.beatsPerSecond * seconds, std::memory_order_relaxed);
+    m_sequenceId.store(clock.playing ? clock.sequenceId : -1, std::memory_order_relaxed);
+    m_startFrame.store(clock.frame + std::llround(seconds * clock.sampleRate), std::memory_order_relaxed);
+}
+
+size_t InputRecorder::ringWrite(const int16_t* samples, size_t count) {
+    size_t write = m_ringWrite.load(std::memory_order_relaxed);
+    size_t read = m_ringRead.load(std::memory_order_acquire);
+    if (m_ringMask + 1 - (write - read) < count) {
+        return 0;
+    }
+    size_t offset = write & m_ringMask;
+    size_t first = std::min(count, m_ringMask + 1 - offset);
+    std::memcpy(m_ring + offset, samples, first * sizeof(int16_t));
+    std::memcpy(m_ring, samples + first, (count - first) * sizeof(int16_t));
+    m_ringWrite.store(write + count, std::memory_order_release);
+    return count;
+}
+
+size_t InputRecorder::ringRead(int16_t* samples, size_t count) {
+    size_t read = m_ringRead.load(std::memory_order_relaxed);
+    size_t write = m_ringWrite.load(std::memory_order_acquire);
+    count = std::min(count, write - read);
+    size_t offset = read & m_ringMask;
+    size_t first = std::min(count, m_ringMask + 1 - offset);
+    std::memcpy(samples, m_ring + offset, first * sizeof(int16_t));
+    std::memcpy(samples + first, m_ring, (count - first) * sizeof(int16_t));
+    m_ringRead.store(read + count, std::memory_order_release);
+    return count;
+}
+
+void InputRecorder::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_recording.load()) {
+        m_wakeup.wait_for(lock, std::chrono::milliseconds(WRITER_INTERVAL_MS),
+                          [this] { return !m_recording.load(); });
+        drain();
+    }
+    drain();
+}
+
+// Move everything captured into the staging buffer, writing each chunk as it
+// fills. Chunks hold whole frames because the ring only holds whole buffers.
+size_t InputRecorder::drain() {
+    size_t total = 0;
+    while (true) {
+        size_t space = (WRITE_CHUNK_BYTES - m_stagingUsed) / sizeof(int16_t);
+        size_t count = ringRead(reinterpret_cast<int16_t*>(m_staging + m_stagingUsed), space);
+        if (count == 0) {
+            return total;
+        }
+        total += count;
+        m_stagingUsed += count * sizeof(int16_t);
+        if (m_stagingUsed == WRITE_CHUNK_BYTES) {
+            flush(WRITE_CHUNK_BYTES);
+            m_stagingUsed = 0;
+        }
+    }
+}
+
+bool InputRecorder::flush(size_t bytes) {
+    if (m_failed.load()) {
+        return false;  // Keep draining so capture runs on, but stop writing
+    }
+    off_t offset = static_cast<off_t>(HEADER_BYTES + m_dataBytes);
+    for (size_t done = 0; done < bytes;) {
+        ssize_t written = pwrite(m_fd, m_staging + done, bytes - done, offset + static_cast<off_t>(done));
+        if (written < 0 && errno == EINTR) {
+            continue;
+        }
+        if (written <= 0) {
+            fail("write samples");
+            return false;
+        }
+        done += static_cast<size_t>(written);
+    }
+    m_dataBytes += bytes;
+    m_framesWritten.store(static_cast<int64_t>(m_dataBytes / (sizeof(int16_t) * m_channels)),
+                          std::memory_order_relaxed);
+    return true;
+}
+
+// 16-bit PCM WAV header, padded with a JUNK chunk to HEADER_BYTES
+bool InputRecorder::writeHeader(uint64_t dataBytes) {
+    uint8_t header[HEADER_BYTES] = {};
+    uint32_t dataSize = static_cast<uint32_t>(std::min<uint64_t>(dataBytes, 0xFFFFFFFFu - HEADER_BYTES));
+    uint16_t blockAlign = static_cast<uint16_t>(m_channels * sizeof(int16_t));
+
+    putTag(header, "RIFF");
+    putU32(header + 4, static_cast<uint32_t>(HEADER_BYTES - 8) + dataSize);
+    putTag(header + 8, "WAVE");
+    putTag(header + 12, "fmt ");
+    putU32(header + 16, 16);
+    putU16(header + 20, 1);  // PCM
+    putU16(header + 22, static_cast<uint16_t>(m_channels));
+    putU32(header + 24, static_cast<uint32_t>(m_sampleRate));
+    putU32(header + 28, static_cast<uint32_t>(m_sampleRate) * blockAlign);
+    putU16(header + 32, blockAlign);
+    putU16(header + 34, 16);
+    putTag(header + 36, "JUNK");
+    putU32(header + 40, static_cast<uint32_t>(HEADER_BYTES - 52));
+    putTag(header + HEADER_BYTES - 8, "data");
+    putU32(header + HEADER_BYTES - 4, dataSize);
+
+    if (pwrite(m_fd, header, HEADER_BYTES, 0) != static_cast<ssize_t>(HEADER_BYTES)) {
+        LOGE("Failed to write WAV header: %s", strerror(errno));
+        return false;
+    }
+    return true;
+}
+
+void InputRecorder::fail(const char* what) {
+    LOGE("Recording failed to %s: %s", what, strerror(errno));
+    m_failed.store(true);
+}
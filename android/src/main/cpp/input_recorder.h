@@ -0,0 +1,132 @@
+#ifndef INPUT_RECORDER_H
+#define INPUT_RECORDER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <thread>
+#include <SLES/OpenSLES.h>
+#include <SLES/OpenSLES_Android.h>
+#include "audio_clock.h"
+
+// Recording state as reported to Dart; the layout matches RecordingStatus in
+// the Dart FFI layer
+struct RecordingStatus {
+    enum State : int32_t {
+        IDLE = 0,
+        RECORDING = 1,
+        FAILED = 2  // Capture or a disk write failed; what was written is kept
+    };
+
+    int64_t framesWritten;  // Frames on disk so far
+    int64_t framesDropped;  // Frames lost because the writer fell behind
+    int64_t startFrame;     // Render frame the file's first frame lines up with, -1 until known
+    double startBeat;       // Transport beat at that frame, if a sequence was playing
+    int32_t sequenceId;     // Sequence playing when recording began, or -1
+    int32_t state;
+};
+
+static_assert(sizeof(RecordingStatus) == 40, "RecordingStatus layout is shared with Dart");
+
+// Records the default audio input to a 16-bit PCM WAV file.
+//
+// An OpenSL recorder delivers buffers on its own callback thread, which only
+// copies them into a lock-free ring and re-enqueues; a writer thread drains
+// the ring into an aligned staging buffer and writes it out in large chunks,
+// so neither the capture callback nor the render thread ever touches the
+// disk. The WAV header is padded to one page so the sample data, and every
+// chunk write, starts on a page boundary; the RIFF sizes are patched when
+// recording stops.
+//
+// The first captured frame is placed on the render timeline through the
+// shared AudioClock: its capture time is mapped onto the render frame counter
+// and transport beat, less the round-trip latency the caller measured, so the
+// take can be laid against the sequence that was playing.
+class InputRecorder {
+public:
+    static constexpr int MAX_CHANNELS = 2;
+
+    InputRecorder(SLEngineItf engine, int sampleRate, const AudioClock& clock);
+    ~InputRecorder();
+
+    InputRecorder(const InputRecorder&) = delete;
+    InputRecorder& operator=(const InputRecorder&) = delete;
+
+    // Start capturing channels (1 or 2) into a new file at path.
+    // latencyMs is the measured output-plus-input latency to compensate for.
+    bool start(const std::string& path, int channels, float latencyMs);
+
+    // Stop capturing, flush what's left and finish the file
+    bool stop();
+
+    bool isRecording() const { return m_recording.load(); }
+    RecordingStatus getStatus() const;
+
+    // OpenSL capture callback
+    void onBufferCaptured();
+
+private:
+    static constexpr int BUFFER_COUNT = 2;
+    static constexpr int FRAMES_PER_BUFFER = 256;
+    static constexpr size_t WRITE_CHUNK_BYTES = 64 * 1024;
+    static constexpr size_t HEADER_BYTES = 4096;  // Data starts on a page boundary
+    static constexpr int RING_SECONDS = 4;
+    static constexpr int WRITER_INTERVAL_MS = 20;
+
+    bool createRecorder();
+    void destroyRecorder();
+    void align(int64_t captureNanos);
+
+    void run();
+    size_t drain();
+    bool flush(size_t bytes);
+    bool writeHeader(uint64_t dataBytes);
+    void fail(const char* what);
+
+    // Ring between the capture callback (producer) and the writer (consumer)
+    size_t ringWrite(const int16_t* samples, size_t count);
+    size_t ringRead(int16_t* samples, size_t count);
+
+    SLEngineItf m_engine;
+    int m_sampleRate;
+    const AudioClock& m_clock;
+
+    // OpenSL recorder, created for each take
+    SLObjectItf m_recorderObj = nullptr;
+    SLRecordItf m_recorder = nullptr;
+    SLAndroidSimpleBufferQueueItf m_bufferQueue = nullptr;
+    int16_t* m_captureBuffers[BUFFER_COUNT] = {nullptr};
+    int m_nextBuffer = 0;  // Oldest buffer still queued with the recorder
+
+    int m_channels = 1;
+    int64_t m_latencyFrames = 0;
+    bool m_aligned = false;  // Callback thread: start position worked out
+
+    // Sample ring; sized when recording starts, before the callback runs
+    int16_t* m_ring = nullptr;
+    size_t m_ringMask = 0;
+    alignas(64) std::atomic<size_t> m_ringWrite{0};
+    alignas(64) std::atomic<size_t> m_ringRead{0};
+
+    // Writer thread state
+    int m_fd = -1;
+    uint8_t* m_staging = nullptr;  // Page-aligned, WRITE_CHUNK_BYTES
+    size_t m_stagingUsed = 0;
+    uint64_t m_dataBytes = 0;
+    std::thread m_writer;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+
+    // Shared status
+    std::atomic<bool> m_recording{false};
+    std::atomic<bool> m_failed{false};
+    std::atomic<int64_t> m_framesWritten{0};
+    std::atomic<int64_t> m_framesDropped{0};
+    std::atomic<int64_t> m_startFrame{-1};
+    std::atomic<double> m_startBeat{0.0};
+    std::atomic<int32_t> m_sequenceId{-1};
+};
+
+#endif // INPUT_RECORDER_H
@@ -1,5 +1,6 @@
 #include "instrument_manager.h"
 #include "audio_engine.h"
+#include "event_publisher.h"
 #include <android/log.h>
 #include <vector>
 #include <string>
@@ -24,12 +25,6 @@
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
-// Constants for safety
-#define MAX_INSTRUMENTS 32
-#define MAX_NOTES 128
-#define MIN_SAMPLE_RATE 8000
-#define MAX_SAMPLE_RATE 192000
-
 // Constructor
 InstrumentManager::InstrumentManager() :
     m_audioEngine(nullptr),
@@ -66,6 +61,8 @@ bool InstrumentManager::init() {
             m_sampleRate = 44100; // Default sample rate
             LOGI("AudioEngine not available, using default sample rate: %d", m_sampleRate);
         }
+        m_envelopes.setSampleRate(m_sampleRate);
+        m_mixer.setSampleRate(m_sampleRate);
         
         LOGI("InstrumentManager initialized successfully");
         return true;
@@ -89,6 +86,12 @@ int InstrumentManager::createSineWaveInstrument(const std::string& name) {
         
         std::lock_guard<std::mutex> lock(m_mutex);
         
+        if (static_cast<int>(m_instruments.size()) >= MAX_INSTRUMENTS) {
+            LOGE("Cannot create instrument '%s': limit of %d instruments reached",
+                 name.c_str(), MAX_INSTRUMENTS);
+            return -1;
+        }
+        
         // Generate a unique ID for the instrument
         int instrumentId = generateUniqueId();
         LOGI("Generated instrument ID: %d", instrumentId);
@@ -100,11 +103,6 @@ int InstrumentManager::createSineWaveInstrument(const std::string& name) {
         instrument.name = name;
         instrument.volume = 1.0f;
         
-        // Initialize note tracking maps for this instrument
-        m_activeNotes[instrumentId] = std::set<int>();
-        m_noteVelocities[instrumentId] = std::map<int, int>();
-        m_notePhases[instrumentId] = std::map<int, float>();
-        
         // Always create ID 0 as a special "default" instrument if it doesn't exist
         if (instrumentId != 0 && m_instruments.find(0) == m_instruments.end()) {
             LOGI("Creating default sine wave instrument with ID 0");
@@ -112,10 +110,6 @@ int InstrumentManager::createSineWaveInstrument(const std::string& name) {
             defaultInstrument.type = InstrumentType::SINE_WAVE;
             defaultInstrument.name = "Default Sine Wave";
             defaultInstrument.volume = 1.0f;
-            
-            m_activeNotes[0] = std::set<int>();
-            m_noteVelocities[0] = std::map<int, int>();
-            m_notePhases[0] = std::map<int, float>();
         }
         
         LOGI("Successfully created sine wave instrument '%s' with ID: %d", 
@@ -143,10 +137,13 @@ bool InstrumentManager::unloadInstrument(int instrumentId) {
             return false;
         }
         
-        // First, clear all active notes for this instrument
-        m_activeNotes.erase(instrumentId);
-        m_noteVelocities.erase(instrumentId);
-        m_notePhases.erase(instrumentId);
+        // First, silence all voices owned by this instrument
+        for (int i = 0; i < MAX_VOICES; i++) {
+            if (m_voices[i].active && m_voices[i].instrumentId == instrumentId) {
+                m_voices[i].active = false;
+                m_envelopes.reset(i);
+            }
+        }
         
         // Then remove the instrument
         m_instruments.erase(it);
@@ -196,115 +193,132 @@ void InstrumentManager::renderAudio(float* buffer, int numFrames, float masterVo
             buffer[i] = 0.0f;
         }
         
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        // Live events are timed against this counter, which advances even
+        // while silent; the block covers the frames up to its new value
+        int64_t blockStart = m_renderedFrames.load(std::memory_order_relaxed);
+        m_renderedFrames.store(blockStart + numFrames, std::memory_order_release);
+        
         // Only process if we have instruments loaded
         if (m_instruments.empty()) {
             LOGD("No instruments loaded, skipping audio rendering");
+            m_mixer.commitTaps(numFrames, blockStart);
             return;
         }
         
-        std::lock_guard<std::mutex> lock(m_mutex);
-        
-        // Check if we have active notes
-        bool hasActiveNotes = false;
-        int totalActiveNotes = 0;
-        
-        for (const auto& [instrumentId, notes] : m_activeNotes) {
-            if (!notes.empty()) {
-                hasActiveNotes = true;
-                totalActiveNotes += notes.size();
+        // Count sounding voices; the pool size bounds the work done below
+        int totalActiveVoices = 0;
+        for (const auto& voice : m_voices) {
+            if (voice.active && !voice.stealing) {
+                totalActiveVoices++;
             }
         }
         
-        if (!hasActiveNotes) {
-            // No active notes to render
-            return;
-        }
-        
-        LOGD("Rendering %d active notes across all instruments", totalActiveNotes);
+        // Calculate base amplitude - reduce as more voices are active
+        float baseAmplitude = 0.3f / std::sqrt(static_cast<float>(std::max(1, totalActiveVoices)));
         
-        for (const auto& [instrumentId, notes] : m_activeNotes) {
-            if (notes.empty()) {
+        // Resolve per-voice amplitude once per buffer
+        float voiceAmplitude[MAX_VOICES];
+        for (int v = 0; v < MAX_VOICES; v++) {
+            Voice& voice = m_voices[v];
+            voiceAmplitude[v] = 0.0f;
+            if (!voice.active) {
                 continue;
             }
             
-            // Get the instrument
-            auto instrumentIt = m_instruments.find(instrumentId);
+            auto instrumentIt = m_instruments.find(voice.instrumentId);
             if (instrumentIt == m_instruments.end()) {
-                LOGW("Instrument ID %d not found for active notes", instrumentId);
-                continue; // Skip if instrument doesn't exist
+                LOGW("Instrument ID %d not found for active voice", voice.instrumentId);
+                voice.active = false;
+                m_envelopes.reset(v);
+                continue;
             }
             
-            const auto& instrument = instrumentIt->second;
-            LOGD("Processing instrument %d (%s) with %zu active notes", 
-                instrumentId, instrument.name.c_str(), notes.size());
-            
-            // Calculate base amplitude - reduce as more notes are active
-            float baseAmplitude = 0.3f / std::sqrt(static_cast<float>(notes.size()));
+            // Apply instrument volume, velocity scaling and master volume
+            voiceAmplitude[v] = baseAmplitude * instrumentIt->second.volume *
+                                (static_cast<float>(voice.velocity) / 127.0f) * masterVolume;
+        }
+        
+        // Advance all envelopes one control block at a time, render each voice
+        // into its mixer bus with a linear gain ramp, then mix the buses.
+        // Delayed starts and releases end a control block early so they take
+        // effect on their exact frame.
+        for (int offset = 0, blockFrames = 0; offset < numFrames; offset += blockFrames) {
+            blockFrames = std::min(EnvelopeBank::BLOCK_SIZE, numFrames - offset);
+            for (int v = 0; v < MAX_VOICES; v++) {
+                Voice& voice = m_voices[v];
+                if (!voice.active) {
+                    continue;
+                }
+                if (voice.startDelay == offset) {
+                    voice.startDelay = -1;
+                    m_envelopes.noteOn(v, m_instruments[voice.instrumentId].envelope);
+                } else if (voice.startDelay > offset) {
+                    blockFrames = std::min(blockFrames, voice.startDelay - offset);
+                }
+                if (voice.releaseDelay == offset) {
+                    voice.releaseDelay = -1;
+                    voice.released = true;
+                    m_envelopes.noteOff(v);
+                } else if (voice.releaseDelay > offset) {
+                    blockFrames = std::min(blockFrames, voice.releaseDelay - offset);
+                }
+            }
+            m_envelopes.process(blockFrames);
             
-            // Apply instrument volume
-            baseAmplitude *= instrument.volume;
+            float* out = buffer + offset * 2;
             
-            // Generate sine waves for each note
-            for (int note : notes) {
-                // Calculate frequency based on MIDI note number
-                float frequency = midiNoteToFrequency(note);
-                
-                // Get velocity for this note
-                int velocity = 64; // Default mid-velocity if not specified
-                if (m_noteVelocities.find(instrumentId) != m_noteVelocities.end() &&
-                    m_noteVelocities[instrumentId].find(note) != m_noteVelocities[instrumentId].end()) {
-                    velocity = m_noteVelocities[instrumentId][note];
+            for (int v = 0; v < MAX_VOICES; v++) {
+                Voice& voice = m_voices[v];
+                if (!voice.active || voice.startDelay >= 0) {
+                    continue;
                 }
                 
-                // Get or initialize phase for this note
-                if (m_notePhases[instrumentId].find(note) == m_notePhases[instrumentId].end()) {
-                    m_notePhases[instrumentId][note] = 0.0f;
-                }
-                float& phase = m_notePhases[instrumentId][note];
-                
-                // Apply velocity scaling
-                float amplitude = baseAmplitude * (static_cast<float>(velocity) / 127.0f);
-                
-                // Apply master volume
-                amplitude *= masterVolume;
+                float gain = voiceAmplitude[v] * m_envelopes.blockStart(v);
+                float gainStep = (voiceAmplitude[v] * m_envelopes.level(v) - gain) / blockFrames;
+                float phase = voice.phase;
+                float* busOut = m_mixer.busBuffer(voice.bus, blockFrames);
                 
-                LOGD("  Note %d: freq=%.2f Hz, vel=%d, amp=%.4f", 
-                     note, frequency, velocity, amplitude);
-                
-                // Generate sine wave for this note
-                for (int i = 0; i < numFrames; i++) {
-                    float sample = amplitude * std::sin(phase);
+                // Generate sine wave for this voice
+                for (int i = 0; i < blockFrames; i++) {
+                    busOut[i] += gain * std::sin(phase);
                     
-                    // Mix into output buffer (stereo)
-                    buffer[i * 2] += sample;       // Left channel
-                    buffer[i * 2 + 1] += sample;   // Right channel
+                    gain += gainStep;
                     
                     // Update phase
-                    phase += 2.0f * M_PI * frequency / m_sampleRate;
+                    phase += voice.phaseIncrement;
                     
                     // Keep phase in the range [0, 2π]
                     if (phase >= 2.0f * M_PI) {
                         phase -= 2.0f * M_PI;
                     }
                 }
+                
+                voice.phase = phase;
+                
+                // Free the slot once the release tail (or steal fade) is silent
+                if (m_envelopes.isIdle(v)) {
+                    voice.active = false;
+                }
             }
+            
+            m_mixer.mixBlock(out, blockFrames);
         }
         
-        // Apply soft limiting to prevent clipping
-        for (int i = 0; i < numFrames * 2; i++) {
-            // Soft clipping using tanh
-            buffer[i] = std::tanh(buffer[i]);
-        }
-        
-        // Check for actual sound output
-        float maxSample = 0.0f;
-        for (int i = 0; i < numFrames * 2; i++) {
-            maxSample = std::max(maxSample, std::abs(buffer[i]));
+        // Events delayed past this buffer carry over into the next
+        for (auto& voice : m_voices) {
+            if (voice.startDelay >= 0) {
+                voice.startDelay -= numFrames;
+            }
+            if (voice.releaseDelay >= 0) {
+                voice.releaseDelay -= numFrames;
+            }
         }
         
-        if (maxSample > 0.01f) {
-            LOGD("Generated audio with max amplitude: %.4f", maxSample);
-        }
+        // Publish this callback's track levels and tap blocks
+        m_mixer.publishMeters(numFrames);
+        m_mixer.commitTaps(numFrames, blockStart);
     } catch (const std::exception& e) {
         LOGE("Exception in renderAudio: %s", e.what());
     } catch (...) {
@@ -312,52 +326,147 @@ void InstrumentManager::renderAudio(float* buffer, int numFrames, float masterVo
     }
 }
 
-// Send note on event
-bool InstrumentManager::sendNoteOn(int instrumentId, int noteNumber, int velocity) {
-    LOGD("Note On: instrument=%d, note=%d, velocity=%d", instrumentId, noteNumber, velocity);
+// Current output level of a voice, used by the QUIETEST policy
+float InstrumentManager::voiceLevel(const Voice& voice) const {
+    float volume = 1.0f;
+    auto it = m_instruments.find(voice.instrumentId);
+    if (it != m_instruments.end()) {
+        volume = it->second.volume;
+    }
+    int slot = static_cast<int>(&voice - m_voices);
+    return volume * (static_cast<float>(voice.velocity) / 127.0f) * m_envelopes.level(slot);
+}
+
+// Pick the voice to steal. instrumentId < 0 considers voices of every instrument.
+int InstrumentManager::selectVictim(int instrumentId, int noteNumber) const {
+    int victim = -1;
     
-    try {
-        std::lock_guard<std::mutex> lock(m_mutex);
+    for (int i = 0; i < MAX_VOICES; i++) {
+        const Voice& voice = m_voices[i];
+        if (!voice.active || voice.stealing) {
+            continue;
+        }
+        if (instrumentId >= 0 && voice.instrumentId != instrumentId) {
+            continue;
+        }
+        if (victim < 0) {
+            victim = i;
+            continue;
+        }
         
-        // Validate instrument ID
-        if (m_instruments.find(instrumentId) == m_instruments.end()) {
-            // Try to use default instrument 0 as fallback
-            if (m_instruments.find(0) != m_instruments.end()) {
-                LOGW("Instrument ID %d not found, using default (0) instead", instrumentId);
-                instrumentId = 0;
-            } else {
-                LOGE("Invalid instrument ID: %d", instrumentId);
-                return false;
+        const Voice& current = m_voices[victim];
+        bool better = false;
+        
+        // Voices already in their release tail are always stolen before held ones
+        if (voice.released != current.released) {
+            if (voice.released) {
+                victim = i;
             }
+            continue;
         }
         
-        // Validate note number and velocity
-        if (noteNumber < 0 || noteNumber > 127) {
-            LOGE("Invalid note number: %d", noteNumber);
-            return false;
+        switch (m_stealingPolicy) {
+            case VoiceStealingPolicy::QUIETEST: {
+                float level = voiceLevel(voice);
+                float currentLevel = voiceLevel(current);
+                better = level < currentLevel ||
+                         (level == currentLevel && voice.startOrder < current.startOrder);
+                break;
+            }
+            case VoiceStealingPolicy::LOWEST_PRIORITY:
+                better = voice.priority < current.priority ||
+                         (voice.priority == current.priority && voice.startOrder < current.startOrder);
+                break;
+            case VoiceStealingPolicy::SAME_NOTE: {
+                bool same = voice.noteNumber == noteNumber;
+                bool currentSame = current.noteNumber == noteNumber;
+                better = (same && !currentSame) ||
+                         (same == currentSame && voice.startOrder < current.startOrder);
+                break;
+            }
+            case VoiceStealingPolicy::OLDEST:
+            default:
+                better = voice.startOrder < current.startOrder;
+                break;
         }
         
-        if (velocity < 0 || velocity > 127) {
-            LOGE("Invalid velocity: %d", velocity);
-            return false;
+        if (better) {
+            victim = i;
         }
-        
-        // For sine wave instruments, create a new oscillator for this note
-        auto& instrument = m_instruments[instrumentId];
-        
-        if (instrument.type == InstrumentType::SINE_WAVE) {
-            // Store the new active note
-            m_activeNotes[instrumentId].insert(noteNumber);
-            m_noteVelocities[instrumentId][noteNumber] = velocity;
-            m_notePhases[instrumentId][noteNumber] = 0.0f;
-            
-            LOGI("Note On successful: instr=%d, note=%d, vel=%d", 
-                 instrumentId, noteNumber, velocity);
-            return true;
-        } else {
-            LOGE("Unsupported instrument type for note on");
-            return false;
+    }
+    
+    return victim;
+}
+
+// Start a short fade-out on a voice so its slot frees up without a click
+void InstrumentManager::stealVoice(Voice& voice) {
+    if (!voice.released && voice.releaseDelay < 0) {
+        publishNote(EngineEvent::NOTE_ENDED, voice, 0);
+    }
+    voice.stealing = true;
+    voice.startDelay = -1;
+    voice.releaseDelay = -1;
+    m_envelopes.forceRelease(static_cast<int>(&voice - m_voices), VOICE_STEAL_FADE_MS);
+    LOGD("Stealing voice: instrument=%d, note=%d", voice.instrumentId, voice.noteNumber);
+}
+
+// Find a slot for a new voice, stealing according to the current policy when a limit is hit
+int InstrumentManager::allocateVoice(int instrumentId, int noteNumber) {
+    const Instrument& instrument = m_instruments[instrumentId];
+    
+    int globalCount = 0;
+    int instrumentCount = 0;
+    for (const auto& voice : m_voices) {
+        if (voice.active && !voice.stealing) {
+            globalCount++;
+            if (voice.instrumentId == instrumentId) {
+                instrumentCount++;
+            }
+        }
+    }
+    
+    // Enforce the per-instrument limit first, then the global one
+    while (instrument.maxVoices > 0 && instrumentCount >= instrument.maxVoices) {
+        int victim = selectVictim(instrumentId, noteNumber);
+        if (victim < 0) {
+            break;
+        }
+        stealVoice(m_voices[victim]);
+        instrumentCount--;
+        globalCount--;
+    }
+    while (globalCount >= m_maxPolyphony) {
+        int victim = selectVictim(-1, noteNumber);
+        if (victim < 0) {
+            break;
+        }
+        stealVoice(m_voices[victim]);
+        globalCount--;
+    }
+    
+    // Prefer a free slot; otherwise cut the fading voice closest to silence
+    int slot = -1;
+    for (int i = 0; i < MAX_VOICES; i++) {
+        if (!m_voices[i].active) {
+            slot = i;
+            break;
         }
+        if (m_voices[i].stealing && (slot < 0 || m_envelopes.level(i) < m_envelopes.level(slot))) {
+            slot = i;
+        }
+    }
+    
+    return slot;
+}
+
+// Send note on event
+bool InstrumentManager::sendNoteOn(int instrumentId, int noteNumber, int velocity, int bus, double startOffset,
+                                   int delayFrames) {
+    LOGD("Note On: instrument=%d, note=%d, velocity=%d, bus=%d", instrumentId, noteNumber, velocity, bus);
+    
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return startVoice(instrumentId, noteNumber, velocity, bus, startOffset, delayFrames);
     } catch (const std::exception& e) {
         LOGE("Exception in sendNoteOn: %s", e.what());
         return false;
@@ -368,70 +477,203 @@ bool InstrumentManager::sendNoteOn(int instrumentId, int noteNumber, int velocit
 }
 
 // Send note off event
-bool InstrumentManager::sendNoteOff(int instrumentId, int noteNumber) {
+bool InstrumentManager::sendNoteOff(int instrumentId, int noteNumber, int delayFrames) {
+    LOGD("Note OFF: instrument=%d, note=%d", instrumentId, noteNumber);
+    
     try {
-        LOGI("Note OFF: instrument=%d, note=%d", instrumentId, noteNumber);
-        
-        if (!m_isInitialized) {
-            LOGE("InstrumentManager not initialized");
-            return false;
-        }
-        
-        // Validate parameters
-        if (noteNumber < 0 || noteNumber >= MAX_NOTES) {
-            LOGE("Invalid note number: %d (must be 0-%d)", noteNumber, MAX_NOTES - 1);
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return releaseVoices(instrumentId, noteNumber, delayFrames);
+    } catch (const std::exception& e) {
+        LOGE("Exception in sendNoteOff: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in sendNoteOff");
+        return false;
+    }
+}
+
+// Send a live note on at an absolute render frame
+bool InstrumentManager::sendNoteOnAtFrame(int instrumentId, int noteNumber, int velocity, int64_t frame) {
+    LOGD("Note On at frame %lld: instrument=%d, note=%d, velocity=%d",
+         static_cast<long long>(frame), instrumentId, noteNumber, velocity);
+    
+    try {
+        // The delay is taken under the render lock so no block slips past meanwhile
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return startVoice(instrumentId, noteNumber, velocity, Mixer::MASTER_BUS, 0.0, frameDelay(frame));
+    } catch (const std::exception& e) {
+        LOGE("Exception in sendNoteOnAtFrame: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in sendNoteOnAtFrame");
+        return false;
+    }
+}
+
+// Send a live note off at an absolute render frame
+bool InstrumentManager::sendNoteOffAtFrame(int instrumentId, int noteNumber, int64_t frame) {
+    LOGD("Note Off at frame %lld: instrument=%d, note=%d", static_cast<long long>(frame), instrumentId, noteNumber);
+    
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return releaseVoices(instrumentId, noteNumber, frameDelay(frame));
+    } catch (const std::exception& e) {
+        LOGE("Exception in sendNoteOffAtFrame: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in sendNoteOffAtFrame");
+        return false;
+    }
+}
+
+// Frames from the start of the next render to an absolute frame; late frames
+// play at once and live events never wait more than a second
+int InstrumentManager::frameDelay(int64_t frame) const {
+    int64_t delay = frame - m_renderedFrames.load(std::memory_order_relaxed);
+    return static_cast<int>(std::max<int64_t>(0, std::min<int64_t>(delay, m_sampleRate)));
+}
+
+// Report a note starting or ending delayFrames into the next render (caller
+// holds m_mutex, which keeps the publisher's note queue single-producer)
+void InstrumentManager::publishNote(uint8_t type, const Voice& voice, int delayFrames) {
+    if (!m_events) {
+        return;
+    }
+    EngineEvent event = {};
+    event.frame = m_renderedFrames.load(std::memory_order_relaxed) + std::max(0, delayFrames);
+    event.id = voice.instrumentId;
+    event.type = type;
+    event.data1 = static_cast<uint8_t>(voice.noteNumber);
+    event.data2 = static_cast<uint8_t>(voice.velocity);
+    m_events->pushNote(event);
+}
+
+// Start a voice for a note (caller holds m_mutex)
+bool InstrumentManager::startVoice(int instrumentId, int noteNumber, int velocity, int bus, double startOffset,
+                                   int delayFrames) {
+    // Validate instrument ID
+    if (m_instruments.find(instrumentId) == m_instruments.end()) {
+        // Try to use default instrument 0 as fallback
+        if (m_instruments.find(0) != m_instruments.end()) {
+            LOGW("Instrument ID %d not found, using default (0) instead", instrumentId);
+            instrumentId = 0;
+        } else {
+            LOGE("Invalid instrument ID: %d", instrumentId);
             return false;
         }
-        
-        std::lock_guard<std::mutex> lock(m_mutex);
-        
-        // Check if the instrument exists
-        auto it = m_instruments.find(instrumentId);
-        if (it == m_instruments.end()) {
-            LOGE("Instrument with ID %d not found for note off", instrumentId);
+    }
+    
+    // Validate note number and velocity
+    if (noteNumber < 0 || noteNumber > 127) {
+        LOGE("Invalid note number: %d", noteNumber);
+        return false;
+    }
+    
+    if (velocity < 0 || velocity > 127) {
+        LOGE("Invalid velocity: %d", velocity);
+        return false;
+    }
+    
+    if (bus < 0 || bus >= Mixer::MAX_BUSES) {
+        LOGW("Invalid mixer bus %d, using master bus", bus);
+        bus = Mixer::MASTER_BUS;
+    }
+    
+    // For sine wave instruments, create a new oscillator for this note
+    auto& instrument = m_instruments[instrumentId];
+    
+    if (instrument.type == InstrumentType::SINE_WAVE) {
+        int slot = allocateVoice(instrumentId, noteNumber);
+        if (slot < 0) {
+            LOGE("No voice available for note %d on instrument %d", noteNumber, instrumentId);
             return false;
         }
         
-        // Remove the note from active notes
-        bool wasActive = false;
-        if (m_activeNotes.find(instrumentId) != m_activeNotes.end()) {
-            auto& notes = m_activeNotes[instrumentId];
-            auto noteIt = notes.find(noteNumber);
-            
-            if (noteIt != notes.end()) {
-                notes.erase(noteIt);
-                wasActive = true;
-                LOGI("Removed note %d from active notes for instrument %d", noteNumber, instrumentId);
-            } else {
-                LOGW("Note %d was not active for instrument %d", noteNumber, instrumentId);
-            }
-            
-            // Clean up empty sets
-            if (notes.empty()) {
-                m_activeNotes.erase(instrumentId);
-                LOGD("Removed empty note set for instrument %d", instrumentId);
-            }
+        Voice& voice = m_voices[slot];
+        voice.active = true;
+        voice.released = false;
+        voice.stealing = false;
+        voice.instrumentId = instrumentId;
+        voice.bus = bus;
+        voice.noteNumber = noteNumber;
+        voice.velocity = velocity;
+        voice.priority = instrument.priority;
+        voice.startOrder = m_nextVoiceOrder++;
+        voice.startDelay = delayFrames > 0 ? delayFrames : -1;
+        voice.releaseDelay = -1;
+        voice.phaseIncrement = 2.0f * M_PI * midiNoteToFrequency(noteNumber) / m_sampleRate;
+        voice.phase = 0.0f;
+        if (startOffset > 0.0) {
+            double frames = std::floor(startOffset * m_sampleRate);
+            voice.phase = static_cast<float>(std::fmod(frames * voice.phaseIncrement, 2.0 * M_PI));
         }
         
-        // Clean up velocity map
-        if (m_noteVelocities.find(instrumentId) != m_noteVelocities.end()) {
-            auto& velocities = m_noteVelocities[instrumentId];
-            velocities.erase(noteNumber);
-            
-            // Clean up empty maps
-            if (velocities.empty()) {
-                m_noteVelocities.erase(instrumentId);
-            }
+        // A delayed voice stays silent until renderAudio reaches its frame
+        m_envelopes.reset(slot);
+        if (voice.startDelay < 0) {
+            m_envelopes.noteOn(slot, instrument.envelope);
         }
+        publishNote(EngineEvent::NOTE_STARTED, voice, delayFrames);
         
+        LOGD("Note On successful: instr=%d, note=%d, vel=%d", 
+             instrumentId, noteNumber, velocity);
         return true;
-    } catch (const std::exception& e) {
-        LOGE("Exception in sendNoteOff: %s", e.what());
+    } else {
+        LOGE("Unsupported instrument type for note on");
         return false;
-    } catch (...) {
-        LOGE("Unknown exception in sendNoteOff");
+    }
+}
+
+// Release the held voices playing a note (caller holds m_mutex)
+bool InstrumentManager::releaseVoices(int instrumentId, int noteNumber, int delayFrames) {
+    if (!m_isInitialized) {
+        LOGE("InstrumentManager not initialized");
+        return false;
+    }
+    
+    // Validate parameters
+    if (noteNumber < 0 || noteNumber >= MAX_NOTES) {
+        LOGE("Invalid note number: %d (must be 0-%d)", noteNumber, MAX_NOTES - 1);
         return false;
     }
+    
+    // Check if the instrument exists
+    auto it = m_instruments.find(instrumentId);
+    if (it == m_instruments.end()) {
+        LOGE("Instrument with ID %d not found for note off", instrumentId);
+        return false;
+    }
+    
+    // Move every held voice playing this note into its release stage. A voice
+    // delayed to start after the note off is released on its start frame, so
+    // it never sounds rather than starting with no note off to end it.
+    delayFrames = std::max(0, delayFrames);
+    bool wasActive = false;
+    for (int i = 0; i < MAX_VOICES; i++) {
+        Voice& voice = m_voices[i];
+        if (voice.active && !voice.released && !voice.stealing &&
+            voice.instrumentId == instrumentId && voice.noteNumber == noteNumber) {
+            int releaseFrames = std::max(delayFrames, voice.startDelay);
+            if (releaseFrames > 0) {
+                voice.releaseDelay = releaseFrames;
+            } else {
+                voice.released = true;
+                voice.startDelay = -1;
+                voice.releaseDelay = -1;
+                m_envelopes.noteOff(i);
+            }
+            wasActive = true;
+            publishNote(EngineEvent::NOTE_ENDED, voice, releaseFrames);
+        }
+    }
+    
+    if (wasActive) {
+        LOGD("Released note %d for instrument %d", noteNumber, instrumentId);
+    } else {
+        LOGD("Note %d was not active for instrument %d", noteNumber, instrumentId);
+    }
+    
+    return true;
 }
 
 std::vector<int> InstrumentManager::getLoadedInstrumentIds() {
@@ -481,63 +723,94 @@ bool InstrumentManager::setInstrumentVolume(int instrumentId, float volume) {
     }
 }
 
-// Helper methods for audio rendering
-std::vector<int> InstrumentManager::getActiveInstruments() const {
-    std::vector<int> result;
+bool InstrumentManager::setMaxPolyphony(int maxVoices) {
+    LOGD("Setting max polyphony to %d", maxVoices);
     
-    try {
-        // No need for a lock in a const method, but be careful with thread safety
-        for (const auto& pair : m_activeNotes) {
-            if (!pair.second.empty()) {
-                result.push_back(pair.first);
-            }
-        }
-    } catch (const std::exception& e) {
-        LOGE("Exception in getActiveInstruments: %s", e.what());
+    if (maxVoices < 1 || maxVoices > MAX_POLYPHONY) {
+        LOGE("Invalid max polyphony: %d (must be 1-%d)", maxVoices, MAX_POLYPHONY);
+        return false;
     }
     
-    return result;
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxPolyphony = maxVoices;
+    return true;
 }
 
-std::set<int> InstrumentManager::getActiveNotes(int instrumentId) const {
+bool InstrumentManager::setInstrumentPolyphony(int instrumentId, int maxVoices, int priority) {
+    LOGD("Setting polyphony for instrument %d: maxVoices=%d, priority=%d",
+         instrumentId, maxVoices, priority);
     try {
-        auto it = m_activeNotes.find(instrumentId);
-        if (it != m_activeNotes.end()) {
-            return it->second;
+        if (maxVoices < 0 || maxVoices > MAX_POLYPHONY) {
+            LOGE("Invalid instrument polyphony: %d (must be 0-%d)", maxVoices, MAX_POLYPHONY);
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto it = m_instruments.find(instrumentId);
+        if (it == m_instruments.end()) {
+            LOGW("Instrument with ID %d not found for polyphony setting", instrumentId);
+            return false;
+        }
+        
+        it->second.maxVoices = maxVoices;
+        it->second.priority = priority;
+        
+        // Voices already sounding pick up the new priority for future stealing decisions
+        for (auto& voice : m_voices) {
+            if (voice.active && voice.instrumentId == instrumentId) {
+                voice.priority = priority;
+            }
         }
+        return true;
     } catch (const std::exception& e) {
-        LOGE("Exception in getActiveNotes: %s", e.what());
+        LOGE("Exception in setInstrumentPolyphony: %s", e.what());
+        return false;
     }
-    
-    return std::set<int>();
 }
 
-int InstrumentManager::getNoteVelocity(int instrumentId, int noteNumber) const {
+bool InstrumentManager::setInstrumentEnvelope(int instrumentId, const EnvelopeParams& envelope) {
+    LOGD("Setting envelope for instrument %d: A=%.1fms D=%.1fms S=%.2f R=%.1fms",
+         instrumentId, envelope.attackMs, envelope.decayMs, envelope.sustainLevel, envelope.releaseMs);
     try {
-        auto instIt = m_noteVelocities.find(instrumentId);
-        if (instIt != m_noteVelocities.end()) {
-            auto noteIt = instIt->second.find(noteNumber);
-            if (noteIt != instIt->second.end()) {
-                return noteIt->second;
-            }
+        if (envelope.attackMs < 0.0f || envelope.decayMs < 0.0f || envelope.releaseMs < 0.0f ||
+            envelope.sustainLevel < 0.0f || envelope.sustainLevel > 1.0f) {
+            LOGE("Invalid envelope parameters for instrument %d", instrumentId);
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto it = m_instruments.find(instrumentId);
+        if (it == m_instruments.end()) {
+            LOGW("Instrument with ID %d not found for envelope setting", instrumentId);
+            return false;
         }
+        
+        // Applies to notes started from now on
+        it->second.envelope = envelope;
+        return true;
     } catch (const std::exception& e) {
-        LOGE("Exception in getNoteVelocity: %s", e.what());
+        LOGE("Exception in setInstrumentEnvelope: %s", e.what());
+        return false;
     }
-    
-    // Default velocity if not found
-    return 64;
 }
 
-float& InstrumentManager::getNotePhase(int instrumentId, int noteNumber) {
-    static float defaultPhase = 0.0f;
-    
-    try {
-        return m_notePhases[instrumentId][noteNumber];
-    } catch (const std::exception& e) {
-        LOGE("Exception in getNotePhase: %s", e.what());
-        return defaultPhase;
+void InstrumentManager::setVoiceStealingPolicy(VoiceStealingPolicy policy) {
+    LOGD("Setting voice stealing policy to %d", static_cast<int>(policy));
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_stealingPolicy = policy;
+}
+
+int InstrumentManager::getActiveVoiceCount() {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    int count = 0;
+    for (const auto& voice : m_voices) {
+        if (voice.active && !voice.stealing) {
+            count++;
+        }
     }
+    return count;
 }
 
 // Stop all notes for all instruments
@@ -546,14 +819,11 @@ void InstrumentManager::stopAllNotes() {
     try {
         std::lock_guard<std::mutex> lock(m_mutex);
         
-        // Iterate through all instruments
-        for (const auto& [instrumentId, instrument] : m_instruments) {
-            // Clear all active notes for this instrument
-            m_activeNotes[instrumentId].clear();
-            m_noteVelocities[instrumentId].clear();
-            m_notePhases[instrumentId].clear();
-            
-            LOGD("Cleared all notes for instrument %d (%s)", instrumentId, instrument.name.c_str());
+        // Fade out every voice in the pool
+        for (auto& voice : m_voices) {
+            if (voice.active && !voice.stealing) {
+                stealVoice(voice);
+            }
         }
         
         LOGD("Successfully stopped all notes for all instruments");
@@ -577,10 +847,12 @@ bool InstrumentManager::stopAllNotes(int instrumentId) {
             return false;
         }
         
-        // Clear all active notes for this instrument
-        m_activeNotes[instrumentId].clear();
-        m_noteVelocities[instrumentId].clear();
-        m_notePhases[instrumentId].clear();
+        // Fade out all voices owned by this instrument
+        for (auto& voice : m_voices) {
+            if (voice.active && !voice.stealing && voice.instrumentId == instrumentId) {
+                stealVoice(voice);
+            }
+        }
         
         LOGD("Successfully stopped all notes for instrument %d (%s)", 
              instrumentId, it->second.name.c_str());
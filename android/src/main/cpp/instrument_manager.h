@@ -4,11 +4,16 @@
 #include <map>
 #include <string>
 #include <mutex>
+#include <atomic>
 #include <set>
 #include <optional>
 #include <vector>
+#include <cstdint>
+#include "envelope.h"
+#include "mixer.h"
 
 class AudioEngine;
+class EventPublisher;
 
 // Define instrument types
 enum class InstrumentType {
@@ -24,9 +29,38 @@ struct Instrument {
     std::string name;
     std::string filePath;  // For SFZ or SF2 files
     float volume = 1.0f;
+    int maxVoices = 0;     // Per-instrument polyphony limit (0 = global limit only)
+    int priority = 0;      // Higher priority voices are stolen last
+    EnvelopeParams envelope;
     // Additional instrument-specific properties can be added here
 };
 
+// Policy used to pick a victim when a polyphony limit is reached
+enum class VoiceStealingPolicy {
+    OLDEST,
+    QUIETEST,
+    LOWEST_PRIORITY,
+    SAME_NOTE
+};
+
+// A single sounding note in the fixed voice pool; its amplitude envelope
+// lives in the matching slot of InstrumentManager's EnvelopeBank
+struct Voice {
+    bool active = false;
+    bool released = false;      // Note off received, playing its release tail
+    bool stealing = false;      // Fading out after being stolen
+    int instrumentId = -1;
+    int bus = Mixer::MASTER_BUS;  // Mixer strip the voice renders into
+    int noteNumber = 0;
+    int velocity = 0;
+    int priority = 0;
+    uint64_t startOrder = 0;    // Lower values started earlier
+    int startDelay = -1;        // Frames into the next render before it starts; -1 once started
+    int releaseDelay = -1;      // Frames into the next render before its pending release; -1 if none
+    float phase = 0.0f;
+    float phaseIncrement = 0.0f;
+};
+
 // Manager class for handling instruments
 class InstrumentManager {
 public:
@@ -45,9 +79,22 @@ public:
     int loadSf2Instrument(const std::string& filePath, const std::string& name, int presetIndex);
     bool unloadInstrument(int instrumentId);
     
-    // MIDI-style note events
-    bool sendNoteOn(int instrumentId, int noteNumber, int velocity);
-    bool sendNoteOff(int instrumentId, int noteNumber);
+    // MIDI-style note events; bus selects the mixer strip (see Mixer).
+    // startOffset (seconds) starts the oscillator that far into the note, for
+    // notes chased after a seek; the attack still runs so it doesn't click.
+    // delayFrames places the event that many frames into the next render, so
+    // it lands on its exact sample whatever the buffer size.
+    bool sendNoteOn(int instrumentId, int noteNumber, int velocity, int bus = Mixer::MASTER_BUS,
+                    double startOffset = 0.0, int delayFrames = 0);
+    bool sendNoteOff(int instrumentId, int noteNumber, int delayFrames = 0);
+    
+    // Live note events stamped with an absolute render frame (see
+    // getRenderedFrames); frames already rendered play at the next one
+    bool sendNoteOnAtFrame(int instrumentId, int noteNumber, int velocity, int64_t frame);
+    bool sendNoteOffAtFrame(int instrumentId, int noteNumber, int64_t frame);
+    
+    // Frames rendered since init; the next render starts at this frame
+    int64_t getRenderedFrames() const { return m_renderedFrames.load(std::memory_order_acquire); }
     
     // Stop all notes for an instrument
     bool stopAllNotes(int instrumentId);
@@ -59,14 +106,22 @@ public:
     bool setInstrumentVolume(int instrumentId, float volume);
     std::vector<int> getLoadedInstrumentIds();
     
+    // Polyphony control
+    bool setMaxPolyphony(int maxVoices);
+    bool setInstrumentPolyphony(int instrumentId, int maxVoices, int priority);
+    bool setInstrumentEnvelope(int instrumentId, const EnvelopeParams& envelope);
+    void setVoiceStealingPolicy(VoiceStealingPolicy policy);
+    int getActiveVoiceCount();
+    
+    // Note started/ended events go here; may be null
+    void setEventPublisher(EventPublisher* events) { m_events = events; }
+    
+    // Per-track mixer; its setters are lock-free and safe from any thread
+    Mixer& getMixer() { return m_mixer; }
+    
     // Audio rendering
     void renderAudio(float* buffer, int numFrames, float masterVolume);
     
-    // Helper methods for audio rendering
-    std::vector<int> getActiveInstruments() const;
-    std::set<int> getActiveNotes(int instrumentId) const;
-    int getNoteVelocity(int instrumentId, int noteNumber) const;
-    float& getNotePhase(int instrumentId, int noteNumber);
     std::optional<Instrument> getInstrument(int instrumentId) const;
     
     // Utility functions
@@ -75,6 +130,7 @@ public:
 private:
     // Audio engine reference
     AudioEngine* m_audioEngine = nullptr;
+    EventPublisher* m_events = nullptr;
     
     // Initialization state
     bool m_isInitialized = false;
@@ -85,18 +141,40 @@ private:
     
     // Maps for instrument management
     std::map<int, Instrument> m_instruments;
-    std::map<int, std::set<int>> m_activeNotes;  // instrumentId -> set of active note numbers
-    std::map<int, std::map<int, int>> m_noteVelocities;  // instrumentId -> (noteNumber -> velocity)
-    std::map<int, std::map<int, float>> m_notePhases;  // instrumentId -> (noteNumber -> phase)
     
     // Generate a unique ID for a new instrument
     int generateUniqueId();
     
+    // Note and voice allocation helpers (caller holds m_mutex)
+    bool startVoice(int instrumentId, int noteNumber, int velocity, int bus, double startOffset,
+                    int delayFrames);
+    bool releaseVoices(int instrumentId, int noteNumber, int delayFrames);
+    int frameDelay(int64_t frame) const;
+    void publishNote(uint8_t type, const Voice& voice, int delayFrames);
+    int allocateVoice(int instrumentId, int noteNumber);
+    int selectVictim(int instrumentId, int noteNumber) const;
+    void stealVoice(Voice& voice);
+    float voiceLevel(const Voice& voice) const;
+    
     // Constants
     static constexpr int MAX_INSTRUMENTS = 128;
     static constexpr int MAX_NOTES = 128;
+    static constexpr int MAX_VOICES = EnvelopeBank::CAPACITY;
+    static constexpr int MAX_POLYPHONY = MAX_VOICES / 2;  // Leaves room for voices fading out
+    static constexpr float VOICE_STEAL_FADE_MS = 5.0f;
     static constexpr int MIN_SAMPLE_RATE = 8000;
     static constexpr int MAX_SAMPLE_RATE = 192000;
+    static_assert(EnvelopeBank::BLOCK_SIZE <= Mixer::MAX_BLOCK_FRAMES,
+                  "Render blocks must fit in the mixer bus buffers");
+    
+    // Fixed voice pool; rendering cost is bounded by its size
+    Voice m_voices[MAX_VOICES];
+    EnvelopeBank m_envelopes;
+    Mixer m_mixer;
+    uint64_t m_nextVoiceOrder = 1;
+    std::atomic<int64_t> m_renderedFrames{0};  // Written under m_mutex by renderAudio
+    int m_maxPolyphony = 32;
+    VoiceStealingPolicy m_stealingPolicy = VoiceStealingPolicy::OLDEST;
 };
 
 #endif // INSTRUMENT_MANAGER_H 
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "limiter.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+static constexpr float DEFAULT_CEILING_DB = -1.0f;
+static constexpr float DEFAULT_RELEASE_MS = 50.0f;
+
+// Sliding minimum: out[j - (window - 1)] = min(in[j - window + 1 .. j]) for
+// every j from window - 1 to count - 1. Each pass doubles the span every
+// element covers, so it takes log2(window) branch-free passes plus one that
+// joins two overlapping spans; a and b are scratch of count floats each.
+static void windowMin(const float* in, float* a, float* b, int count, int window, float* out) {
+    std::memcpy(a, in, sizeof(float) * count);
+    int span = 1;
+    for (; span * 2 <= window; span *= 2) {
+        std::memcpy(b, a, sizeof(float) * span);
+        for (int j = span; j < count; j++) {
+            b[j] = std::min(a[j], a[j - span]);
+        }
+        std::swap(a, b);
+    }
+    const int overlap = window - span;
+    for (int j = window - 1; j < count; j++) {
+        out[j - window + 1] = std::min(a[j], a[j - overlap]);
+    }
+}
+
+Limiter::Limiter()
+    : m_ceiling(std::pow(10.0f, DEFAULT_CEILING_DB / 20.0f)),
+      m_releaseMs(DEFAULT_RELEASE_MS) {
+}
+
+void Limiter::init(int sampleRate) {
+    m_sampleRate = std::max(1, sampleRate);
+    m_attackFrames = std::max(1, static_cast<int>(std::lround(LOOKAHEAD_MS * 0.001f * m_sampleRate)));
+    // The mid-sample estimate lags the input by up to two frames
+    m_delayFrames = m_attackFrames + 2;
+    // A peak's target must cover the attack ramp and the frames the detector
+    // saw it in: the frame itself and the two its midpoint lies between
+    m_holdFrames = m_delayFrames + 1;
+
+    m_delay.assign((m_delayFrames + MAX_BLOCK_FRAMES) * 2, 0.0f);
+    m_planar.assign((MAX_BLOCK_FRAMES + 3) * 2, 0.0f);
+    m_detector.assign(MAX_BLOCK_FRAMES, 0.0f);
+    m_targets.assign(m_holdFrames - 1 + MAX_BLOCK_FRAMES, 1.0f);
+    m_held.assign(m_attackFrames + MAX_BLOCK_FRAMES, 1.0f);
+    m_scratch.assign(m_targets.size() * 2, 0.0f);
+    m_gains.assign(MAX_BLOCK_FRAMES, 1.0f);
+
+    m_gain = 1.0f;
+    m_idle = true;
+    std::memset(m_history, 0, sizeof(m_history));
+}
+
+void Limiter::setCeiling(float ceilingDb) {
+    ceilingDb = std::max(-24.0f, std::min(0.0f, ceilingDb));
+    m_ceiling.store(std::pow(10.0f, ceilingDb / 20.0f), std::memory_order_relaxed);
+}
+
+void Limiter::setRelease(float releaseMs) {
+    m_releaseMs.store(std::max(1.0f, std::min(1000.0f, releaseMs)), std::memory_order_relaxed);
+}
+
+void Limiter::process(float* buffer, int numFrames) {
+    if (m_delay.empty()) {
+        return;
+    }
+    for (int offset = 0; offset < numFrames; offset += MAX_BLOCK_FRAMES) {
+        processChunk(buffer + offset * 2, std::min(MAX_BLOCK_FRAMES, numFrames - offset));
+    }
+}
+
+void Limiter::processChunk(float* buffer, int numFrames) {
+    const float ceiling = m_ceiling.load(std::memory_order_relaxed);
+    float* left = m_planar.data();
+    float* right = left + MAX_BLOCK_FRAMES + 3;
+    float* detector = m_detector.data();
+
+    // Split channels behind three frames of history
+    for (int h = 0; h < 3; h++) {
+        left[h] = m_history[0][h];
+        right[h] = m_history[1][h];
+    }
+    for (int i = 0; i < numFrames; i++) {
+        left[i + 3] = buffer[i * 2];
+        right[i + 3] = buffer[i * 2 + 1];
+    }
+    for (int h = 0; h < 3; h++) {
+        m_history[0][h] = left[numFrames + h];
+        m_history[1][h] = right[numFrames + h];
+    }
+
+    // Peak detector: each sample, plus a cubic estimate of the midpoint
+    // between the two samples before it (branch-free so it vectorizes)
+    float blockPeak = 0.0f;
+    for (int i = 0; i < numFrames; i++) {
+        float midLeft = (9.0f * (left[i + 1] + left[i + 2]) - left[i] - left[i + 3]) * 0.0625f;
+        float midRight = (9.0f * (right[i + 1] + right[i + 2]) - right[i] - right[i + 3]) * 0.0625f;
+        float peak = std::max(std::max(std::fabs(left[i + 3]), std::fabs(right[i + 3])),
+                              std::max(std::fabs(midLeft), std::fabs(midRight)));
+        detector[i] = peak;
+        blockPeak = std::max(blockPeak, peak);
+    }
+
+    // Queue the block behind the lookahead
+    float* delay = m_delay.data();
+    const int delaySamples = m_delayFrames * 2;
+    std::memcpy(delay + delaySamples, buffer, sizeof(float) * numFrames * 2);
+
+    if (blockPeak <= ceiling && m_idle) {
+        // Fast path: nothing to limit, only the delay
+        std::memcpy(buffer, delay, sizeof(float) * numFrames * 2);
+    } else {
+        float releaseCoef = std::exp(-1.0f / (m_releaseMs.load(std::memory_order_relaxed) * 0.001f * m_sampleRate));
+        const int targetHistory = m_holdFrames - 1;
+        float* targets = m_targets.data();
+        float* held = m_held.data();
+        float* gains = m_gains.data();
+
+        // Target gain per frame: 1 below the ceiling, else what brings the peak down to it
+        for (int i = 0; i < numFrames; i++) {
+            targets[targetHistory + i] = ceiling / std::max(detector[i], ceiling);
+        }
+
+        // Hold each target until its peak has left the delay line
+        float* scratch = m_scratch.data();
+        windowMin(targets, scratch, scratch + m_targets.size(), targetHistory + numFrames, m_holdFrames,
+                  held + m_attackFrames);
+
+        // Attack: a moving average over attackFrames ramps the gain linearly
+        // into each hold, never above it. Release: follow the ramp down at
+        // once, recover towards it exponentially.
+        const float attackScale = 1.0f / m_attackFrames;
+        double sum = 0.0;
+        for (int i = 0; i < m_attackFrames; i++) {
+            sum += held[i];
+        }
+        float gain = m_gain;
+        float ramp = 1.0f;
+        for (int i = 0; i < numFrames; i++) {
+            sum += held[m_attackFrames + i] - held[i];
+            ramp = static_cast<float>(sum) * attackScale;
+            gain = ramp - std::max(0.0f, ramp - gain) * releaseCoef;
+            gains[i] = gain;
+        }
+        if (ramp >= 1.0f && gain > 0.9999f) {
+            gain = 1.0f;
+        }
+        m_gain = gain;
+
+        for (int i = 0; i < numFrames; i++) {
+            buffer[i * 2] = delay[i * 2] * gains[i];
+            buffer[i * 2 + 1] = delay[i * 2 + 1] * gains[i];
+        }
+
+        // Carry the windows' history into the next block; once it is all
+        // unity and the gain has recovered, quiet blocks take the fast path
+        std::memmove(targets, targets + numFrames, sizeof(float) * targetHistory);
+        std::memmove(held, held + numFrames, sizeof(float) * m_attackFrames);
+        float pending = 1.0f;
+        for (int i = 0; i < targetHistory; i++) {
+            pending = std::min(pending, targets[i]);
+        }
+        for (int i = 0; i < m_attackFrames; i++) {
+            pending = std::min(pending, held[i]);
+        }
+        m_idle = pending >= 1.0f && m_gain >= 1.0f;
+    }
+
+    // Keep the last delayFrames of input for the next block
+    std::memmove(delay, delay + numFrames * 2, sizeof(float) * delaySamples);
+}
@@ -0,0 +1,63 @@
+#ifndef LIMITER_H
+#define LIMITER_H
+
+#include <atomic>
+#include <vector>
+
+// Lookahead peak limiter for the interleaved stereo master output.
+//
+// The signal is delayed by a short lookahead so the gain can ramp down before
+// a peak reaches the output, then released exponentially. Peaks are detected
+// on the samples and on a cubic estimate of the point between them, which
+// catches most inter-sample overs. Blocks whose peak stays below the ceiling
+// while no gain reduction is active only pay for the detector and the delay.
+//
+// The gain computer runs as whole-block passes: the per-frame target gain,
+// its minimum over a window one frame longer than the delay (the hold), a
+// moving average of that over the lookahead (the linear attack, which reaches
+// each target as its peak leaves the delay line), and the release. All but
+// the release are branch-free loops over independent frames; the release is
+// a one-pole recurrence, so it stays a serial, select-based scan.
+class Limiter {
+public:
+    static constexpr int MAX_BLOCK_FRAMES = 4096;
+    static constexpr float LOOKAHEAD_MS = 1.5f;
+
+    Limiter();
+
+    // Allocates the delay line; call before process() and whenever the rate changes
+    void init(int sampleRate);
+
+    // Control-thread setters (lock-free)
+    void setCeiling(float ceilingDb);
+    void setRelease(float releaseMs);
+
+    // Audio thread: limit numFrames of interleaved stereo in place
+    void process(float* buffer, int numFrames);
+
+private:
+    void processChunk(float* buffer, int numFrames);
+
+    std::atomic<float> m_ceiling;      // Linear
+    std::atomic<float> m_releaseMs;
+
+    int m_sampleRate = 44100;
+    int m_attackFrames = 1;            // Gain ramp length
+    int m_delayFrames = 1;             // Lookahead plus detector latency
+    int m_holdFrames = 2;              // Window of the target minimum
+
+    // Gain computer state
+    float m_gain = 1.0f;               // Released gain at the end of the last block
+    bool m_idle = true;                // No reduction pending in the gain computer
+
+    float m_history[2][3] = {};        // Last input samples per channel for the detector
+    std::vector<float> m_delay;        // Interleaved: delayFrames of history, then the block
+    std::vector<float> m_planar;       // Per-channel input with history, for the detector
+    std::vector<float> m_detector;     // Per-frame peak estimate
+    std::vector<float> m_targets;      // holdFrames - 1 of history, then the block's target gains
+    std::vector<float> m_held;         // attackFrames of history, then the block's held targets
+    std::vector<float> m_scratch;      // Two buffers the size of m_targets for the window minimum
+    std::vector<float> m_gains;        // Per-frame gain
+};
+
+#endif // LIMITER_H
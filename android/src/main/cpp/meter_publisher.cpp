@@ -0,0 +1,87 @@
+#include "meter_publisher.h"
+#include <android/log.h>
+#include "dart_api_dl.h"
+
+#define LOG_TAG "MeterPublisher"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+MeterPublisher::MeterPublisher(Mixer& mixer)
+    : PortPublisher("meter", MAX_RATE_HZ), m_mixer(mixer) {
+}
+
+MeterPublisher::~MeterPublisher() {
+    stop();
+}
+
+void MeterPublisher::reset() {
+    m_lastWasSilent = false;
+}
+
+void MeterPublisher::publish() {
+    // Collect every track strip in use
+    int count = 0;
+    bool silent = true;
+    for (int bus = Mixer::MASTER_BUS + 1; bus < Mixer::MAX_BUSES; bus++) {
+        int32_t tag;
+        MeterReading reading;
+        if (!m_mixer.readBusMeter(bus, tag, reading) || tag < 0) {
+            continue;
+        }
+        m_trackIds[count] = tag;
+        m_peaks[count] = reading.peak;
+        m_rms[count] = reading.rms;
+        silent = silent && reading.peak == 0.0f && reading.rms < 1e-6f;
+        count++;
+    }
+    MeterReading master = m_mixer.readMasterMeter();
+    silent = silent && master.peak == 0.0f && master.rms < 1e-6f;
+
+    // Coalesce silence: one zero update, then nothing until levels return
+    if (silent && m_lastWasSilent) {
+        return;
+    }
+    m_lastWasSilent = silent;
+
+    Dart_CObject kind;
+    kind.type = Dart_CObject_kString;
+    kind.value.as_string = "meters";
+
+    Dart_CObject trackIds;
+    trackIds.type = Dart_CObject_kTypedData;
+    trackIds.value.as_typed_data.type = Dart_TypedData_kInt32;
+    trackIds.value.as_typed_data.length = count;
+    trackIds.value.as_typed_data.values = reinterpret_cast<const uint8_t*>(m_trackIds);
+
+    Dart_CObject peaks;
+    peaks.type = Dart_CObject_kTypedData;
+    peaks.value.as_typed_data.type = Dart_TypedData_kFloat32;
+    peaks.value.as_typed_data.length = count;
+    peaks.value.as_typed_data.values = reinterpret_cast<const uint8_t*>(m_peaks);
+
+    Dart_CObject rms;
+    rms.type = Dart_CObject_kTypedData;
+    rms.value.as_typed_data.type = Dart_TypedData_kFloat32;
+    rms.value.as_typed_data.length = count;
+    rms.value.as_typed_data.values = reinterpret_cast<const uint8_t*>(m_rms);
+
+    Dart_CObject masterPeak;
+    masterPeak.type = Dart_CObject_kDouble;
+    masterPeak.value.as_double = master.peak;
+
+    Dart_CObject masterRms;
+    masterRms.type = Dart_CObject_kDouble;
+    masterRms.value.as_double = master.rms;
+
+    Dart_CObject* values[] = {&kind, &trackIds, &peaks, &rms, &masterPeak, &masterRms};
+    Dart_CObject message;
+    message.type = Dart_CObject_kArray;
+    message.value.as_array.length = 6;
+    message.value.as_array.values = values;
+
+    if (!Dart_PostCObject_DL(dartPort(), &message)) {
+        LOGW("Failed to post meter update to Dart port %lld", static_cast<long long>(dartPort()));
+    }
+}
@@ -0,0 +1,36 @@
+#ifndef METER_PUBLISHER_H
+#define METER_PUBLISHER_H
+
+#include <cstdint>
+#include "mixer.h"
+#include "port_publisher.h"
+
+// Samples the mixer's meter atomics at a fixed rate on a PortPublisher thread
+// and posts them to a Dart port. Each message carries the latest level of every
+// track plus the master, so slow consumers only ever see fresh values; while
+// everything is silent nothing is posted after the first all-zero message.
+//
+// Message layout: ["meters", Int32List trackIds, Float32List peaks,
+//                  Float32List rms, masterPeak, masterRms]
+class MeterPublisher : public PortPublisher {
+public:
+    static constexpr int DEFAULT_RATE_HZ = 30;
+    static constexpr int MAX_RATE_HZ = 120;
+
+    explicit MeterPublisher(Mixer& mixer);
+    ~MeterPublisher() override;
+
+private:
+    void publish() override;
+    void reset() override;
+
+    Mixer& m_mixer;
+    bool m_lastWasSilent = false;
+
+    // Message payload, reused between posts
+    int32_t m_trackIds[Mixer::MAX_BUSES];
+    float m_peaks[Mixer::MAX_BUSES];
+    float m_rms[Mixer::MAX_BUSES];
+};
+
+#endif // METER_PUBLISHER_H
@@ -0,0 +1,594 @@
+#include "midi_file.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+namespace {
+
+// A note on waiting for its note off
+struct PendingNote {
+    uint64_t startTick;
+    uint8_t velocity;
+};
+
+} // namespace
+
+MidiFileReader::MidiFileReader()
+    : m_buffer(BUFFER_SIZE) {
+}
+
+MidiFileReader::~MidiFileReader() {
+    if (m_file) {
+        fclose(m_file);
+    }
+}
+
+bool MidiFileReader::fail(const std::string& message) {
+    if (m_error.empty()) {
+        m_error = message;
+    }
+    return false;
+}
+
+bool MidiFileReader::fill() {
+    m_bufferPos = 0;
+    m_bufferEnd = fread(m_buffer.data(), 1, m_buffer.size(), m_file);
+    return m_bufferEnd > 0;
+}
+
+bool MidiFileReader::readByte(uint8_t& value) {
+    if (m_chunkRemaining == 0) {
+        return fail("Unexpected end of chunk");
+    }
+    if (m_bufferPos == m_bufferEnd && !fill()) {
+        return fail("Unexpected end of file");
+    }
+    value = m_buffer[m_bufferPos++];
+    m_chunkRemaining--;
+    return true;
+}
+
+bool MidiFileReader::readBytes(uint8_t* out, size_t count) {
+    for (size_t i = 0; i < count; i++) {
+        if (!readByte(out[i])) {
+            return false;
+        }
+    }
+    return true;
+}
+
+bool MidiFileReader::skip(uint64_t count) {
+    if (count > m_chunkRemaining) {
+        return fail("Event runs past the end of its chunk");
+    }
+    while (count > 0) {
+        if (m_bufferPos == m_bufferEnd && !fill()) {
+            return fail("Unexpected end of file");
+        }
+        size_t step = static_cast<size_t>(std::min<uint64_t>(count, m_bufferEnd - m_bufferPos));
+        m_bufferPos += step;
+        m_chunkRemaining -= step;
+        count -= step;
+    }
+    return true;
+}
+
+bool MidiFileReader::readUint16(uint16_t& value) {
+    uint8_t bytes[2];
+    if (!readBytes(bytes, 2)) {
+        return false;
+    }
+    value = static_cast<uint16_t>((bytes[0] << 8) | bytes[1]);
+    return true;
+}
+
+bool MidiFileReader::readUint32(uint32_t& value) {
+    uint8_t bytes[4];
+    if (!readBytes(bytes, 4)) {
+        return false;
+    }
+    value = (static_cast<uint32_t>(bytes[0]) << 24) | (static_cast<uint32_t>(bytes[1]) << 16) |
+            (static_cast<uint32_t>(bytes[2]) << 8) | bytes[3];
+    return true;
+}
+
+bool MidiFileReader::readVarLen(uint32_t& value) {
+    value = 0;
+    for (int i = 0; i < 4; i++) {
+        uint8_t byte;
+        if (!readByte(byte)) {
+            return false;
+        }
+        value = (value << 7) | (byte & 0x7F);
+        if (!(byte & 0x80)) {
+            return true;
+        }
+    }
+    return fail("Variable-length quantity longer than 4 bytes");
+}
+
+bool MidiFileReader::read(const std::string& path, MidiFileData& data) {
+    m_error.clear();
+    m_tempoChanges.clear();
+    data.format = 0;
+    data.ticksPerBeat = 0;
+    data.tempos.clear();
+    data.timeSignatures.clear();
+    data.tracks.clear();
+    m_bufferPos = m_bufferEnd = 0;
+
+    if (m_file) {
+        fclose(m_file);
+    }
+    m_file = fopen(path.c_str(), "rb");
+    if (!m_file) {
+        return fail("Cannot open file: " + path);
+    }
+
+    // Every exit from the chunk walk closes the file, so a reused reader never
+    // leaks the previous one
+    bool ok = readChunks(data);
+    fclose(m_file);
+    m_file = nullptr;
+    if (!ok) {
+        return false;
+    }
+
+    // Type 1 files may spread meta events over several tracks
+    std::stable_sort(data.tempos.begin(), data.tempos.end(),
+                     [](const MidiFileTempo& a, const MidiFileTempo& b) { return a.beat < b.beat; });
+    std::stable_sort(data.timeSignatures.begin(), data.timeSignatures.end(),
+                     [](const MidiFileTimeSignature& a, const MidiFileTimeSignature& b) { return a.beat < b.beat; });
+    return true;
+}
+
+bool MidiFileReader::readChunks(MidiFileData& data) {
+    uint16_t trackCount = 0;
+    if (!readHeader(data, trackCount)) {
+        return false;
+    }
+
+    // Walk the chunks; unknown chunk types are skipped as the spec requires
+    for (uint16_t parsed = 0; parsed < trackCount;) {
+        uint8_t type[4];
+        uint32_t length;
+        m_chunkRemaining = 8;
+        if (!readBytes(type, 4) || !readUint32(length)) {
+            // Tolerate files that declare more tracks than they contain
+            if (parsed > 0) {
+                m_error.clear();
+                break;
+            }
+            return false;
+        }
+
+        m_chunkRemaining = length;
+        if (std::memcmp(type, "MTrk", 4) != 0) {
+            if (!skip(length)) {
+                return false;
+            }
+            continue;
+        }
+        if (!readTrack(data)) {
+            return false;
+        }
+        parsed++;
+        if (m_onProgress) {
+            m_onProgress(static_cast<float>(parsed) / trackCount);
+        }
+    }
+    return true;
+}
+
+bool MidiFileReader::readHeader(MidiFileData& data, uint16_t& trackCount) {
+    uint8_t type[4];
+    uint32_t length;
+    m_chunkRemaining = 8;
+    if (!readBytes(type, 4) || !readUint32(length)) {
+        return false;
+    }
+    if (std::memcmp(type, "MThd", 4) != 0 || length < 6) {
+        return fail("Not a Standard MIDI File");
+    }
+
+    m_chunkRemaining = length;
+    uint16_t format, division;
+    if (!readUint16(format) || !readUint16(trackCount) || !readUint16(division)) {
+        return false;
+    }
+    if (format > 1) {
+        return fail("Unsupported MIDI file format: " + std::to_string(format));
+    }
+    if (!skip(m_chunkRemaining)) {
+        return false;
+    }
+    data.format = format;
+
+    if (division & 0x8000) {
+        // SMPTE: negative frames per second in the high byte, ticks per frame in the low byte
+        int framesPerSecond = -static_cast<int8_t>(division >> 8);
+        int ticksPerFrame = division & 0xFF;
+        double fps = framesPerSecond == 29 ? 29.97 : static_cast<double>(framesPerSecond);
+        if (fps <= 0.0 || ticksPerFrame == 0) {
+            return fail("Invalid SMPTE division");
+        }
+        m_smpte = true;
+        m_ticksPerSecond = fps * ticksPerFrame;
+        m_tempoChanges.push_back({0.0, 0.0, 0.5});
+    } else {
+        if (division == 0) {
+            return fail("Invalid ticks-per-quarter-note division");
+        }
+        m_smpte = false;
+        m_ticksPerBeat = division;
+        data.ticksPerBeat = division;
+    }
+    return true;
+}
+
+double MidiFileReader::tickToBeat(uint64_t tick) const {
+    if (!m_smpte) {
+        return static_cast<double>(tick) / m_ticksPerBeat;
+    }
+    double seconds = static_cast<double>(tick) / m_ticksPerSecond;
+    auto it = std::upper_bound(m_tempoChanges.begin(), m_tempoChanges.end(), seconds,
+                               [](double s, const TempoChange& change) { return s < change.seconds; });
+    const TempoChange& change = *(it - 1);
+    return change.beat + (seconds - change.seconds) / change.secondsPerBeat;
+}
+
+void MidiFileReader::addTempo(MidiFileData& data, uint64_t tick, uint32_t microsecondsPerBeat) {
+    if (microsecondsPerBeat == 0) {
+        return;
+    }
+    data.tempos.push_back({tickToBeat(tick), 60000000.0 / microsecondsPerBeat});
+    if (!m_smpte) {
+        return;
+    }
+
+    // SMPTE ticks are wall-clock time, so beats depend on every tempo change
+    double seconds = static_cast<double>(tick) / m_ticksPerSecond;
+    double beat = tickToBeat(tick);
+    double secondsPerBeat = microsecondsPerBeat / 1000000.0;
+    if (m_tempoChanges.back().seconds >= seconds) {
+        m_tempoChanges.back().secondsPerBeat = secondsPerBeat;
+    } else {
+        m_tempoChanges.push_back({seconds, beat, secondsPerBeat});
+    }
+}
+
+bool MidiFileReader::readTrack(MidiFileData& data) {
+    std::vector<std::vector<PendingNote>> pending(16 * 128);
+    int trackIndex[16];
+    std::fill(trackIndex, trackIndex + 16, -1);
+    std::string trackName;
+
+    uint64_t tick = 0;
+    uint8_t runningStatus = 0;
+
+    auto closeNote = [&](int channel, int key, uint64_t endTick) {
+        std::vector<PendingNote>& queue = pending[channel * 128 + key];
+        if (queue.empty()) {
+            return;  // Stray note off
+        }
+        PendingNote note = queue.front();
+        queue.erase(queue.begin());
+
+        if (trackIndex[channel] < 0) {
+            trackIndex[channel] = static_cast<int>(data.tracks.size());
+            data.tracks.emplace_back();
+            data.tracks.back().name = trackName;
+            data.tracks.back().channel = channel;
+        }
+
+        double start = tickToBeat(note.startTick);
+        double end = tickToBeat(std::max(endTick, note.startTick + 1));
+        data.tracks[trackIndex[channel]].notes.push_back(
+            {start, end - start, static_cast<uint8_t>(key), note.velocity});
+    };
+
+    while (m_chunkRemaining > 0) {
+        uint32_t delta;
+        if (!readVarLen(delta)) {
+            return false;
+        }
+        tick += delta;
+
+        uint8_t status;
+        if (!readByte(status)) {
+            return false;
+        }
+
+        uint8_t first = 0;
+        if (status < 0x80) {
+            // Running status: this byte is the first data byte
+            if (runningStatus == 0) {
+                return fail("Data byte without a running status");
+            }
+            first = status;
+            status = runningStatus;
+        } else if (status < 0xF0) {
+            runningStatus = status;
+            if (!readByte(first)) {
+                return false;
+            }
+        }
+
+        if (status < 0xF0) {
+            int channel = status & 0x0F;
+            uint8_t second = 0;
+            int kind = status & 0xF0;
+            if (kind != 0xC0 && kind != 0xD0 && !readByte(second)) {
+                return false;
+            }
+
+            // Data bytes are 7-bit; a malformed file mustn't yield velocities over 127
+            int key = first & 0x7F;
+            second &= 0x7F;
+            if (kind == 0x90 && second > 0) {
+                pending[channel * 128 + key].push_back({tick, second});
+            } else if (kind == 0x80 || kind == 0x90) {
+                closeNote(channel, key, tick);
+            }
+            continue;
+        }
+
+        // System messages cancel running status
+        runningStatus = 0;
+
+        if (status == 0xF0 || status == 0xF7) {
+            uint32_t size;
+            if (!readVarLen(size) || !skip(size)) {
+                return false;
+            }
+        } else if (status == 0xFF) {
+            uint8_t type;
+            uint32_t size;
+            if (!readByte(type) || !readVarLen(size)) {
+                return false;
+            }
+
+            if (type == 0x2F) {
+                // End of track
+                if (!skip(std::min<uint64_t>(size, m_chunkRemaining)) || !skip(m_chunkRemaining)) {
+                    return false;
+                }
+                break;
+            } else if (type == 0x51 && size == 3) {
+                uint8_t bytes[3];
+                if (!readBytes(bytes, 3)) {
+                    return false;
+                }
+                addTempo(data, tick, (bytes[0] << 16) | (bytes[1] << 8) | bytes[2]);
+            } else if (type == 0x58 && size >= 2) {
+                uint8_t bytes[2];
+                if (!readBytes(bytes, 2) || !skip(size - 2)) {
+                    return false;
+                }
+                data.timeSignatures.push_back({tickToBeat(tick), std::max<int>(1, bytes[0]),
+                                               1 << std::min<int>(bytes[1], 6)});
+            } else if (type == 0x03 && trackName.empty()) {
+                trackName.resize(std::min<uint32_t>(size, 256));
+                if (!readBytes(reinterpret_cast<uint8_t*>(&trackName[0]), trackName.size()) ||
+                    !skip(size - trackName.size())) {
+                    return false;
+                }
+            } else if (!skip(size)) {
+                return false;
+            }
+        } else {
+            return fail("Unexpected system message in track");
+        }
+    }
+
+    // Close notes still held at the end of the track
+    for (int channel = 0; channel < 16; channel++) {
+        for (int key = 0; key < 128; key++) {
+            while (!pending[channel * 128 + key].empty()) {
+                closeNote(channel, key, tick);
+            }
+        }
+    }
+
+    return true;
+}
+
+MidiFileWriter::MidiFileWriter()
+    : m_buffer(BUFFER_SIZE) {
+}
+
+MidiFileWriter::~MidiFileWriter() {
+    if (m_file) {
+        fclose(m_file);
+    }
+}
+
+bool MidiFileWriter::fail(const std::string& message) {
+    if (m_error.empty()) {
+        m_error = message;
+    }
+    return false;
+}
+
+bool MidiFileWriter::flush() {
+    if (m_bufferUsed > 0 && fwrite(m_buffer.data(), 1, m_bufferUsed, m_file) != m_bufferUsed) {
+        return fail("Write failed");
+    }
+    m_bufferUsed = 0;
+    return true;
+}
+
+bool MidiFileWriter::put(const uint8_t* bytes, size_t count) {
+    while (count > 0) {
+        if (m_bufferUsed == m_buffer.size() && !flush()) {
+            return false;
+        }
+        size_t step = std::min(count, m_buffer.size() - m_bufferUsed);
+        std::memcpy(m_buffer.data() + m_bufferUsed, bytes, step);
+        m_bufferUsed += step;
+        bytes += step;
+        count -= step;
+    }
+    return true;
+}
+
+bool MidiFileWriter::writeChunk(const char* type) {
+    uint32_t length = static_cast<uint32_t>(m_chunk.size());
+    uint8_t header[8] = {
+        static_cast<uint8_t>(type[0]), static_cast<uint8_t>(type[1]),
+        static_cast<uint8_t>(type[2]), static_cast<uint8_t>(type[3]),
+        static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+        static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)};
+    return put(header, sizeof(header)) && put(m_chunk.data(), m_chunk.size());
+}
+
+void MidiFileWriter::appendVarLen(uint32_t value) {
+    uint8_t bytes[5];
+    int count = 0;
+    bytes[count++] = value & 0x7F;
+    while (value >>= 7) {
+        bytes[count++] = static_cast<uint8_t>((value & 0x7F) | 0x80);
+    }
+    while (count > 0) {
+        m_chunk.push_back(bytes[--count]);
+    }
+}
+
+void MidiFileWriter::encodeConductor(const MidiFileData& data) {
+    m_chunk.clear();
+
+    std::vector<MidiFileTempo> tempos = data.tempos;
+    if (tempos.empty()) {
+        tempos.push_back({0.0, 120.0});
+    }
+    std::vector<MidiFileTimeSignature> timeSignatures = data.timeSignatures;
+    if (timeSignatures.empty()) {
+        timeSignatures.push_back({0.0, 4, 4});
+    }
+
+    // Merge both lists in tick order, time signatures first on ties
+    auto toTick = [this](double beat) {
+        return static_cast<uint64_t>(std::llround(std::max(0.0, beat) * m_ticksPerBeat));
+    };
+    uint64_t lastTick = 0;
+    size_t t = 0;
+    size_t s = 0;
+    while (t < tempos.size() || s < timeSignatures.size()) {
+        bool signature = s < timeSignatures.size() &&
+                         (t == tempos.size() || toTick(timeSignatures[s].beat) <= toTick(tempos[t].beat));
+        uint64_t tick = signature ? toTick(timeSignatures[s].beat) : toTick(tempos[t].beat);
+        appendVarLen(static_cast<uint32_t>(std::min<uint64_t>(tick - lastTick, 0x0FFFFFFF)));
+        lastTick = tick;
+
+        if (signature) {
+            // Denominator is stored as a power of two
+            const MidiFileTimeSignature& timeSignature = timeSignatures[s++];
+            uint8_t denominatorPower = 0;
+            while ((2 << denominatorPower) <= timeSignature.denominator && denominatorPower < 6) {
+                denominatorPower++;
+            }
+            m_chunk.insert(m_chunk.end(), {0xFF, 0x58, 0x04,
+                                           static_cast<uint8_t>(std::max(1, std::min(255, timeSignature.numerator))),
+                                           denominatorPower, 24, 8});
+        } else {
+            const MidiFileTempo& tempo = tempos[t++];
+            double bpm = tempo.bpm > 0.0 ? tempo.bpm : 120.0;
+            uint32_t microsecondsPerBeat = static_cast<uint32_t>(
+                std::min(16777215.0, std::round(60000000.0 / bpm)));
+            m_chunk.insert(m_chunk.end(), {0xFF, 0x51, 0x03,
+                                           static_cast<uint8_t>(microsecondsPerBeat >> 16),
+                                           static_cast<uint8_t>(microsecondsPerBeat >> 8),
+                                           static_cast<uint8_t>(microsecondsPerBeat)});
+        }
+    }
+
+    appendVarLen(0);
+    m_chunk.insert(m_chunk.end(), {0xFF, 0x2F, 0x00});
+}
+
+void MidiFileWriter::encodeTrack(const MidiFileTrack& track) {
+    struct Event {
+        uint64_t tick;
+        uint8_t noteNumber;
+        uint8_t velocity;  // 0 = note off
+    };
+
+    std::vector<Event> events;
+    events.reserve(track.notes.size() * 2);
+    for (const MidiFileNote& note : track.notes) {
+        uint64_t start = static_cast<uint64_t>(std::llround(std::max(0.0, note.startBeat) * m_ticksPerBeat));
+        uint64_t end = static_cast<uint64_t>(
+            std::llround(std::max(0.0, note.startBeat + note.durationBeats) * m_ticksPerBeat));
+        uint8_t noteNumber = note.noteNumber & 0x7F;
+        events.push_back({start, noteNumber, static_cast<uint8_t>(std::max(1, note.velocity & 0x7F))});
+        events.push_back({std::max(end, start + 1), noteNumber, 0});
+    }
+    // Note offs first on ties so a retriggered note isn't cut short
+    std::stable_sort(events.begin(), events.end(), [](const Event& a, const Event& b) {
+        if (a.tick != b.tick) return a.tick < b.tick;
+        return a.velocity == 0 && b.velocity != 0;
+    });
+
+    m_chunk.clear();
+    if (!track.name.empty()) {
+        size_t length = std::min<size_t>(track.name.size(), 127);
+        appendVarLen(0);
+        m_chunk.insert(m_chunk.end(), {0xFF, 0x03, static_cast<uint8_t>(length)});
+        m_chunk.insert(m_chunk.end(), track.name.begin(), track.name.begin() + length);
+    }
+
+    uint8_t status = static_cast<uint8_t>(0x90 | (track.channel & 0x0F));
+    uint8_t runningStatus = 0;
+    uint64_t tick = 0;
+    for (const Event& event : events) {
+        appendVarLen(static_cast<uint32_t>(std::min<uint64_t>(event.tick - tick, 0x0FFFFFFF)));
+        tick = event.tick;
+        if (status != runningStatus) {
+            m_chunk.push_back(status);
+            runningStatus = status;
+        }
+        m_chunk.push_back(event.noteNumber);
+        m_chunk.push_back(event.velocity);
+    }
+
+    appendVarLen(0);
+    m_chunk.insert(m_chunk.end(), {0xFF, 0x2F, 0x00});
+}
+
+bool MidiFileWriter::write(const std::string& path, const MidiFileData& data) {
+    m_error.clear();
+    m_bufferUsed = 0;
+    m_ticksPerBeat = data.ticksPerBeat > 0 && data.ticksPerBeat <= 0x7FFF ? data.ticksPerBeat : DEFAULT_TICKS_PER_BEAT;
+
+    std::string tempPath = path + ".tmp";
+    m_file = fopen(tempPath.c_str(), "wb");
+    if (!m_file) {
+        return fail("Cannot create file: " + tempPath);
+    }
+
+    uint16_t trackCount = static_cast<uint16_t>(std::min<size_t>(data.tracks.size() + 1, 0xFFFF));
+    m_chunk = {0x00, 0x01,
+               static_cast<uint8_t>(trackCount >> 8), static_cast<uint8_t>(trackCount),
+               static_cast<uint8_t>(m_ticksPerBeat >> 8), static_cast<uint8_t>(m_ticksPerBeat & 0xFF)};
+    bool ok = writeChunk("MThd");
+
+    encodeConductor(data);
+    ok = ok && writeChunk("MTrk");
+
+    for (size_t i = 0; ok && i + 1 < trackCount; i++) {
+        encodeTrack(data.tracks[i]);
+        ok = writeChunk("MTrk");
+    }
+
+    ok = ok && flush();
+    if (fclose(m_file) != 0) {
+        ok = fail("Write failed");
+    }
+    m_file = nullptr;
+
+    if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        return fail("Cannot write file: " + path);
+    }
+    return true;
+}
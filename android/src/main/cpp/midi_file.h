@@ -0,0 +1,142 @@
+#ifndef MIDI_FILE_H
+#define MIDI_FILE_H
+
+#include <cstdint>
+#include <cstdio>
+#include <functional>
+#include <string>
+#include <vector>
+
+// A note read from a Standard MIDI File, positioned in beats
+struct MidiFileNote {
+    double startBeat;
+    double durationBeats;
+    uint8_t noteNumber;
+    uint8_t velocity;
+};
+
+// Notes of one channel of one MTrk chunk
+struct MidiFileTrack {
+    std::string name;
+    int channel = 0;
+    std::vector<MidiFileNote> notes;
+};
+
+// Tempo and time signature meta events, positioned in beats
+struct MidiFileTempo {
+    double beat;
+    double bpm;
+};
+
+struct MidiFileTimeSignature {
+    double beat;
+    int numerator;
+    int denominator;
+};
+
+// Contents of a Standard MIDI File relevant to sequencing
+struct MidiFileData {
+    int format = 0;
+    int ticksPerBeat = 0;                               // PPQ division; 0 for SMPTE timing
+    std::vector<MidiFileTempo> tempos;                  // Sorted by beat; none means 120 BPM
+    std::vector<MidiFileTimeSignature> timeSignatures;  // Sorted by beat; none means 4/4
+    std::vector<MidiFileTrack> tracks;
+};
+
+// Streaming Standard MIDI File (type 0 and 1) parser.
+//
+// The file is read through a fixed-size buffer and events are decoded as they
+// stream past, so memory use is bounded by the notes produced rather than the
+// file size. Each MTrk is split by channel into separate tracks. PPQ files map
+// ticks straight to beats; SMPTE files go through the tempo changes read so far.
+class MidiFileReader {
+public:
+    MidiFileReader();
+    ~MidiFileReader();
+
+    bool read(const std::string& path, MidiFileData& data);
+    const std::string& getError() const { return m_error; }
+
+    // Called with the fraction of tracks read (0-1) after each MTrk chunk
+    void setProgressCallback(std::function<void(float)> callback) { m_onProgress = std::move(callback); }
+
+private:
+    struct TempoChange {
+        double seconds;
+        double beat;
+        double secondsPerBeat;
+    };
+
+    bool fail(const std::string& message);
+    bool fill();
+    bool readByte(uint8_t& value);
+    bool readBytes(uint8_t* out, size_t count);
+    bool skip(uint64_t count);
+    bool readUint16(uint16_t& value);
+    bool readUint32(uint32_t& value);
+    bool readVarLen(uint32_t& value);
+
+    bool readChunks(MidiFileData& data);
+    bool readHeader(MidiFileData& data, uint16_t& trackCount);
+    bool readTrack(MidiFileData& data);
+    double tickToBeat(uint64_t tick) const;
+    void addTempo(MidiFileData& data, uint64_t tick, uint32_t microsecondsPerBeat);
+
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    FILE* m_file = nullptr;
+    std::vector<uint8_t> m_buffer;
+    size_t m_bufferPos = 0;
+    size_t m_bufferEnd = 0;
+    uint64_t m_chunkRemaining = 0;  // Bytes left in the current chunk
+
+    // Timebase
+    bool m_smpte = false;
+    double m_ticksPerBeat = 480.0;
+    double m_ticksPerSecond = 0.0;
+    std::vector<TempoChange> m_tempoChanges;
+
+    std::function<void(float)> m_onProgress;
+    std::string m_error;
+};
+
+// Standard MIDI File (type 1) writer.
+//
+// Writes a conductor track with the tempo and time signature changes followed
+// by one MTrk per track. Note offs are written as zero-velocity note ons so running
+// status covers every channel event. Each track is encoded into memory, since
+// its chunk length precedes it, and the file goes out through a fixed-size
+// buffer into a temporary file that replaces the target only once complete.
+class MidiFileWriter {
+public:
+    // Used when the data has no division of its own
+    static constexpr int DEFAULT_TICKS_PER_BEAT = 480;
+
+    MidiFileWriter();
+    ~MidiFileWriter();
+
+    bool write(const std::string& path, const MidiFileData& data);
+    const std::string& getError() const { return m_error; }
+
+private:
+    bool fail(const std::string& message);
+    bool put(const uint8_t* bytes, size_t count);
+    bool flush();
+    bool writeChunk(const char* type);
+
+    void appendVarLen(uint32_t value);
+    void encodeConductor(const MidiFileData& data);
+    void encodeTrack(const MidiFileTrack& track);
+
+    static constexpr size_t BUFFER_SIZE = 64 * 1024;
+
+    FILE* m_file = nullptr;
+    std::vector<uint8_t> m_buffer;
+    size_t m_bufferUsed = 0;
+    std::vector<uint8_t> m_chunk;  // Body of the chunk being encoded
+    int m_ticksPerBeat = DEFAULT_TICKS_PER_BEAT;
+
+    std::string m_error;
+};
+
+#endif // MIDI_FILE_H
@@ -0,0 +1,239 @@
+#include "mixer.h"
+#include "audio_tap.h"
+#include "dsp_kernels.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+Mixer::Mixer() {
+    // The master bus is always present
+    m_strips[MASTER_BUS].inUse.store(true);
+    for (auto& strip : m_strips) {
+        panGains(1.0f, 0.0f, strip.leftGain, strip.rightGain);
+    }
+}
+
+void Mixer::setSampleRate(int sampleRate) {
+    m_sampleRate = std::max(1, sampleRate);
+}
+
+int Mixer::acquireBus(int32_t tag) {
+    for (int bus = MASTER_BUS + 1; bus < MAX_BUSES; bus++) {
+        bool expected = false;
+        if (m_strips[bus].inUse.compare_exchange_strong(expected, true)) {
+            m_strips[bus].tag.store(tag, std::memory_order_relaxed);
+            m_strips[bus].gain.store(1.0f, std::memory_order_relaxed);
+            m_strips[bus].pan.store(0.0f, std::memory_order_relaxed);
+            m_strips[bus].snap.store(true, std::memory_order_release);
+            return bus;
+        }
+    }
+    return -1;
+}
+
+void Mixer::releaseBus(int bus) {
+    if (bus > MASTER_BUS && bus < MAX_BUSES) {
+        m_strips[bus].inUse.store(false);
+    }
+}
+
+bool Mixer::setBusGain(int bus, float gain) {
+    if (bus < 0 || bus >= MAX_BUSES || !std::isfinite(gain) || gain < 0.0f) {
+        return false;
+    }
+    m_strips[bus].gain.store(gain, std::memory_order_relaxed);
+    return true;
+}
+
+bool Mixer::setBusPan(int bus, float pan) {
+    if (bus < 0 || bus >= MAX_BUSES || !std::isfinite(pan)) {
+        return false;
+    }
+    m_strips[bus].pan.store(std::max(-1.0f, std::min(1.0f, pan)), std::memory_order_relaxed);
+    return true;
+}
+
+// Equal-power pan law: constant total power, -3 dB per side at centre
+void Mixer::panGains(float gain, float pan, float& left, float& right) {
+    float angle = (pan + 1.0f) * static_cast<float>(M_PI) * 0.25f;
+    left = gain * std::cos(angle);
+    right = gain * std::sin(angle);
+}
+
+void Mixer::rampBusAutomation(int bus, float target, int numFrames) {
+    if (bus < 0 || bus >= MAX_BUSES || numFrames <= 0 || !std::isfinite(target)) {
+        return;
+    }
+    Strip& strip = m_strips[bus];
+    strip.automationStep = (target - strip.automationGain) / static_cast<float>(numFrames);
+    strip.automationFrames = numFrames;
+}
+
+float* Mixer::busBuffer(int bus, int numFrames) {
+    if (bus < 0 || bus >= MAX_BUSES) {
+        bus = MASTER_BUS;
+    }
+    Strip& strip = m_strips[bus];
+    if (!strip.touched) {
+        std::memset(m_busBuffers[bus], 0, sizeof(float) * numFrames);
+        strip.touched = true;
+    }
+    return m_busBuffers[bus];
+}
+
+void Mixer::mixBlock(float* output, int numFrames) {
+    numFrames = std::min(numFrames, MAX_BLOCK_FRAMES);
+    float smoothing = 1.0f - std::exp(-static_cast<float>(numFrames) /
+                                      (SMOOTHING_MS * 0.001f * static_cast<float>(m_sampleRate)));
+
+    for (int bus = 0; bus < MAX_BUSES; bus++) {
+        Strip& strip = m_strips[bus];
+
+        // Move towards the target with a one-pole step per block and ramp
+        // linearly across the block, so every sample gets its own gain
+        float targetLeft, targetRight;
+        panGains(strip.gain.load(std::memory_order_relaxed),
+                 strip.pan.load(std::memory_order_relaxed), targetLeft, targetRight);
+
+        if (strip.snap.exchange(false, std::memory_order_acquire)) {
+            strip.leftGain = targetLeft;
+            strip.rightGain = targetRight;
+            strip.automationGain = 1.0f;
+            strip.automationFrames = 0;
+        }
+
+        float startLeft = strip.leftGain;
+        float startRight = strip.rightGain;
+        strip.leftGain += (targetLeft - startLeft) * smoothing;
+        strip.rightGain += (targetRight - startRight) * smoothing;
+
+        // Automation ramps are set per callback; consume this block's share
+        float startAutomation = strip.automationGain;
+        if (strip.automationFrames > 0) {
+            int frames = std::min(numFrames, strip.automationFrames);
+            strip.automationGain += strip.automationStep * static_cast<float>(frames);
+            strip.automationFrames -= frames;
+        }
+
+        if (!strip.touched) {
+            if (strip.tap) {
+                strip.tap->writeSilence(numFrames);
+            }
+            continue;
+        }
+        strip.touched = false;
+
+        float invFrames = 1.0f / static_cast<float>(numFrames);
+        float fromLeft = startLeft * startAutomation;
+        float fromRight = startRight * startAutomation;
+        float toLeft = strip.leftGain * strip.automationGain;
+        float toRight = strip.rightGain * strip.automationGain;
+        dsp::mixMonoToStereo(m_busBuffers[bus], output, numFrames,
+                             fromLeft, (toLeft - fromLeft) * invFrames,
+                             fromRight, (toRight - fromRight) * invFrames);
+
+        // A tapped bus also mixes into its own stereo buffer for the tap
+        if (strip.tap) {
+            std::memset(m_tapBuffer, 0, sizeof(float) * numFrames * 2);
+            dsp::mixMonoToStereo(m_busBuffers[bus], m_tapBuffer, numFrames,
+                                 fromLeft, (toLeft - fromLeft) * invFrames,
+                                 fromRight, (toRight - fromRight) * invFrames);
+            strip.tap->write(m_tapBuffer, numFrames);
+        }
+
+        // Meter the pre-fader bus signal and scale it by this block's fader gains
+        float peak, sumSquares;
+        dsp::peakAndSumSquares(m_busBuffers[bus], numFrames, peak, sumSquares);
+        float maxGain = std::max(std::max(fromLeft, toLeft), std::max(fromRight, toRight));
+        float meanLeft = 0.5f * (fromLeft + toLeft);
+        float meanRight = 0.5f * (fromRight + toRight);
+        strip.meter.blockPeak = std::max(strip.meter.blockPeak, peak * maxGain);
+        strip.meter.sumSquares += sumSquares * 0.5f * (meanLeft * meanLeft + meanRight * meanRight);
+    }
+}
+
+float Mixer::meterSmoothing(int numFrames) const {
+    return std::exp(-static_cast<float>(numFrames) / (METER_RMS_MS * 0.001f * static_cast<float>(m_sampleRate)));
+}
+
+void Mixer::Meter::publish(int numFrames, float smoothing) {
+    float blockMeanSquare = sumSquares / static_cast<float>(std::max(1, numFrames));
+    meanSquare = blockMeanSquare + (meanSquare - blockMeanSquare) * smoothing;
+
+    // Keep the highest peak until a reader collects it
+    if (blockPeak > peak.load(std::memory_order_relaxed)) {
+        peak.store(blockPeak, std::memory_order_relaxed);
+    }
+    rms.store(std::sqrt(meanSquare), std::memory_order_relaxed);
+
+    blockPeak = 0.0f;
+    sumSquares = 0.0f;
+}
+
+MeterReading Mixer::Meter::read() {
+    MeterReading reading;
+    reading.peak = peak.exchange(0.0f, std::memory_order_relaxed);
+    reading.rms = rms.load(std::memory_order_relaxed);
+    return reading;
+}
+
+void Mixer::publishMeters(int numFrames) {
+    float smoothing = meterSmoothing(numFrames);
+    for (auto& strip : m_strips) {
+        strip.meter.publish(numFrames, smoothing);
+    }
+}
+
+void Mixer::meterMaster(const float* output, int numFrames) {
+    float peak, sumSquares;
+    dsp::peakAndSumSquares(output, numFrames * 2, peak, sumSquares);
+    m_masterMeter.blockPeak = peak;
+    m_masterMeter.sumSquares = sumSquares * 0.5f;  // Mean over both channels
+    m_masterMeter.publish(numFrames, meterSmoothing(numFrames));
+}
+
+bool Mixer::addTap(AudioTap* tap) {
+    for (auto& slot : m_taps) {
+        AudioTap* expected = nullptr;
+        if (slot.compare_exchange_strong(expected, tap, std::memory_order_release)) {
+            return true;
+        }
+    }
+    return false;
+}
+
+void Mixer::commitTaps(int numFrames, int64_t blockStartFrame) {
+    for (auto& strip : m_strips) {
+        strip.tap = nullptr;
+    }
+    for (auto& slot : m_taps) {
+        AudioTap* tap = slot.load(std::memory_order_acquire);
+        if (!tap) {
+            continue;
+        }
+        tap->commit(numFrames, blockStartFrame);
+
+        // Buses are reassigned as tracks come and go, so follow the tag
+        for (int bus = MASTER_BUS + 1; bus < MAX_BUSES; bus++) {
+            Strip& strip = m_strips[bus];
+            if (strip.inUse.load(std::memory_order_relaxed) &&
+                strip.tag.load(std::memory_order_relaxed) == tap->source()) {
+                strip.tap = tap;
+                break;
+            }
+        }
+    }
+}
+
+bool Mixer::readBusMeter(int bus, int32_t& tag, MeterReading& reading) {
+    if (bus <= MASTER_BUS || bus >= MAX_BUSES || !m_strips[bus].inUse.load(std::memory_order_relaxed)) {
+        return false;
+    }
+    tag = m_strips[bus].tag.load(std::memory_order_relaxed);
+    reading = m_strips[bus].meter.read();
+    return true;
+}
+
+MeterReading Mixer::readMasterMeter() {
+    return m_masterMeter.read();
+}
@@ -0,0 +1,117 @@
+#ifndef MIXER_H
+#define MIXER_H
+
+#include <atomic>
+#include <cstdint>
+
+class AudioTap;
+
+// Level of one meter: peak since the last read and smoothed RMS, both linear
+struct MeterReading {
+    float peak = 0.0f;
+    float rms = 0.0f;
+};
+
+// Per-track mixer strips.
+//
+// Voices render mono into a bus buffer; mixBlock() then applies each bus's
+// gain and equal-power pan and sums it into the stereo output. Gain and pan
+// are written by control threads through atomics and smoothed on the audio
+// thread, so parameter changes never take a lock and never step the signal.
+// Post-fader meter levels flow the other way, published through atomics.
+class Mixer {
+public:
+    static constexpr int MAX_BUSES = 64;
+    static constexpr int MASTER_BUS = 0;         // Notes not played from a track
+    static constexpr int MAX_BLOCK_FRAMES = 32;  // Largest block mixBlock() accepts
+    static constexpr int MAX_TAPS = 16;
+
+    Mixer();
+
+    void setSampleRate(int sampleRate);
+
+    // Claim a free bus with unity gain and centre pan; returns -1 if none is left.
+    // The tag identifies the owner (e.g. a track ID) to meter readers.
+    int acquireBus(int32_t tag = -1);
+    void releaseBus(int bus);
+
+    // Control-thread setters (lock-free). Gain is linear, pan is in [-1, 1].
+    bool setBusGain(int bus, float gain);
+    bool setBusPan(int bus, float pan);
+
+    // Audio thread: ramp the bus's automation gain (applied on top of the
+    // control gain) linearly to target over the next numFrames frames
+    void rampBusAutomation(int bus, float target, int numFrames);
+
+    // Audio thread: mono scratch buffer for a bus, cleared on first use in a block
+    float* busBuffer(int bus, int numFrames);
+
+    // Audio thread: mix every bus used this block into interleaved stereo output
+    void mixBlock(float* output, int numFrames);
+
+    // Audio thread: publish bus meters once per callback, then meter the final
+    // interleaved master output
+    void publishMeters(int numFrames);
+    void meterMaster(const float* output, int numFrames);
+
+    // Control thread: feed a track tap from whichever bus is tagged with its
+    // source track ID, post-fader. The tap must outlive the mixer; false if
+    // every tap slot is taken.
+    bool addTap(AudioTap* tap);
+
+    // Audio thread: publish this callback's track tap blocks (silence for
+    // tracks that didn't play) and match taps to buses for the next callback
+    void commitTaps(int numFrames, int64_t blockStartFrame);
+
+    // Control threads: read a meter; the peak restarts from zero after each read
+    bool readBusMeter(int bus, int32_t& tag, MeterReading& reading);
+    MeterReading readMasterMeter();
+
+private:
+    struct Meter {
+        std::atomic<float> peak{0.0f};
+        std::atomic<float> rms{0.0f};
+
+        // Audio thread accumulators for the current callback
+        float blockPeak = 0.0f;
+        float sumSquares = 0.0f;
+        float meanSquare = 0.0f;  // Smoothed across callbacks
+
+        void publish(int numFrames, float smoothing);
+        MeterReading read();
+    };
+
+    struct Strip {
+        std::atomic<float> gain{1.0f};
+        std::atomic<float> pan{0.0f};
+        std::atomic<bool> inUse{false};
+        std::atomic<bool> snap{false};  // Jump straight to the target on next block
+        std::atomic<int32_t> tag{-1};
+        Meter meter;
+
+        // Audio thread state
+        float leftGain = 0.0f;
+        float rightGain = 0.0f;
+        float automationGain = 1.0f;
+        float automationStep = 0.0f;
+        int automationFrames = 0;  // Frames left in the current automation ramp
+        bool touched = false;
+        AudioTap* tap = nullptr;  // Track tap this bus feeds, resolved per callback
+    };
+
+    static void panGains(float gain, float pan, float& left, float& right);
+
+    float meterSmoothing(int numFrames) const;
+
+    static constexpr float SMOOTHING_MS = 10.0f;
+    static constexpr float METER_RMS_MS = 300.0f;
+
+    int m_sampleRate = 44100;
+    Strip m_strips[MAX_BUSES];
+    Meter m_masterMeter;
+    std::atomic<AudioTap*> m_taps[MAX_TAPS] = {};
+    alignas(16) float m_busBuffers[MAX_BUSES][MAX_BLOCK_FRAMES];
+    alignas(16) float m_tapBuffer[MAX_BLOCK_FRAMES * 2];
+};
+
+#endif // MIXER_H
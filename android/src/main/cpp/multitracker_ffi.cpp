@@ -12,7 +12,11 @@
 #include "audio_engine.h"
 #include "instrument_manager.h"
 #include "sequence_manager.h"
+#include "command_buffer.h"
+#include "meter_publisher.h"
+#include "event_publisher.h"
 #include "utils.h"
+#include "dart_api_dl.h"
 
 #define LOG_TAG "MultiTrackerFFI"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
@@ -34,6 +38,9 @@ static std::mutex g_mutex;
 // Dart port for callbacks
 static int64_t g_dart_port = 0;
 
+// Streams meter levels to the Dart port
+static std::unique_ptr<MeterPublisher> g_meterPublisher;
+
 // Constants
 #define FFI_SUCCESS 1
 #define FFI_FAILURE 0
@@ -44,6 +51,20 @@ int8_t handleError(const char* errorMsg) {
     return 0;
 }
 
+// Report instrument loading on the event stream; id is -1 until known
+static void reportInstrumentLoad(int instrumentId, float fraction) {
+    if (!g_audioEngine) {
+        return;
+    }
+    EngineEvent event = {};
+    event.frame = -1;
+    event.value = fraction;
+    event.id = instrumentId;
+    event.type = EngineEvent::LOAD_PROGRESS;
+    event.data1 = EngineEvent::LOAD_INSTRUMENT;
+    g_audioEngine->getEventPublisher().pushControl(event);
+}
+
 // FFI exported functions
 extern "C" {
 
@@ -62,6 +83,17 @@ register_dart_callback_port(int64_t port) {
     return (void*)1; // Return non-null pointer to indicate success
 }
 
+// Initialize the Dart API for posting messages; pass NativeApi.initializeApiDLData
+extern "C" JNIEXPORT int8_t JNICALL
+init_dart_api(void* data) {
+    LOGI("FFI: Initializing Dart API");
+    if (Dart_InitializeApiDL(data) != 0) {
+        LOGE("FFI: Dart API version mismatch");
+        return 0;
+    }
+    return 1;
+}
+
 // Initialize the audio engine
 extern "C" JNIEXPORT int8_t JNICALL
 init_audio_engine(int32_t sample_rate) {
@@ -208,22 +240,17 @@ dispose() {
     try {
         std::lock_guard<std::mutex> lock(g_mutex);
         
+        // Stop publishing before the mixer goes away
+        g_meterPublisher.reset();
+        
         if (g_audioEngine) {
             // Stop the audio engine if it's running
             g_audioEngine->stop();
         }
         
-        // Clean up the sequence manager
-        if (g_sequenceManager) {
-            delete g_sequenceManager;
-            g_sequenceManager = nullptr;
-        }
-        
-        // Clean up the instrument manager
-        if (g_instrumentManager) {
-            delete g_instrumentManager;
-            g_instrumentManager = nullptr;
-        }
+        // The managers are owned by the audio engine
+        g_sequenceManager = nullptr;
+        g_instrumentManager = nullptr;
         
         // Clean up the audio engine last
         if (g_audioEngine) {
@@ -256,11 +283,13 @@ int32_t load_instrument_sfz(const char* sfzPath) {
     
     try {
         // For now, just create a sine wave instrument since we haven't implemented SFZ yet
+        reportInstrumentLoad(-1, 0.0f);
         int32_t instrumentId = g_instrumentManager->createSineWaveInstrument(std::string(sfzPath));
         if (instrumentId < 0) {
             LOGE("FFI: Failed to load SFZ instrument");
             return -1;
         }
+        reportInstrumentLoad(instrumentId, 1.0f);
         
         LOGI("FFI: Created sine wave instrument with ID: %d", instrumentId);
         return instrumentId;
@@ -281,11 +310,13 @@ int32_t load_instrument_sf2(const char* sf2Path, int32_t preset, int32_t bank) {
     
     try {
         // For now, just create a sine wave instrument since we haven't implemented SF2 yet
+        reportInstrumentLoad(-1, 0.0f);
         int32_t instrumentId = g_instrumentManager->createSineWaveInstrument(std::string(sf2Path));
         if (instrumentId < 0) {
             LOGE("FFI: Failed to load SF2 instrument");
             return -1;
         }
+        reportInstrumentLoad(instrumentId, 1.0f);
         
         LOGI("FFI: Created sine wave instrument with ID: %d", instrumentId);
         return instrumentId;
@@ -340,6 +371,243 @@ int8_t stop_note(int32_t instrumentId, int32_t note) {
     }
 }
 
+// Play a live note at the frame matching a CLOCK_MONOTONIC timestamp, so taps
+// keep their spacing instead of snapping to buffer boundaries
+int8_t play_note_at(int32_t instrumentId, int32_t note, int32_t velocity, int64_t hostTimeNanos) {
+    LOGD("FFI: Playing note %d with velocity %d with instrument %d at %lld ns",
+         note, velocity, instrumentId, (long long)hostTimeNanos);
+    
+    if (!g_initialized || !g_audioEngine || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    try {
+        // Before the first callback there is no clock yet; play at once
+        int64_t frame = g_audioEngine->hostTimeToFrame(hostTimeNanos);
+        bool success = frame < 0 ? g_instrumentManager->sendNoteOn(instrumentId, note, velocity)
+                                 : g_instrumentManager->sendNoteOnAtFrame(instrumentId, note, velocity, frame);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when playing timed note: %s", e.what());
+        return 0;
+    }
+}
+
+// Stop a live note at the frame matching a CLOCK_MONOTONIC timestamp
+int8_t stop_note_at(int32_t instrumentId, int32_t note, int64_t hostTimeNanos) {
+    LOGD("FFI: Stopping note %d with instrument %d at %lld ns", note, instrumentId, (long long)hostTimeNanos);
+    
+    if (!g_initialized || !g_audioEngine || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    try {
+        int64_t frame = g_audioEngine->hostTimeToFrame(hostTimeNanos);
+        bool success = frame < 0 ? g_instrumentManager->sendNoteOff(instrumentId, note)
+                                 : g_instrumentManager->sendNoteOffAtFrame(instrumentId, note, frame);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when stopping timed note: %s", e.what());
+        return 0;
+    }
+}
+
+// Current CLOCK_MONOTONIC time in nanoseconds, for stamping live notes
+int64_t get_host_time_nanos() {
+    return AudioClock::hostTimeNanos();
+}
+
+// Shared clock state (AudioClockState) the audio thread republishes every
+// callback under a seqlock; valid until dispose
+const void* get_audio_clock() {
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return nullptr;
+    }
+    return g_audioEngine->getClockState();
+}
+
+// Shared-memory note input ring (see NoteInputRing) that Dart writes note
+// events into directly; the first call sets its capacity. Valid until dispose.
+uint8_t* create_note_input(int32_t capacity) {
+    LOGI("FFI: Creating note input ring with capacity %d", capacity);
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return nullptr;
+    }
+    
+    NoteInputRing* ring = g_audioEngine->getNoteInput(capacity);
+    return ring ? ring->data() : nullptr;
+}
+
+// Shared-memory tap (see AudioTap) of the rendered master output (trackId -1)
+// or one track; the first call for a source sets its capacity in frames.
+// Valid until dispose.
+uint8_t* create_audio_tap(int32_t trackId, int32_t capacityFrames) {
+    LOGI("FFI: Creating audio tap for track %d with %d frames", trackId, capacityFrames);
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return nullptr;
+    }
+    
+    AudioTap* tap = g_audioEngine->getAudioTap(trackId, capacityFrames);
+    return tap ? tap->data() : nullptr;
+}
+
+// Start recording the default input (1 or 2 channels) to a WAV file at path;
+// latencyMs is the measured round-trip latency to line the take up with
+int8_t start_recording(const char* path, int32_t channels, float latencyMs) {
+    LOGI("FFI: Starting recording to %s", path ? path : "(null)");
+    
+    if (!g_initialized || !g_audioEngine || !path) {
+        LOGE("FFI: Audio engine not initialized or no path given");
+        return 0;
+    }
+    
+    try {
+        return g_audioEngine->startRecording(path, channels, latencyMs) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when starting recording: %s", e.what());
+        return 0;
+    }
+}
+
+// Stop recording and finish the file; 0 if nothing was recording or the file
+// couldn't be completed
+int8_t stop_recording() {
+    LOGI("FFI: Stopping recording");
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_audioEngine->stopRecording() ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when stopping recording: %s", e.what());
+        return 0;
+    }
+}
+
+// Copy the current (or last) take's RecordingStatus into status
+int8_t get_recording_status(RecordingStatus* status) {
+    if (!g_initialized || !g_audioEngine || !status) {
+        LOGE("FFI: Audio engine not initialized or no status given");
+        return 0;
+    }
+    
+    *status = g_audioEngine->getRecordingStatus();
+    return 1;
+}
+
+// Set the fixed latency (ms) added to timed live notes; negative restores
+// the default of one buffer
+int8_t set_live_latency(float latencyMs) {
+    LOGI("FFI: Setting live note latency to %.2f ms", latencyMs);
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return 0;
+    }
+    
+    g_audioEngine->setLiveLatency(latencyMs);
+    return 1;
+}
+
+// Set the global polyphony limit
+int8_t set_max_polyphony(int32_t maxVoices) {
+    LOGI("FFI: Setting max polyphony to %d", maxVoices);
+    
+    if (!g_initialized || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_instrumentManager->setMaxPolyphony(maxVoices) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting max polyphony: %s", e.what());
+        return 0;
+    }
+}
+
+// Set the per-instrument polyphony limit (0 = global limit only) and stealing priority
+int8_t set_instrument_polyphony(int32_t instrumentId, int32_t maxVoices, int32_t priority) {
+    LOGI("FFI: Setting polyphony for instrument %d: maxVoices=%d, priority=%d",
+         instrumentId, maxVoices, priority);
+    
+    if (!g_initialized || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_instrumentManager->setInstrumentPolyphony(instrumentId, maxVoices, priority) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting instrument polyphony: %s", e.what());
+        return 0;
+    }
+}
+
+// Set the ADSR envelope used by new notes of an instrument (curve: 0 = linear, 1 = exponential)
+int8_t set_instrument_envelope(int32_t instrumentId, float attackMs, float decayMs,
+                               float sustainLevel, float releaseMs, int32_t curve) {
+    LOGI("FFI: Setting envelope for instrument %d", instrumentId);
+    
+    if (!g_initialized || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    if (curve < static_cast<int32_t>(EnvelopeCurve::LINEAR) ||
+        curve > static_cast<int32_t>(EnvelopeCurve::EXPONENTIAL)) {
+        LOGE("FFI: Invalid envelope curve: %d", curve);
+        return 0;
+    }
+    
+    try {
+        EnvelopeParams envelope;
+        envelope.attackMs = attackMs;
+        envelope.decayMs = decayMs;
+        envelope.sustainLevel = sustainLevel;
+        envelope.releaseMs = releaseMs;
+        envelope.curve = static_cast<EnvelopeCurve>(curve);
+        return g_instrumentManager->setInstrumentEnvelope(instrumentId, envelope) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting instrument envelope: %s", e.what());
+        return 0;
+    }
+}
+
+// Set the voice stealing policy (0 = oldest, 1 = quietest, 2 = lowest priority, 3 = same note)
+int8_t set_voice_stealing_policy(int32_t policy) {
+    LOGI("FFI: Setting voice stealing policy to %d", policy);
+    
+    if (!g_initialized || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    if (policy < static_cast<int32_t>(VoiceStealingPolicy::OLDEST) ||
+        policy > static_cast<int32_t>(VoiceStealingPolicy::SAME_NOTE)) {
+        LOGE("FFI: Invalid voice stealing policy: %d", policy);
+        return 0;
+    }
+    
+    try {
+        g_instrumentManager->setVoiceStealingPolicy(static_cast<VoiceStealingPolicy>(policy));
+        return 1;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting voice stealing policy: %s", e.what());
+        return 0;
+    }
+}
+
 // Create a sequence
 int32_t create_sequence(double bpm, int32_t timeSignatureNumerator, int32_t timeSignatureDenominator) {
     LOGI("FFI: Creating sequence with BPM: %f, time signature: %d/%d", bpm, timeSignatureNumerator, timeSignatureDenominator);
@@ -350,7 +618,7 @@ int32_t create_sequence(double bpm, int32_t timeSignatureNumerator, int32_t time
     }
     
     try {
-        int32_t sequenceId = g_sequenceManager->createSequence(bpm);
+        int32_t sequenceId = g_sequenceManager->createSequence(bpm, timeSignatureNumerator, timeSignatureDenominator);
         if (sequenceId < 0) {
             LOGE("FFI: Failed to create sequence");
             return -1;
@@ -364,6 +632,127 @@ int32_t create_sequence(double bpm, int32_t timeSignatureNumerator, int32_t time
     }
 }
 
+// Set the tick grid (ticks per beat) used by sequences created from now on
+int8_t set_ticks_per_beat(int32_t ticksPerBeat) {
+    LOGI("FFI: Setting tick grid to %d ticks per beat", ticksPerBeat);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        bool success = g_sequenceManager->setTicksPerBeat(ticksPerBeat);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting tick grid: %s", e.what());
+        return 0;
+    }
+}
+
+// Set how many audio blocks (1-16) the sequencer schedules ahead of playback
+int8_t set_scheduler_lookahead(int32_t blocks) {
+    LOGI("FFI: Setting scheduler lookahead to %d blocks", blocks);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        bool success = g_sequenceManager->setLookahead(blocks);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting scheduler lookahead: %s", e.what());
+        return 0;
+    }
+}
+
+// Add or replace a tempo change; with ramp set the tempo moves linearly to
+// the next change
+int8_t set_tempo_change(int32_t sequenceId, double beat, double bpm, int8_t ramp) {
+    LOGI("FFI: Setting tempo of sequence %d at beat %f to %f, ramp=%d", sequenceId, beat, bpm, ramp);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        bool success = g_sequenceManager->setTempoChange(sequenceId, beat, bpm, ramp != 0);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting tempo change: %s", e.what());
+        return 0;
+    }
+}
+
+// Remove a tempo change other than the one at beat 0
+int8_t remove_tempo_change(int32_t sequenceId, double beat) {
+    LOGI("FFI: Removing tempo change of sequence %d at beat %f", sequenceId, beat);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        bool success = g_sequenceManager->removeTempoChange(sequenceId, beat);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when removing tempo change: %s", e.what());
+        return 0;
+    }
+}
+
+// Add or replace a time signature change
+int8_t set_time_signature(int32_t sequenceId, double beat, int32_t numerator, int32_t denominator) {
+    LOGI("FFI: Setting time signature of sequence %d at beat %f to %d/%d", sequenceId, beat, numerator, denominator);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        bool success = g_sequenceManager->setTimeSignature(sequenceId, beat, numerator, denominator);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting time signature: %s", e.what());
+        return 0;
+    }
+}
+
+// Convert a beat to seconds through the sequence's tempo map; -1 on error
+double beat_to_seconds(int32_t sequenceId, double beat) {
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1.0;
+    }
+    
+    try {
+        return g_sequenceManager->beatToSeconds(sequenceId, beat);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when converting beat to seconds: %s", e.what());
+        return -1.0;
+    }
+}
+
+// Convert seconds to a beat through the sequence's tempo map; -1 on error
+double seconds_to_beat(int32_t sequenceId, double seconds) {
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1.0;
+    }
+    
+    try {
+        return g_sequenceManager->secondsToBeat(sequenceId, seconds);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when converting seconds to beat: %s", e.what());
+        return -1.0;
+    }
+}
+
 // Add track to sequence
 int32_t add_track(int32_t sequenceId, int32_t instrumentId) {
     LOGI("FFI: Adding track with instrument ID %d to sequence ID %d", instrumentId, sequenceId);
@@ -408,6 +797,131 @@ int8_t add_note(int32_t sequenceId, int32_t trackId, int32_t noteNumber,
     }
 }
 
+// Add notes in bulk from a packed NoteRecord array. outIds must hold count
+// entries and receives each note's ID, or -1 where a record was rejected.
+// Returns the number of notes added or -1 on error.
+int32_t add_notes_bulk(int32_t sequenceId, int32_t trackId, const NoteRecord* records,
+                       int32_t count, int32_t* outIds) {
+    LOGD("FFI: Adding %d notes to track %d in sequence %d", count, trackId, sequenceId);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    
+    try {
+        return g_sequenceManager->addNotes(sequenceId, trackId, records, count, outIds);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when adding notes: %s", e.what());
+        return -1;
+    }
+}
+
+// Fill out with up to capacity notes of a track overlapping [startBeat,
+// endBeat) with note numbers in [lowNote, highNote], in start order. Returns
+// the total number of matches, which may exceed capacity, or -1 on error.
+// Called per frame by piano-roll views, so it doesn't log on success.
+int32_t query_notes(int32_t sequenceId, int32_t trackId, double startBeat, double endBeat,
+                    int32_t lowNote, int32_t highNote, NoteQueryRecord* out, int32_t capacity) {
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    
+    try {
+        return g_sequenceManager->queryNotes(sequenceId, trackId, startBeat, endBeat,
+                                             lowNote, highNote, out, capacity);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when querying notes: %s", e.what());
+        return -1;
+    }
+}
+
+// Apply a buffer of encoded edit commands (see command_buffer.h) in one batch.
+// Returns the number of commands applied, or -1 if the buffer is malformed, in
+// which case nothing is applied.
+int32_t submit_commands(const uint8_t* data, int32_t length) {
+    LOGD("FFI: Submitting %d bytes of edit commands", length);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    if (length < 0) {
+        LOGE("FFI: Invalid command buffer length: %d", length);
+        return -1;
+    }
+    
+    try {
+        std::vector<EditCommand> commands;
+        std::string error;
+        if (!decodeCommands(data, static_cast<size_t>(length), commands, error)) {
+            LOGE("FFI: Malformed command buffer: %s", error.c_str());
+            return -1;
+        }
+        return g_sequenceManager->applyCommands(commands);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when applying commands: %s", e.what());
+        return -1;
+    }
+}
+
+// Undo the most recent sequence edit; returns 0 if there is nothing to undo
+int8_t undo() {
+    LOGD("FFI: Undo");
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_sequenceManager->undo() ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when undoing: %s", e.what());
+        return 0;
+    }
+}
+
+// Redo the most recently undone edit; returns 0 if there is nothing to redo
+int8_t redo() {
+    LOGD("FFI: Redo");
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_sequenceManager->redo() ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when redoing: %s", e.what());
+        return 0;
+    }
+}
+
+// Bound the undo history by number of levels and approximate memory in bytes
+int8_t set_undo_limits(int32_t maxLevels, int64_t maxBytes) {
+    LOGI("FFI: Setting undo limits to %d levels, %lld bytes", maxLevels, static_cast<long long>(maxBytes));
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    if (maxLevels < 0 || maxBytes < 0) {
+        LOGE("FFI: Invalid undo limits");
+        return 0;
+    }
+    
+    try {
+        g_sequenceManager->setUndoLimits(maxLevels, static_cast<size_t>(maxBytes));
+        return 1;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting undo limits: %s", e.what());
+        return 0;
+    }
+}
+
 // Play a sequence
 int8_t play_sequence(int32_t sequenceId, int8_t loop) {
     LOGI("FFI: Playing sequence %d, loop=%d", sequenceId, loop);
@@ -418,7 +932,7 @@ int8_t play_sequence(int32_t sequenceId, int8_t loop) {
     }
     
     try {
-        bool success = g_sequenceManager->startPlayback(sequenceId);
+        bool success = g_sequenceManager->startPlayback(sequenceId, loop != 0);
         return success ? 1 : 0;
     } catch (const std::exception& e) {
         LOGE("FFI: Exception when playing sequence: %s", e.what());
@@ -426,6 +940,25 @@ int8_t play_sequence(int32_t sequenceId, int8_t loop) {
     }
 }
 
+// Set the loop region used when a sequence plays with loop set; an empty
+// region (end <= start) loops the whole sequence
+int8_t set_loop_region(int32_t sequenceId, double startBeat, double endBeat) {
+    LOGI("FFI: Setting loop region of sequence %d to %f-%f", sequenceId, startBeat, endBeat);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        bool success = g_sequenceManager->setLoopRegion(sequenceId, startBeat, endBeat);
+        return success ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting loop region: %s", e.what());
+        return 0;
+    }
+}
+
 // Stop a sequence
 int8_t stop_sequence(int32_t sequenceId) {
     LOGI("FFI: Stopping sequence %d", sequenceId);
@@ -462,8 +995,10 @@ int8_t delete_sequence(int32_t sequenceId) {
     }
 }
 
-// Set playback position
-int8_t set_playback_position(int32_t sequenceId, double beat) {
+// Set playback position. On the playing sequence, notes spanning the new
+// position are chased, starting partway in when offsetIntoNotes is non-zero;
+// otherwise this cues where the sequence's next playback starts.
+int8_t set_playback_position(int32_t sequenceId, double beat, int8_t offsetIntoNotes) {
     LOGI("FFI: Setting playback position for sequence %d to beat %f", sequenceId, beat);
     
     if (!g_initialized || !g_sequenceManager) {
@@ -472,27 +1007,28 @@ int8_t set_playback_position(int32_t sequenceId, double beat) {
     }
     
     try {
-        return 1;
+        bool success = g_sequenceManager->setPlaybackPosition(sequenceId, beat, offsetIntoNotes != 0);
+        return success ? 1 : 0;
     } catch (const std::exception& e) {
         LOGE("FFI: Exception when setting playback position: %s", e.what());
         return 0;
     }
 }
 
-// Get playback position
-float get_playback_position(int32_t sequenceId) {
+// Get playback position in beats, or -1 if the sequence doesn't exist
+double get_playback_position(int32_t sequenceId) {
     LOGD("FFI: Getting playback position for sequence %d", sequenceId);
     
     if (!g_initialized || !g_sequenceManager) {
         LOGE("FFI: Audio engine or sequence manager not initialized");
-        return -1.0f;
+        return -1.0;
     }
     
     try {
-        return 0.0f;
+        return g_sequenceManager->getPlaybackPosition(sequenceId);
     } catch (const std::exception& e) {
         LOGE("FFI: Exception when getting playback position: %s", e.what());
-        return -1.0f;
+        return -1.0;
     }
 }
 
@@ -503,10 +1039,278 @@ set_master_volume(float volume) {
     return 1; // Success (even though it's not implemented)
 }
 
-// Set track volume - not directly supported in current API
+// Configure the master limiter: output ceiling in dBFS and release time in ms
+int8_t set_limiter(float ceilingDb, float releaseMs) {
+    LOGI("FFI: Setting limiter ceiling to %f dB, release to %f ms", ceilingDb, releaseMs);
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return 0;
+    }
+    
+    try {
+        g_audioEngine->setLimiter(ceilingDb, releaseMs);
+        return 1;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting limiter: %s", e.what());
+        return 0;
+    }
+}
+
+// Set track volume (linear gain); applied smoothly by the track's mixer strip
 int8_t set_track_volume(int32_t sequenceId, int32_t trackId, float volume) {
-    // TODO: Implement when track volume control is available
-    return 1; // Return success for now
+    LOGD("FFI: Setting volume of track %d in sequence %d to %f", trackId, sequenceId, volume);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_sequenceManager->setTrackVolume(sequenceId, trackId, volume) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting track volume: %s", e.what());
+        return 0;
+    }
+}
+
+// Set track pan (-1 = left, 0 = centre, 1 = right)
+int8_t set_track_pan(int32_t sequenceId, int32_t trackId, float pan) {
+    LOGD("FFI: Setting pan of track %d in sequence %d to %f", trackId, sequenceId, pan);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_sequenceManager->setTrackPan(sequenceId, trackId, pan) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when setting track pan: %s", e.what());
+        return 0;
+    }
+}
+
+// Add volume automation points in bulk from parallel beat/value arrays;
+// returns the number of points added or -1 on error
+int32_t add_volume_automation(int32_t sequenceId, int32_t trackId,
+                              const double* beats, const float* values, int32_t count) {
+    LOGD("FFI: Adding %d volume automation points to track %d in sequence %d", count, trackId, sequenceId);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    
+    try {
+        return g_sequenceManager->addVolumeAutomation(sequenceId, trackId, beats, values, count);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when adding volume automation: %s", e.what());
+        return -1;
+    }
+}
+
+// Remove all volume automation points in [startBeat, endBeat);
+// returns the number of points removed or -1 on error
+int32_t remove_volume_automation(int32_t sequenceId, int32_t trackId, double startBeat, double endBeat) {
+    LOGD("FFI: Removing volume automation in [%f, %f) from track %d in sequence %d",
+         startBeat, endBeat, trackId, sequenceId);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    
+    try {
+        return g_sequenceManager->removeVolumeAutomation(sequenceId, trackId, startBeat, endBeat);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when removing volume automation: %s", e.what());
+        return -1;
+    }
+}
+
+// Import a Standard MIDI File (type 0 or 1) as a new sequence whose tracks all
+// use the given instrument; returns the sequence ID or -1 on error
+int32_t import_midi_file(const char* path, int32_t instrumentId) {
+    LOGI("FFI: Importing MIDI file %s with instrument %d", path ? path : "(null)", instrumentId);
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    if (!path) {
+        LOGE("FFI: MIDI file path is null");
+        return -1;
+    }
+    
+    try {
+        return g_sequenceManager->importMidiFile(std::string(path), instrumentId);
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when importing MIDI file: %s", e.what());
+        return -1;
+    }
+}
+
+// Export a sequence to a Standard MIDI File on a background thread. Returns an
+// export ID, or -1 on error; completion is posted to the Dart port as
+// ["midiExport", exportId, success]
+int32_t export_midi_file(int32_t sequenceId, const char* path) {
+    LOGI("FFI: Exporting sequence %d to MIDI file %s", sequenceId, path ? path : "(null)");
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    if (!path) {
+        LOGE("FFI: MIDI file path is null");
+        return -1;
+    }
+    if (g_dart_port == 0 || Dart_PostCObject_DL == nullptr) {
+        LOGE("FFI: Dart port not registered, cannot report export completion");
+        return -1;
+    }
+    
+    try {
+        int64_t port = g_dart_port;
+        return g_sequenceManager->exportMidiFile(sequenceId, std::string(path),
+            [port](int exportId, bool success) {
+                Dart_CObject kind;
+                kind.type = Dart_CObject_kString;
+                kind.value.as_string = "midiExport";
+                
+                Dart_CObject id;
+                id.type = Dart_CObject_kInt32;
+                id.value.as_int32 = exportId;
+                
+                Dart_CObject result;
+                result.type = Dart_CObject_kBool;
+                result.value.as_bool = success;
+                
+                Dart_CObject* values[] = {&kind, &id, &result};
+                Dart_CObject message;
+                message.type = Dart_CObject_kArray;
+                message.value.as_array.length = 3;
+                message.value.as_array.values = values;
+                
+                if (!Dart_PostCObject_DL(port, &message)) {
+                    LOGW("FFI: Failed to post export completion for export %d", exportId);
+                }
+            });
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when exporting MIDI file: %s", e.what());
+        return -1;
+    }
+}
+
+// Save all sequences to a binary project file
+int8_t save_project(const char* path) {
+    LOGI("FFI: Saving project to %s", path ? path : "(null)");
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return 0;
+    }
+    if (!path) {
+        LOGE("FFI: Project path is null");
+        return 0;
+    }
+    
+    try {
+        return g_sequenceManager->saveProject(std::string(path)) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when saving project: %s", e.what());
+        return 0;
+    }
+}
+
+// Replace all sequences with those saved in a project file; returns the number
+// of sequences loaded or -1 on error
+int32_t load_project(const char* path) {
+    LOGI("FFI: Loading project from %s", path ? path : "(null)");
+    
+    if (!g_initialized || !g_sequenceManager) {
+        LOGE("FFI: Audio engine or sequence manager not initialized");
+        return -1;
+    }
+    if (!path) {
+        LOGE("FFI: Project path is null");
+        return -1;
+    }
+    
+    try {
+        return g_sequenceManager->loadProject(std::string(path));
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when loading project: %s", e.what());
+        return -1;
+    }
+}
+
+// Start streaming per-track and master meter levels to the registered Dart port
+int8_t start_meter_stream(int32_t rateHz) {
+    LOGI("FFI: Starting meter stream at %d Hz", rateHz);
+    
+    if (!g_initialized || !g_instrumentManager) {
+        LOGE("FFI: Audio engine or instrument manager not initialized");
+        return 0;
+    }
+    
+    try {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (!g_meterPublisher) {
+            g_meterPublisher = std::make_unique<MeterPublisher>(g_instrumentManager->getMixer());
+        }
+        return g_meterPublisher->start(g_dart_port, rateHz) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when starting meter stream: %s", e.what());
+        return 0;
+    }
+}
+
+// Start posting batched engine events (see EventPublisher) to the registered
+// Dart port at up to rateHz messages per second
+int8_t start_event_stream(int32_t rateHz) {
+    LOGI("FFI: Starting event stream at %d Hz", rateHz);
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return 0;
+    }
+    
+    try {
+        return g_audioEngine->getEventPublisher().start(g_dart_port, rateHz) ? 1 : 0;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when starting event stream: %s", e.what());
+        return 0;
+    }
+}
+
+// Stop posting engine events
+int8_t stop_event_stream() {
+    LOGI("FFI: Stopping event stream");
+    
+    if (!g_initialized || !g_audioEngine) {
+        LOGE("FFI: Audio engine not initialized");
+        return 0;
+    }
+    
+    g_audioEngine->getEventPublisher().stop();
+    return 1;
+}
+
+// Stop streaming meter levels
+int8_t stop_meter_stream() {
+    LOGI("FFI: Stopping meter stream");
+    
+    try {
+        std::lock_guard<std::mutex> lock(g_mutex);
+        if (g_meterPublisher) {
+            g_meterPublisher->stop();
+        }
+        return 1;
+    } catch (const std::exception& e) {
+        LOGE("FFI: Exception when stopping meter stream: %s", e.what());
+        return 0;
+    }
 }
 
 // Play a test tone
@@ -610,6 +1414,9 @@ shutdown() {
             return 1; // Nothing to do
         }
         
+        // Stop publishing before the mixer goes away
+        g_meterPublisher.reset();
+        
         // Stop the audio engine
         if (g_audioEngine) {
             LOGI("FFI: Stopping audio engine");
@@ -0,0 +1,124 @@
+#ifndef NOTE_INDEX_H
+#define NOTE_INDEX_H
+
+#include <algorithm>
+#include <cstdint>
+#include <vector>
+#include "note_list.h"
+
+// Interval index over a track's notes for range queries.
+//
+// Notes are kept in a flat array sorted by start tick, read as an implicit
+// balanced binary tree: the node at index i sits at level k when the lowest
+// k bits of i are set, and stores the latest end tick in its subtree. A query
+// skips every subtree that ends before the range, so it costs O(log n + k)
+// for k hits and reports them in start order. Built in O(n log n), after which
+// the array is only read.
+class NoteIndex {
+public:
+    struct Entry {
+        int32_t startTick;
+        int32_t endTick;
+        int32_t maxEnd;  // Latest end tick in this node's subtree
+        int32_t noteId;
+        uint8_t noteNumber;
+        uint8_t velocity;
+    };
+
+    void build(const NoteList& notes) {
+        m_entries.clear();
+        m_entries.reserve(notes.size());
+        for (const Note& note : notes) {
+            m_entries.push_back({note.startTick, note.startTick + note.durationTicks, 0, note.id,
+                                 note.noteNumber, note.velocity});
+        }
+        std::sort(m_entries.begin(), m_entries.end(),
+                  [](const Entry& a, const Entry& b) { return a.startTick < b.startTick; });
+        m_rootLevel = augment();
+    }
+
+    size_t size() const { return m_entries.size(); }
+
+    // Call visit(entry) for each note overlapping [startTick, endTick), in
+    // start order
+    template <typename Visit>
+    void query(int32_t startTick, int32_t endTick, Visit visit) const {
+        const int64_t n = static_cast<int64_t>(m_entries.size());
+        if (n == 0 || startTick >= endTick) {
+            return;
+        }
+
+        struct Frame {
+            int64_t index;
+            int level;
+            bool leftDone;
+        };
+        Frame stack[64];
+        int top = 0;
+        stack[top++] = {(int64_t(1) << m_rootLevel) - 1, m_rootLevel, false};
+
+        while (top > 0) {
+            Frame frame = stack[--top];
+            if (frame.level <= 3) {
+                // Small subtree: a linear scan is cheaper than descending
+                int64_t first = frame.index >> frame.level << frame.level;
+                int64_t last = std::min(n, first + (int64_t(1) << (frame.level + 1)) - 1);
+                for (int64_t i = first; i < last && m_entries[i].startTick < endTick; i++) {
+                    if (m_entries[i].endTick > startTick) {
+                        visit(m_entries[i]);
+                    }
+                }
+            } else if (!frame.leftDone) {
+                // Revisit this node after its left subtree, which is only
+                // entered if something in it ends inside the range
+                int64_t left = frame.index - (int64_t(1) << (frame.level - 1));
+                stack[top++] = {frame.index, frame.level, true};
+                if (left >= n || m_entries[left].maxEnd > startTick) {
+                    stack[top++] = {left, frame.level - 1, false};
+                }
+            } else if (frame.index < n && m_entries[frame.index].startTick < endTick) {
+                if (m_entries[frame.index].endTick > startTick) {
+                    visit(m_entries[frame.index]);
+                }
+                stack[top++] = {frame.index + (int64_t(1) << (frame.level - 1)), frame.level - 1, false};
+            }
+        }
+    }
+
+private:
+    // Fill in maxEnd bottom-up; nodes past the end of the array borrow the
+    // latest end seen so far. Returns the level of the root.
+    int augment() {
+        const int64_t n = static_cast<int64_t>(m_entries.size());
+        if (n == 0) {
+            return 0;
+        }
+
+        int64_t lastIndex = 0;
+        int32_t last = 0;
+        for (int64_t i = 0; i < n; i += 2) {
+            lastIndex = i;
+            last = m_entries[i].maxEnd = m_entries[i].endTick;
+        }
+
+        int level = 1;
+        for (; (int64_t(1) << level) <= n; level++) {
+            int64_t half = int64_t(1) << (level - 1);
+            for (int64_t i = (half << 1) - 1; i < n; i += half << 2) {
+                int32_t leftEnd = m_entries[i - half].maxEnd;
+                int32_t rightEnd = i + half < n ? m_entries[i + half].maxEnd : last;
+                m_entries[i].maxEnd = std::max({m_entries[i].endTick, leftEnd, rightEnd});
+            }
+            lastIndex = (lastIndex >> level & 1) ? lastIndex - half : lastIndex + half;
+            if (lastIndex < n && m_entries[lastIndex].maxEnd > last) {
+                last = m_entries[lastIndex].maxEnd;
+            }
+        }
+        return level - 1;
+    }
+
+    std::vector<Entry> m_entries;  // Sorted by start tick
+    int m_rootLevel = 0;
+};
+
+#endif // NOTE_INDEX_H
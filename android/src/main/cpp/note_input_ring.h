@@ -0,0 +1,108 @@
+#ifndef NOTE_INPUT_RING_H
+#define NOTE_INPUT_RING_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <cstdlib>
+#include <new>
+
+// Note events written straight into native memory by Dart and drained by the
+// audio thread, bypassing the FFI entry points and their locks. The block is
+// a 128-byte header followed by capacity 64-bit event words; the layout
+// matches NoteInputRing in the Dart FFI layer:
+//
+//   offset 0    uint32 write     events published, advanced by Dart
+//   offset 4    uint32 capacity  power of two
+//   offset 64   uint32 read      events consumed, advanced by the audio thread
+//   offset 128  uint64 events[capacity]
+//
+// Each event is a single aligned word so it is never seen half written:
+// bits 0-15 stamp, 16-23 type, 24-31 note, 32-39 velocity, 40-63 instrument
+// ID. The stamp is the low 16 bits of the event's index + 1. Dart can't order
+// its stores, so the write index alone doesn't prove an event has landed;
+// the consumer also waits for the slot's stamp to match.
+class NoteInputRing {
+public:
+    static constexpr uint32_t MIN_CAPACITY = 16;
+    static constexpr uint32_t MAX_CAPACITY = 4096;
+    static constexpr size_t HEADER_BYTES = 128;
+
+    enum EventType : uint8_t {
+        NOTE_ON = 1,
+        NOTE_OFF = 2
+    };
+
+    struct Event {
+        uint8_t type;
+        uint8_t noteNumber;
+        uint8_t velocity;
+        int32_t instrumentId;
+    };
+
+    // capacity is rounded up to a power of two within MIN/MAX_CAPACITY
+    explicit NoteInputRing(uint32_t capacity) {
+        uint32_t size = MIN_CAPACITY;
+        while (size < capacity && size < MAX_CAPACITY) {
+            size <<= 1;
+        }
+        m_capacity = size;
+        m_bytes = HEADER_BYTES + size * sizeof(uint64_t);
+        void* memory = nullptr;
+        if (posix_memalign(&memory, 64, m_bytes) != 0) {
+            throw std::bad_alloc();
+        }
+        m_memory = static_cast<uint8_t*>(memory);
+        for (size_t i = 0; i < m_bytes; i++) {
+            m_memory[i] = 0;
+        }
+        new (m_memory) std::atomic<uint32_t>(0);
+        new (m_memory + 64) std::atomic<uint32_t>(0);
+        *reinterpret_cast<uint32_t*>(m_memory + 4) = size;
+    }
+
+    ~NoteInputRing() { std::free(m_memory); }
+
+    NoteInputRing(const NoteInputRing&) = delete;
+    NoteInputRing& operator=(const NoteInputRing&) = delete;
+
+    uint8_t* data() const { return m_memory; }
+    uint32_t capacity() const { return m_capacity; }
+
+    // Audio thread only: hands every landed event to handler in order
+    template <typename Handler>
+    void drain(Handler&& handler) {
+        uint32_t read = readIndex().load(std::memory_order_relaxed);
+        uint32_t write = writeIndex().load(std::memory_order_acquire);
+        const uint64_t* events = reinterpret_cast<const uint64_t*>(m_memory + HEADER_BYTES);
+        while (read != write) {
+            uint64_t word = reinterpret_cast<const std::atomic<uint64_t>*>(&events[read & (m_capacity - 1)])
+                                ->load(std::memory_order_acquire);
+            if ((word & 0xFFFF) != ((read + 1) & 0xFFFF)) {
+                break;  // Index published before the event; take it next block
+            }
+            Event event;
+            event.type = static_cast<uint8_t>(word >> 16);
+            event.noteNumber = static_cast<uint8_t>(word >> 24);
+            event.velocity = static_cast<uint8_t>(word >> 32);
+            event.instrumentId = static_cast<int32_t>(word >> 40);
+            handler(event);
+            read++;
+        }
+        readIndex().store(read, std::memory_order_release);
+    }
+
+private:
+    std::atomic<uint32_t>& writeIndex() { return *reinterpret_cast<std::atomic<uint32_t>*>(m_memory); }
+    std::atomic<uint32_t>& readIndex() { return *reinterpret_cast<std::atomic<uint32_t>*>(m_memory + 64); }
+
+    uint8_t* m_memory = nullptr;
+    size_t m_bytes = 0;
+    uint32_t m_capacity = 0;
+
+    static_assert(sizeof(std::atomic<uint32_t>) == 4 && std::atomic<uint32_t>::is_always_lock_free,
+                  "Ring indices must be plain memory for Dart");
+    static_assert(std::atomic<uint64_t>::is_always_lock_free, "Ring events must be plain memory for Dart");
+};
+
+#endif // NOTE_INPUT_RING_H
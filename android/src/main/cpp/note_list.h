@@ -0,0 +1,153 @@
+#ifndef NOTE_LIST_H
+#define NOTE_LIST_H
+
+#include <algorithm>
+#include <cstddef>
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+// Structure to represent a note, positioned on its sequence's tick grid
+struct Note {
+    int32_t id;
+    int32_t startTick;
+    int32_t durationTicks;
+    uint8_t noteNumber;
+    uint8_t velocity;
+};
+
+// A track's notes in ascending ID order, stored as shared fixed-size chunks.
+//
+// Copying a NoteList copies only the chunk pointers, so undo snapshots share
+// every note with the live track. Writes go through copy-on-write: a chunk that
+// is also referenced by a snapshot is cloned first, so an edit costs one chunk
+// plus the pointer array rather than the whole track. All access happens under
+// the SequenceManager lock, which is what makes the use_count() check safe.
+class NoteList {
+public:
+    static constexpr size_t CHUNK_SIZE = 64;
+
+    class const_iterator {
+    public:
+        const_iterator(const NoteList* list, size_t chunk, size_t index)
+            : m_list(list), m_chunk(chunk), m_index(index) {}
+
+        const Note& operator*() const { return (*m_list->m_chunks[m_chunk])[m_index]; }
+        const Note* operator->() const { return &**this; }
+
+        const_iterator& operator++() {
+            if (++m_index == m_list->m_chunks[m_chunk]->size()) {
+                m_chunk++;
+                m_index = 0;
+            }
+            return *this;
+        }
+
+        bool operator==(const const_iterator& other) const {
+            return m_chunk == other.m_chunk && m_index == other.m_index;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        const NoteList* m_list;
+        size_t m_chunk;
+        size_t m_index;
+    };
+
+    const_iterator begin() const { return const_iterator(this, 0, 0); }
+    const_iterator end() const { return const_iterator(this, m_chunks.size(), 0); }
+
+    size_t size() const { return m_size; }
+    bool empty() const { return m_size == 0; }
+    const Note& back() const { return m_chunks.back()->back(); }
+
+    void clear() {
+        m_chunks.clear();
+        m_size = 0;
+    }
+
+    void reserve(size_t count) {
+        m_chunks.reserve((count + CHUNK_SIZE - 1) / CHUNK_SIZE);
+    }
+
+    // Append a note whose ID is above every existing one
+    void push_back(const Note& note) {
+        if (m_chunks.empty() || m_chunks.back()->size() == CHUNK_SIZE) {
+            m_chunks.push_back(std::make_shared<Chunk>());
+            m_chunks.back()->reserve(CHUNK_SIZE);
+        }
+        writable(m_chunks.size() - 1).push_back(note);
+        m_size++;
+    }
+
+    const Note* find(int id) const {
+        size_t chunk = locate(id);
+        if (chunk == m_chunks.size()) {
+            return nullptr;
+        }
+        const Chunk& notes = *m_chunks[chunk];
+        auto it = std::lower_bound(notes.begin(), notes.end(), id,
+                                   [](const Note& note, int noteId) { return note.id < noteId; });
+        return (it != notes.end() && it->id == id) ? &*it : nullptr;
+    }
+
+    // Mutable access to one note; clones its chunk if a snapshot shares it.
+    // The note's ID must not be changed.
+    Note* findForWrite(int id) {
+        const Note* note = find(id);
+        if (!note) {
+            return nullptr;
+        }
+        size_t chunk = locate(id);
+        size_t index = static_cast<size_t>(note - m_chunks[chunk]->data());
+        return &writable(chunk)[index];
+    }
+
+    bool erase(int id) {
+        const Note* note = find(id);
+        if (!note) {
+            return false;
+        }
+        size_t chunk = locate(id);
+        size_t index = static_cast<size_t>(note - m_chunks[chunk]->data());
+        Chunk& notes = writable(chunk);
+        notes.erase(notes.begin() + index);
+        if (notes.empty()) {
+            m_chunks.erase(m_chunks.begin() + chunk);
+        }
+        m_size--;
+        return true;
+    }
+
+    // Chunk identity, for estimating how much two versions share
+    size_t chunkCount() const { return m_chunks.size(); }
+    const void* chunkAt(size_t index) const { return m_chunks[index].get(); }
+    size_t chunkBytes(size_t index) const { return m_chunks[index]->capacity() * sizeof(Note); }
+
+private:
+    using Chunk = std::vector<Note>;
+
+    // First chunk whose last ID is >= id, or chunkCount() if none
+    size_t locate(int id) const {
+        auto it = std::lower_bound(m_chunks.begin(), m_chunks.end(), id,
+                                   [](const std::shared_ptr<Chunk>& chunk, int noteId) {
+                                       return chunk->back().id < noteId;
+                                   });
+        return static_cast<size_t>(it - m_chunks.begin());
+    }
+
+    Chunk& writable(size_t chunk) {
+        if (m_chunks[chunk].use_count() > 1) {
+            auto copy = std::make_shared<Chunk>();
+            copy->reserve(CHUNK_SIZE);
+            copy->assign(m_chunks[chunk]->begin(), m_chunks[chunk]->end());
+            m_chunks[chunk] = std::move(copy);
+        }
+        return *m_chunks[chunk];
+    }
+
+    std::vector<std::shared_ptr<Chunk>> m_chunks;
+    size_t m_size = 0;
+};
+
+#endif // NOTE_LIST_H
@@ -0,0 +1,71 @@
+#include "port_publisher.h"
+#include <android/log.h>
+#include <algorithm>
+#include <chrono>
+#include "dart_api_dl.h"
+
+#define LOG_TAG "PortPublisher"
+#define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
+#define LOGI(...) __android_log_print(ANDROID_LOG_INFO, LOG_TAG, __VA_ARGS__)
+#define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
+#define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
+
+PortPublisher::PortPublisher(const char* name, int maxRateHz)
+    : m_name(name), m_maxRateHz(maxRateHz) {
+}
+
+bool PortPublisher::start(int64_t dartPort, int rateHz) {
+    LOGI("Starting %s publisher at %d Hz", m_name, rateHz);
+    try {
+        if (dartPort == 0) {
+            LOGE("No Dart port registered for the %s publisher", m_name);
+            return false;
+        }
+        if (Dart_PostCObject_DL == nullptr) {
+            LOGE("Dart API not initialized, cannot start the %s publisher", m_name);
+            return false;
+        }
+
+        // Restart cleanly if already running
+        stop();
+        reset();
+
+        rateHz = std::max(1, std::min(m_maxRateHz, rateHz));
+        m_dartPort = dartPort;
+        m_intervalMs = std::max(1, 1000 / rateHz);
+
+        m_running.store(true);
+        m_thread = std::thread(&PortPublisher::run, this);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception starting the %s publisher: %s", m_name, e.what());
+        m_running.store(false);
+        return false;
+    }
+}
+
+void PortPublisher::stop() {
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        if (!m_running.exchange(false)) {
+            return;
+        }
+    }
+    m_wakeup.notify_all();
+    if (m_thread.joinable()) {
+        m_thread.join();
+    }
+    LOGI("Stopped %s publisher", m_name);
+}
+
+void PortPublisher::run() {
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (m_running.load()) {
+        m_wakeup.wait_for(lock, std::chrono::milliseconds(m_intervalMs),
+                          [this] { return !m_running.load(); });
+        if (!m_running.load()) {
+            break;
+        }
+        publish();
+    }
+}
@@ -0,0 +1,53 @@
+#ifndef PORT_PUBLISHER_H
+#define PORT_PUBLISHER_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstdint>
+#include <mutex>
+#include <thread>
+
+// Background thread that wakes at a fixed rate and posts to a Dart port; the
+// common part of the meter and event publishers. Subclasses only build and
+// post their message in publish(), which runs on the publisher thread, and
+// must call stop() in their destructor so the thread is gone before their
+// members are.
+class PortPublisher {
+public:
+    virtual ~PortPublisher() = default;
+
+    PortPublisher(const PortPublisher&) = delete;
+    PortPublisher& operator=(const PortPublisher&) = delete;
+
+    // Start posting to dartPort rateHz times a second, restarting if running
+    bool start(int64_t dartPort, int rateHz);
+    void stop();
+    bool isRunning() const { return m_running.load(std::memory_order_relaxed); }
+
+protected:
+    // name is used in log messages ("meter", "event")
+    PortPublisher(const char* name, int maxRateHz);
+
+    // Publisher thread: build and post one message
+    virtual void publish() = 0;
+
+    // Called by start() once any previous run has stopped, before the thread starts
+    virtual void reset() {}
+
+    int64_t dartPort() const { return m_dartPort; }
+
+private:
+    void run();
+
+    const char* m_name;
+    int m_maxRateHz;
+    int64_t m_dartPort = 0;
+    int m_intervalMs = 1000;
+
+    std::atomic<bool> m_running{false};
+    std::thread m_thread;
+    std::mutex m_mutex;
+    std::condition_variable m_wakeup;
+};
+
+#endif // PORT_PUBLISHER_H
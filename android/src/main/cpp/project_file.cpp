@@ -0,0 +1,184 @@
+#include "project_file.h"
+#include <cstdio>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+
+namespace project {
+
+namespace {
+
+constexpr size_t WRITE_BUFFER_SIZE = 64 * 1024;
+
+uint64_t align8(uint64_t offset) {
+    return (offset + 7) & ~static_cast<uint64_t>(7);
+}
+
+bool writeAt(FILE* file, uint64_t& position, uint64_t offset, const void* data, size_t size) {
+    static const uint8_t padding[8] = {};
+    if (offset < position || offset - position > sizeof(padding)) {
+        return false;
+    }
+    if (offset > position && fwrite(padding, 1, offset - position, file) != offset - position) {
+        return false;
+    }
+    if (size > 0 && fwrite(data, 1, size, file) != size) {
+        return false;
+    }
+    position = offset + size;
+    return true;
+}
+
+} // namespace
+
+bool writeFile(const std::string& path, ProjectData& data, std::string& error) {
+    // Lay out the tables, then each track's note and automation arrays
+    FileHeader header = {};
+    header.magic = MAGIC;
+    header.version = VERSION;
+    header.ticksPerBeat = data.ticksPerBeat;
+    header.sequenceCount = static_cast<uint32_t>(data.sequences.size());
+    header.trackCount = static_cast<uint32_t>(data.tracks.size());
+    header.nextSequenceId = data.nextSequenceId;
+    header.nextTrackId = data.nextTrackId;
+    header.nextNoteId = data.nextNoteId;
+    header.sequencesOffset = align8(sizeof(FileHeader));
+    header.tracksOffset = align8(header.sequencesOffset + data.sequences.size() * sizeof(SequenceRecord));
+
+    uint64_t offset = align8(header.tracksOffset + data.tracks.size() * sizeof(TrackRecord));
+    for (size_t i = 0; i < data.sequences.size(); i++) {
+        data.sequences[i].temposOffset = offset;
+        data.sequences[i].tempoCount = static_cast<uint32_t>(data.tempos[i].size());
+        offset = align8(offset + data.tempos[i].size() * sizeof(TempoRecord));
+        data.sequences[i].timeSignaturesOffset = offset;
+        data.sequences[i].timeSignatureCount = static_cast<uint32_t>(data.timeSignatures[i].size());
+        offset = align8(offset + data.timeSignatures[i].size() * sizeof(TimeSignatureRecord));
+    }
+    for (size_t i = 0; i < data.tracks.size(); i++) {
+        data.tracks[i].notesOffset = offset;
+        data.tracks[i].noteCount = static_cast<uint32_t>(data.notes[i].size());
+        offset = align8(offset + data.notes[i].size() * sizeof(NoteRecord));
+        data.tracks[i].automationOffset = offset;
+        data.tracks[i].automationCount = static_cast<uint32_t>(data.automation[i].size());
+        offset = align8(offset + data.automation[i].size() * sizeof(AutomationRecord));
+    }
+    header.fileSize = offset;
+
+    std::string tempPath = path + ".tmp";
+    FILE* file = fopen(tempPath.c_str(), "wb");
+    if (!file) {
+        error = "Cannot create file: " + tempPath;
+        return false;
+    }
+    setvbuf(file, nullptr, _IOFBF, WRITE_BUFFER_SIZE);
+
+    uint64_t position = 0;
+    bool ok = writeAt(file, position, 0, &header, sizeof(header)) &&
+              writeAt(file, position, header.sequencesOffset, data.sequences.data(),
+                      data.sequences.size() * sizeof(SequenceRecord)) &&
+              writeAt(file, position, header.tracksOffset, data.tracks.data(),
+                      data.tracks.size() * sizeof(TrackRecord));
+    for (size_t i = 0; ok && i < data.sequences.size(); i++) {
+        ok = writeAt(file, position, data.sequences[i].temposOffset, data.tempos[i].data(),
+                     data.tempos[i].size() * sizeof(TempoRecord)) &&
+             writeAt(file, position, data.sequences[i].timeSignaturesOffset, data.timeSignatures[i].data(),
+                     data.timeSignatures[i].size() * sizeof(TimeSignatureRecord));
+    }
+    for (size_t i = 0; ok && i < data.tracks.size(); i++) {
+        ok = writeAt(file, position, data.tracks[i].notesOffset, data.notes[i].data(),
+                     data.notes[i].size() * sizeof(NoteRecord)) &&
+             writeAt(file, position, data.tracks[i].automationOffset, data.automation[i].data(),
+                     data.automation[i].size() * sizeof(AutomationRecord));
+    }
+    ok = ok && writeAt(file, position, header.fileSize, nullptr, 0);
+
+    if (fclose(file) != 0) {
+        ok = false;
+    }
+    if (!ok || std::rename(tempPath.c_str(), path.c_str()) != 0) {
+        std::remove(tempPath.c_str());
+        error = "Cannot write file: " + path;
+        return false;
+    }
+    return true;
+}
+
+MappedFile::~MappedFile() {
+    if (m_data) {
+        munmap(const_cast<uint8_t*>(m_data), m_size);
+    }
+}
+
+bool MappedFile::open(const std::string& path, std::string& error) {
+    int fd = ::open(path.c_str(), O_RDONLY | O_CLOEXEC);
+    if (fd < 0) {
+        error = "Cannot open file: " + path;
+        return false;
+    }
+
+    struct stat info;
+    if (fstat(fd, &info) != 0 || info.st_size < static_cast<off_t>(sizeof(FileHeader))) {
+        close(fd);
+        error = "Not a project file: " + path;
+        return false;
+    }
+
+    void* mapping = mmap(nullptr, static_cast<size_t>(info.st_size), PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (mapping == MAP_FAILED) {
+        error = "Cannot map file: " + path;
+        return false;
+    }
+
+    m_data = static_cast<const uint8_t*>(mapping);
+    m_size = static_cast<size_t>(info.st_size);
+    return validate(error);
+}
+
+bool MappedFile::inBounds(uint64_t offset, uint64_t count, size_t recordSize) const {
+    if (offset % 8 != 0 || offset > m_size) {
+        return false;
+    }
+    return count <= (m_size - offset) / recordSize;
+}
+
+bool MappedFile::validate(std::string& error) const {
+    const FileHeader& h = header();
+    if (h.magic != MAGIC) {
+        error = "Not a project file";
+        return false;
+    }
+    if (h.version != VERSION) {
+        error = "Unsupported project version: " + std::to_string(h.version);
+        return false;
+    }
+    if (h.ticksPerBeat == 0 || h.fileSize != m_size ||
+        !inBounds(h.sequencesOffset, h.sequenceCount, sizeof(SequenceRecord)) ||
+        !inBounds(h.tracksOffset, h.trackCount, sizeof(TrackRecord))) {
+        error = "Corrupt project header";
+        return false;
+    }
+
+    const SequenceRecord* seqs = sequences();
+    for (uint32_t i = 0; i < h.sequenceCount; i++) {
+        if (seqs[i].ticksPerBeat == 0 || seqs[i].firstTrack > h.trackCount || seqs[i].trackCount > h.trackCount - seqs[i].firstTrack ||
+            !inBounds(seqs[i].temposOffset, seqs[i].tempoCount, sizeof(TempoRecord)) ||
+            !inBounds(seqs[i].timeSignaturesOffset, seqs[i].timeSignatureCount, sizeof(TimeSignatureRecord))) {
+            error = "Corrupt sequence table";
+            return false;
+        }
+    }
+
+    const TrackRecord* trks = tracks();
+    for (uint32_t i = 0; i < h.trackCount; i++) {
+        if (!inBounds(trks[i].notesOffset, trks[i].noteCount, sizeof(NoteRecord)) ||
+            !inBounds(trks[i].automationOffset, trks[i].automationCount, sizeof(AutomationRecord))) {
+            error = "Corrupt track table";
+            return false;
+        }
+    }
+    return true;
+}
+
+} // namespace project
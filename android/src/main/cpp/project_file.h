@@ -0,0 +1,151 @@
+#ifndef PROJECT_FILE_H
+#define PROJECT_FILE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Flat binary project format.
+//
+// Everything is fixed-size little-endian records at 8-byte aligned offsets, so
+// a mapped file is used in place: header, sequence table, track table,
+// per-sequence tempo and time signature arrays, then per-track note and
+// automation arrays. Note arrays are in note ID order with the ID and start
+// tick stored as deltas from the previous note, on the tick grid of their
+// sequence. Instruments are not stored; tracks keep the instrument IDs they
+// had when saved.
+namespace project {
+
+constexpr uint32_t MAGIC = 0x4A50544D;  // "MTPJ"
+constexpr uint32_t VERSION = 3;
+
+struct FileHeader {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t ticksPerBeat;   // Grid for sequences created after loading
+    uint32_t sequenceCount;
+    uint32_t trackCount;
+    int32_t nextSequenceId;  // ID counters, so deleted IDs aren't reused
+    int32_t nextTrackId;
+    int32_t nextNoteId;
+    uint64_t sequencesOffset;
+    uint64_t tracksOffset;
+    uint64_t fileSize;
+};
+
+struct SequenceRecord {
+    int32_t id;
+    uint32_t firstTrack;  // Index into the track table
+    uint32_t trackCount;
+    uint32_t tempoCount;
+    uint64_t temposOffset;
+    uint64_t timeSignaturesOffset;
+    uint32_t timeSignatureCount;
+    uint32_t ticksPerBeat;
+};
+
+struct TempoRecord {
+    double beat;
+    double bpm;
+    uint32_t ramp;  // Non-zero: ramps linearly to the next tempo
+    uint32_t reserved;
+};
+
+struct TimeSignatureRecord {
+    double beat;
+    int32_t numerator;
+    int32_t denominator;
+};
+
+struct TrackRecord {
+    int32_t id;
+    int32_t instrumentId;
+    float volume;
+    float pan;
+    uint64_t notesOffset;
+    uint64_t automationOffset;
+    uint32_t noteCount;
+    uint32_t automationCount;
+};
+
+struct NoteRecord {
+    uint32_t idDelta;      // From the previous note's ID (first note: the ID itself)
+    int32_t startDelta;    // Ticks from the previous note's start (first note: from 0)
+    uint32_t durationTicks;
+    uint8_t noteNumber;
+    uint8_t velocity;
+    uint16_t reserved;
+};
+
+struct AutomationRecord {
+    double beat;
+    float value;
+    uint32_t reserved;
+};
+
+static_assert(sizeof(FileHeader) == 56, "FileHeader layout");
+static_assert(sizeof(SequenceRecord) == 40, "SequenceRecord layout");
+static_assert(sizeof(TempoRecord) == 24, "TempoRecord layout");
+static_assert(sizeof(TimeSignatureRecord) == 16, "TimeSignatureRecord layout");
+static_assert(sizeof(TrackRecord) == 40, "TrackRecord layout");
+static_assert(sizeof(NoteRecord) == 16, "NoteRecord layout");
+static_assert(sizeof(AutomationRecord) == 16, "AutomationRecord layout");
+
+// Project contents ready to write, built from a snapshot of the sequences.
+// Sequence and track offsets are filled in by writeFile.
+struct ProjectData {
+    int32_t nextSequenceId = 1;
+    int32_t nextTrackId = 1;
+    int32_t nextNoteId = 1;
+    uint32_t ticksPerBeat = 960;
+    std::vector<SequenceRecord> sequences;
+    std::vector<std::vector<TempoRecord>> tempos;                  // Per sequence
+    std::vector<std::vector<TimeSignatureRecord>> timeSignatures;  // Per sequence
+    std::vector<TrackRecord> tracks;
+    std::vector<std::vector<NoteRecord>> notes;             // Per track
+    std::vector<std::vector<AutomationRecord>> automation;  // Per track
+};
+
+// Write a project to a temporary file and rename it over path once complete
+bool writeFile(const std::string& path, ProjectData& data, std::string& error);
+
+// Read-only memory mapping of a project file. open() validates every table
+// and array against the file size, after which the accessors can be trusted.
+class MappedFile {
+public:
+    MappedFile() = default;
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool open(const std::string& path, std::string& error);
+
+    const FileHeader& header() const { return *reinterpret_cast<const FileHeader*>(m_data); }
+    const SequenceRecord* sequences() const { return at<SequenceRecord>(header().sequencesOffset); }
+    const TrackRecord* tracks() const { return at<TrackRecord>(header().tracksOffset); }
+    const TempoRecord* tempos(const SequenceRecord& sequence) const {
+        return at<TempoRecord>(sequence.temposOffset);
+    }
+    const TimeSignatureRecord* timeSignatures(const SequenceRecord& sequence) const {
+        return at<TimeSignatureRecord>(sequence.timeSignaturesOffset);
+    }
+    const NoteRecord* notes(const TrackRecord& track) const { return at<NoteRecord>(track.notesOffset); }
+    const AutomationRecord* automation(const TrackRecord& track) const {
+        return at<AutomationRecord>(track.automationOffset);
+    }
+
+private:
+    template <typename T>
+    const T* at(uint64_t offset) const { return reinterpret_cast<const T*>(m_data + offset); }
+
+    bool validate(std::string& error) const;
+    bool inBounds(uint64_t offset, uint64_t count, size_t recordSize) const;
+
+    const uint8_t* m_data = nullptr;
+    size_t m_size = 0;
+};
+
+} // namespace project
+
+#endif // PROJECT_FILE_H
@@ -1,8 +1,15 @@
 #include "sequence_manager.h"
+#include "event_publisher.h"
 #include "instrument_manager.h"
+#include "midi_file.h"
+#include "project_file.h"
+#include "command_buffer.h"
+#include "tempo_map.h"
 #include <android/log.h>
 #include <algorithm>
+#include <chrono>
 #include <cmath>
+#include <iterator>
 
 #define LOG_TAG "SequenceManager"
 #define LOGD(...) __android_log_print(ANDROID_LOG_DEBUG, LOG_TAG, __VA_ARGS__)
@@ -10,12 +17,16 @@
 #define LOGW(...) __android_log_print(ANDROID_LOG_WARN, LOG_TAG, __VA_ARGS__)
 #define LOGE(...) __android_log_print(ANDROID_LOG_ERROR, LOG_TAG, __VA_ARGS__)
 
+// Length of the tempo steps that approximate a tempo ramp in exported MIDI files
+static constexpr double MIDI_RAMP_STEP = 0.125;
+
 SequenceManager::SequenceManager(InstrumentManager* instrumentManager)
     : m_instrumentManager(instrumentManager),
       m_nextSequenceId(1),
       m_nextTrackId(1),
       m_nextNoteId(1),
       m_activeSequenceId(-1),
+      m_currentPositionInBeats(0.0),
       m_isPlaying(false) {
     LOGD("SequenceManager created");
 }
@@ -26,6 +37,7 @@ SequenceManager::SequenceManager(AudioEngine* audioEngine /* unused */, Instrume
       m_nextTrackId(1),
       m_nextNoteId(1),
       m_activeSequenceId(-1),
+      m_currentPositionInBeats(0.0),
       m_isPlaying(false) {
     // Store the reference to the instrument manager
     m_instrumentManager = instrumentManager;
@@ -37,6 +49,19 @@ SequenceManager::SequenceManager(AudioEngine* audioEngine /* unused */, Instrume
 SequenceManager::~SequenceManager() {
     LOGD("SequenceManager destructor called");
     try {
+        stopScheduler();
+        
+        // Let in-flight exports finish writing their files
+        {
+            std::lock_guard<std::mutex> exportLock(m_exportMutex);
+            for (auto& job : m_exportJobs) {
+                if (job->thread.joinable()) {
+                    job->thread.join();
+                }
+            }
+            m_exportJobs.clear();
+        }
+        
         std::lock_guard<std::mutex> lock(m_mutex);
         m_sequences.clear();
         LOGD("SequenceManager destroyed successfully");
@@ -56,7 +81,14 @@ bool SequenceManager::init() {
         m_nextTrackId = 1;
         m_nextNoteId = 1;
         m_activeSequenceId = -1;
+        m_currentPositionInBeats = 0.0;
         m_isPlaying = false;
+        clearHistory();
+        
+        if (!m_schedulerThread.joinable()) {
+            m_schedulerRunning.store(true);
+            m_schedulerThread = std::thread(&SequenceManager::runScheduler, this);
+        }
         LOGD("SequenceManager initialized successfully");
         return true;
     } catch (const std::exception& e) {
@@ -68,22 +100,46 @@ bool SequenceManager::init() {
     }
 }
 
-int SequenceManager::createSequence(int tempo) {
-    LOGD("Creating sequence with tempo: %d", tempo);
+int32_t Sequence::beatToTick(double beat) const {
+    double tick = std::round(beat * ticksPerBeat);
+    if (!(tick > 0.0)) {
+        return 0;
+    }
+    return tick < MAX_NOTE_TICK ? static_cast<int32_t>(tick) : MAX_NOTE_TICK;
+}
+
+bool SequenceManager::setTicksPerBeat(int ticksPerBeat) {
+    if (ticksPerBeat < 1 || ticksPerBeat > MAX_TICKS_PER_BEAT) {
+        LOGW("Invalid tick grid: %d ticks per beat", ticksPerBeat);
+        return false;
+    }
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_ticksPerBeat = ticksPerBeat;
+    return true;
+}
+
+int SequenceManager::createSequence(double bpm, int timeSignatureNumerator, int timeSignatureDenominator) {
+    LOGD("Creating sequence with tempo: %f, time signature: %d/%d", bpm, timeSignatureNumerator, timeSignatureDenominator);
     try {
         std::lock_guard<std::mutex> lock(m_mutex);
         
-        // Validate tempo
-        if (tempo <= 0) {
-            LOGW("Invalid tempo: %d, using default 120", tempo);
-            tempo = 120;
+        // Validate tempo and time signature
+        if (!TempoMap::validTempo(bpm)) {
+            LOGW("Invalid tempo: %f, using default 120", bpm);
+            bpm = 120.0;
+        }
+        if (!TempoMap::validTimeSignature(timeSignatureNumerator, timeSignatureDenominator)) {
+            LOGW("Invalid time signature: %d/%d, using 4/4", timeSignatureNumerator, timeSignatureDenominator);
+            timeSignatureNumerator = 4;
+            timeSignatureDenominator = 4;
         }
         
         // Create a new sequence
         int sequenceId = m_nextSequenceId++;
         Sequence& sequence = m_sequences[sequenceId];
         sequence.id = sequenceId;
-        sequence.tempo = tempo;
+        sequence.ticksPerBeat = m_ticksPerBeat;
+        sequence.tempoMap = TempoMap(bpm, timeSignatureNumerator, timeSignatureDenominator);
         sequence.isPlaying = false;
         
         LOGD("Created sequence with ID: %d", sequenceId);
@@ -111,11 +167,17 @@ bool SequenceManager::deleteSequence(int sequenceId) {
         
         // Stop playback if this sequence is active
         if (m_activeSequenceId == sequenceId && m_isPlaying) {
-            stopPlayback();
+            stopPlaybackLocked();
         }
         
-        // Remove the sequence
+        // Remove the sequence and free its tracks' mixer strips
+        if (m_instrumentManager) {
+            for (auto& trackPair : it->second.tracks) {
+                m_instrumentManager->getMixer().releaseBus(trackPair.second.busId);
+            }
+        }
         m_sequences.erase(it);
+        forgetSequenceHistory(sequenceId);
         
         LOGD("Deleted sequence with ID: %d", sequenceId);
         return true;
@@ -141,11 +203,20 @@ int SequenceManager::addTrack(int sequenceId, int instrumentId) {
         }
         
         // Create a new track
+        recordUndo(sequenceId);
         int trackId = m_nextTrackId++;
         Track& track = seqIt->second.tracks[trackId];
         track.id = trackId;
         track.instrumentId = instrumentId;
         track.volume = 1.0f;
+        track.pan = 0.0f;
+        
+        // Give the track its own mixer strip
+        track.busId = m_instrumentManager ? m_instrumentManager->getMixer().acquireBus(trackId) : -1;
+        if (track.busId < 0) {
+            LOGW("No free mixer bus for track %d, using master bus", trackId);
+            track.busId = Mixer::MASTER_BUS;
+        }
         
         LOGD("Added track with ID %d to sequence %d", trackId, sequenceId);
         return trackId;
@@ -177,7 +248,14 @@ bool SequenceManager::deleteTrack(int sequenceId, int trackId) {
             return false;
         }
         
-        // Remove the track
+        // Remove the track and free its mixer strip
+        recordUndo(sequenceId);
+        if (m_isPlaying && sequenceId == m_activeSequenceId) {
+            releaseSounding(trackIt->second, m_audioFrame.load());
+        }
+        if (m_instrumentManager) {
+            m_instrumentManager->getMixer().releaseBus(trackIt->second.busId);
+        }
         seqIt->second.tracks.erase(trackIt);
         
         LOGD("Deleted track %d from sequence %d", trackId, sequenceId);
@@ -191,6 +269,80 @@ bool SequenceManager::deleteTrack(int sequenceId, int trackId) {
     }
 }
 
+bool SequenceManager::setTrackVolume(int sequenceId, int trackId, float volume) {
+    LOGD("Setting volume of track %d in sequence %d to %f", trackId, sequenceId, volume);
+    try {
+        if (!std::isfinite(volume) || volume < 0.0f) {
+            LOGW("Invalid track volume: %f", volume);
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        auto trackIt = seqIt->second.tracks.find(trackId);
+        if (trackIt == seqIt->second.tracks.end()) {
+            LOGW("Track with ID %d not found in sequence %d", trackId, sequenceId);
+            return false;
+        }
+        
+        // The mixer smooths the change on the audio thread
+        trackIt->second.volume = volume;
+        if (m_instrumentManager && trackIt->second.busId != Mixer::MASTER_BUS) {
+            m_instrumentManager->getMixer().setBusGain(trackIt->second.busId, volume);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in setTrackVolume: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in setTrackVolume");
+        return false;
+    }
+}
+
+bool SequenceManager::setTrackPan(int sequenceId, int trackId, float pan) {
+    LOGD("Setting pan of track %d in sequence %d to %f", trackId, sequenceId, pan);
+    try {
+        if (!std::isfinite(pan)) {
+            LOGW("Invalid track pan: %f", pan);
+            return false;
+        }
+        pan = std::max(-1.0f, std::min(1.0f, pan));
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        auto trackIt = seqIt->second.tracks.find(trackId);
+        if (trackIt == seqIt->second.tracks.end()) {
+            LOGW("Track with ID %d not found in sequence %d", trackId, sequenceId);
+            return false;
+        }
+        
+        trackIt->second.pan = pan;
+        if (m_instrumentManager && trackIt->second.busId != Mixer::MASTER_BUS) {
+            m_instrumentManager->getMixer().setBusPan(trackIt->second.busId, pan);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in setTrackPan: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in setTrackPan");
+        return false;
+    }
+}
+
 int SequenceManager::addNote(int sequenceId, int trackId, int noteNumber, int velocity, double startTime, double duration) {
     try {
         LOGI("Adding note to sequence %d, track %d: note=%d, velocity=%d, start=%f, duration=%f",
@@ -250,36 +402,305 @@ int SequenceManager::addNote(int sequenceId, int trackId, int noteNumber, int ve
             return -1;
         }
         
-        // Create a new note
+        // Create a new note, snapped to the sequence's tick grid
         int noteId = m_nextNoteId++;
-        Note& note = trackIt->second.notes[noteId];
+        recordUndo(sequenceId);
+        Note note;
         note.id = noteId;
-        note.noteNumber = noteNumber;
-        note.velocity = velocity;
-        note.startTime = startTime;
-        note.duration = duration;
+        note.noteNumber = static_cast<uint8_t>(noteNumber);
+        note.velocity = static_cast<uint8_t>(velocity);
+        note.startTick = seqIt->second.beatToTick(startTime);
+        note.durationTicks = std::max(1, seqIt->second.beatToTick(duration));
+        trackIt->second.notes.push_back(note);
+        
+        // Compile the note into the track's event list; the transport fires it
+        insertEvent(trackIt->second, {note.startTick, noteId, note.noteNumber, note.velocity});
+        insertEvent(trackIt->second, {note.startTick + note.durationTicks, noteId, note.noteNumber, 0});
         
         LOGI("Added note with ID %d to track %d in sequence %d", noteId, trackId, sequenceId);
         
-        // If the sequence is currently playing and the note should start now, trigger it
-        if (m_isPlaying && sequenceId == m_activeSequenceId) {
-            if (startTime <= 0) {
-                // Trigger the note immediately
-                bool success = m_instrumentManager->sendNoteOn(instrumentId, noteNumber, velocity);
-                if (success) {
-                    LOGD("Triggered note %d with velocity %d on instrument %d", noteNumber, velocity, instrumentId);
-                } else {
-                    LOGW("Failed to trigger note %d on instrument %d", noteNumber, instrumentId);
+        return noteId;
+    } catch (const std::exception& e) {
+        LOGE("Exception in addNote: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in addNote");
+        return -1;
+    }
+}
+
+int SequenceManager::addNotes(int sequenceId, int trackId, const NoteRecord* records, int count, int32_t* outIds) {
+    LOGD("Adding %d notes to track %d in sequence %d", count, trackId, sequenceId);
+    try {
+        if (!records || !outIds || count < 0) {
+            LOGW("Invalid note buffers");
+            return -1;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        if (!m_instrumentManager) {
+            LOGE("InstrumentManager is null");
+            return -1;
+        }
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return -1;
+        }
+        
+        auto trackIt = seqIt->second.tracks.find(trackId);
+        if (trackIt == seqIt->second.tracks.end()) {
+            LOGW("Track with ID %d not found in sequence %d", trackId, sequenceId);
+            return -1;
+        }
+        Track& track = trackIt->second;
+        
+        if (!m_instrumentManager->getInstrument(track.instrumentId)) {
+            LOGW("Instrument with ID %d not found", track.instrumentId);
+            return -1;
+        }
+        
+        // Validate and append in one pass, applying addNote's rules; the undo
+        // level is only recorded once a note is accepted
+        std::vector<NoteEvent> added;
+        added.reserve(static_cast<size_t>(count) * 2);
+        track.notes.reserve(track.notes.size() + count);
+        int rejected = 0;
+        for (int i = 0; i < count; i++) {
+            const NoteRecord& record = records[i];
+            if (record.noteNumber < 0 || record.noteNumber > 127 ||
+                !std::isfinite(record.startTime) || !std::isfinite(record.duration)) {
+                outIds[i] = -1;
+                rejected++;
+                continue;
+            }
+            if (added.empty()) {
+                recordUndo(sequenceId);
+            }
+            
+            Note note;
+            note.id = m_nextNoteId++;
+            note.noteNumber = static_cast<uint8_t>(record.noteNumber);
+            note.velocity = static_cast<uint8_t>(std::max(1, std::min(127, static_cast<int>(record.velocity))));
+            note.startTick = seqIt->second.beatToTick(record.startTime);
+            note.durationTicks = std::max(1, seqIt->second.beatToTick(record.duration > 0 ? record.duration : 0.1));
+            track.notes.push_back(note);
+            outIds[i] = note.id;
+            appendEvents(added, note);
+        }
+        
+        mergeEvents(track, added);
+        
+        if (rejected > 0) {
+            LOGW("Rejected %d of %d notes for track %d", rejected, count, trackId);
+        }
+        return count - rejected;
+    } catch (const std::exception& e) {
+        LOGE("Exception in addNotes: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in addNotes");
+        return -1;
+    }
+}
+
+int SequenceManager::queryNotes(int sequenceId, int trackId, double startBeat, double endBeat,
+                                int lowNote, int highNote, NoteQueryRecord* out, int capacity) {
+    try {
+        if (capacity < 0 || (capacity > 0 && !out) ||
+            !std::isfinite(startBeat) || !std::isfinite(endBeat)) {
+            LOGW("Invalid note query");
+            return -1;
+        }
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        Track* track = indexedTrack(lock, sequenceId, trackId);
+        if (!track) {
+            return -1;
+        }
+
+        // Ticks are whole, so a note overlaps the beat range exactly when it
+        // overlaps [floor(start), ceil(end)) in ticks
+        const Sequence& sequence = m_sequences.find(sequenceId)->second;
+        double ticksPerBeat = sequence.ticksPerBeat;
+        auto toTick = [](double tick) {
+            return static_cast<int32_t>(std::max<double>(INT32_MIN, std::min<double>(INT32_MAX, tick)));
+        };
+        int32_t startTick = toTick(std::floor(startBeat * ticksPerBeat));
+        int32_t endTick = toTick(std::ceil(endBeat * ticksPerBeat));
+
+        int matches = 0;
+        track->noteIndex.query(startTick, endTick, [&](const NoteIndex::Entry& entry) {
+            if (entry.noteNumber < lowNote || entry.noteNumber > highNote) {
+                return;
+            }
+            if (matches < capacity) {
+                NoteQueryRecord& record = out[matches];
+                record.startTime = sequence.tickToBeat(entry.startTick);
+                record.duration = sequence.tickToBeat(entry.endTick - entry.startTick);
+                record.noteId = entry.noteId;
+                record.noteNumber = entry.noteNumber;
+                record.velocity = entry.velocity;
+                record.reserved = 0;
+            }
+            matches++;
+        });
+        return matches;
+    } catch (const std::exception& e) {
+        LOGE("Exception in queryNotes: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in queryNotes");
+        return -1;
+    }
+}
+
+int SequenceManager::applyCommands(const std::vector<EditCommand>& commands) {
+    LOGD("Applying %zu edit commands", commands.size());
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        if (!m_instrumentManager) {
+            LOGE("InstrumentManager is null");
+            return -1;
+        }
+        
+        // The whole batch is one undo level, recorded just before the first
+        // command that passes validation changes anything
+        std::vector<int> touchedSequences;
+        for (const EditCommand& command : commands) {
+            if (m_sequences.count(command.sequenceId) &&
+                std::find(touchedSequences.begin(), touchedSequences.end(), command.sequenceId) ==
+                    touchedSequences.end()) {
+                touchedSequences.push_back(command.sequenceId);
+            }
+        }
+        bool recorded = false;
+        auto beginEdit = [&]() {
+            if (!recorded) {
+                recordUndo(touchedSequences);
+                recorded = true;
+            }
+        };
+        
+        // Note edits only touch the notes; the edited notes' events are
+        // recompiled per track once at the end of the batch
+        std::map<Track*, std::vector<int>> editedNotes;
+        int applied = 0;
+        
+        for (const EditCommand& command : commands) {
+            auto seqIt = m_sequences.find(command.sequenceId);
+            if (seqIt == m_sequences.end()) {
+                LOGW("Skipping command %d: sequence %d not found", static_cast<int>(command.type), command.sequenceId);
+                continue;
+            }
+            Sequence& sequence = seqIt->second;
+            
+            if (command.type == CommandType::SET_TEMPO) {
+                // Sets the initial tempo; later tempo changes stay
+                if (!TempoMap::validTempo(command.bpm)) {
+                    LOGW("Skipping invalid tempo: %f", command.bpm);
+                    continue;
+                }
+                beginEdit();
+                sequence.tempoMap.setTempo(0.0, command.bpm, sequence.tempoMap.tempoEvents().front().ramp);
+                applied++;
+                continue;
+            }
+            
+            auto trackIt = sequence.tracks.find(command.trackId);
+            if (trackIt == sequence.tracks.end()) {
+                LOGW("Skipping command %d: track %d not found in sequence %d",
+                     static_cast<int>(command.type), command.trackId, command.sequenceId);
+                continue;
+            }
+            Track& track = trackIt->second;
+            Mixer& mixer = m_instrumentManager->getMixer();
+            
+            if (command.type == CommandType::SET_TRACK_VOLUME) {
+                if (!std::isfinite(command.floatValue) || command.floatValue < 0.0f) {
+                    LOGW("Skipping invalid track volume: %f", command.floatValue);
+                    continue;
+                }
+                beginEdit();
+                track.volume = command.floatValue;
+                if (track.busId != Mixer::MASTER_BUS) {
+                    mixer.setBusGain(track.busId, track.volume);
+                }
+                applied++;
+                continue;
+            }
+            if (command.type == CommandType::SET_TRACK_PAN) {
+                if (!std::isfinite(command.floatValue)) {
+                    LOGW("Skipping invalid track pan: %f", command.floatValue);
+                    continue;
+                }
+                beginEdit();
+                track.pan = std::max(-1.0f, std::min(1.0f, command.floatValue));
+                if (track.busId != Mixer::MASTER_BUS) {
+                    mixer.setBusPan(track.busId, track.pan);
+                }
+                applied++;
+                continue;
+            }
+            
+            const Note* noteIt = track.notes.find(command.noteId);
+            if (!noteIt) {
+                LOGW("Skipping command %d: note %d not found in track %d",
+                     static_cast<int>(command.type), command.noteId, command.trackId);
+                continue;
+            }
+            beginEdit();
+            
+            // Release a note that is sounding before changing it, since its
+            // pending note off may no longer match
+            if (m_isPlaying && m_activeSequenceId == command.sequenceId) {
+                releaseEditedNote(track, sequence, *noteIt);
+            }
+            
+            if (command.type == CommandType::DELETE_NOTE) {
+                track.notes.erase(command.noteId);
+            } else {
+                Note* note = track.notes.findForWrite(command.noteId);
+                switch (command.type) {
+                    case CommandType::MOVE_NOTE:
+                        if (std::isfinite(command.startBeat)) {
+                            note->startTick = sequence.beatToTick(command.startBeat);
+                        }
+                        if (std::isfinite(command.durationBeats) && command.durationBeats > 0) {
+                            note->durationTicks = std::max(1, sequence.beatToTick(command.durationBeats));
+                        }
+                        break;
+                    case CommandType::TRANSPOSE_NOTE:
+                        note->noteNumber = static_cast<uint8_t>(std::max(0, std::min(127, note->noteNumber + command.intValue)));
+                        break;
+                    case CommandType::SET_NOTE_VELOCITY:
+                        note->velocity = static_cast<uint8_t>(std::max(1, std::min(127, command.intValue)));
+                        break;
+                    default:
+                        break;
                 }
             }
+            applied++;
+            
+            editedNotes[&track].push_back(command.noteId);
         }
         
-        return noteId;
+        for (auto& edited : editedNotes) {
+            recompileNotes(*edited.first, edited.second);
+        }
+        
+        if (applied < static_cast<int>(commands.size())) {
+            LOGW("Applied %d of %zu edit commands", applied, commands.size());
+        }
+        return applied;
     } catch (const std::exception& e) {
-        LOGE("Exception in addNote: %s", e.what());
+        LOGE("Exception in applyCommands: %s", e.what());
         return -1;
     } catch (...) {
-        LOGE("Unknown exception in addNote");
+        LOGE("Unknown exception in applyCommands");
         return -1;
     }
 }
@@ -304,21 +725,21 @@ bool SequenceManager::deleteNote(int sequenceId, int trackId, int noteId) {
         }
         
         // Check if the note exists
-        auto noteIt = trackIt->second.notes.find(noteId);
-        if (noteIt == trackIt->second.notes.end()) {
+        const Note* noteIt = trackIt->second.notes.find(noteId);
+        if (!noteIt) {
             LOGW("Note with ID %d not found in track %d", noteId, trackId);
             return false;
         }
         
         // If the note is currently playing, stop it
         if (m_isPlaying && sequenceId == m_activeSequenceId) {
-            int instrumentId = trackIt->second.instrumentId;
-            int noteNumber = noteIt->second.noteNumber;
-            m_instrumentManager->sendNoteOff(instrumentId, noteNumber);
+            releaseEditedNote(trackIt->second, seqIt->second, *noteIt);
         }
         
-        // Remove the note
-        trackIt->second.notes.erase(noteIt);
+        // Remove the note and its events
+        recordUndo(sequenceId);
+        removeEvents(trackIt->second, {noteId});
+        trackIt->second.notes.erase(noteId);
         
         LOGD("Deleted note %d from track %d in sequence %d", noteId, trackId, sequenceId);
         return true;
@@ -331,103 +752,1662 @@ bool SequenceManager::deleteNote(int sequenceId, int trackId, int noteId) {
     }
 }
 
-bool SequenceManager::startPlayback(int sequenceId) {
-    LOGD("Starting playback of sequence %d", sequenceId);
+int SequenceManager::addVolumeAutomation(int sequenceId, int trackId, const double* beats, const float* values, int count) {
+    LOGD("Adding %d volume automation points to track %d in sequence %d", count, trackId, sequenceId);
     try {
+        if (!beats || !values || count < 0) {
+            LOGW("Invalid automation point buffers");
+            return -1;
+        }
+        
         std::lock_guard<std::mutex> lock(m_mutex);
         
-        // Check if the sequence exists
         auto seqIt = m_sequences.find(sequenceId);
         if (seqIt == m_sequences.end()) {
             LOGW("Sequence with ID %d not found", sequenceId);
-            return false;
+            return -1;
         }
         
-        // Stop any currently playing sequence
-        if (m_isPlaying) {
-            stopPlayback();
+        auto trackIt = seqIt->second.tracks.find(trackId);
+        if (trackIt == seqIt->second.tracks.end()) {
+            LOGW("Track with ID %d not found in sequence %d", trackId, sequenceId);
+            return -1;
         }
         
-        // Set the active sequence
-        m_activeSequenceId = sequenceId;
-        seqIt->second.isPlaying = true;
-        m_isPlaying = true;
-        
-        // Trigger all notes that start at time 0
-        for (auto& trackPair : seqIt->second.tracks) {
-            int instrumentId = trackPair.second.instrumentId;
-            
-            for (auto& notePair : trackPair.second.notes) {
-                const Note& note = notePair.second;
-                
-                if (note.startTime <= 0) {
-                    // Trigger the note immediately
-                    bool success = m_instrumentManager->sendNoteOn(instrumentId, note.noteNumber, note.velocity);
-                    if (success) {
-                        LOGD("Triggered note %d with velocity %d on instrument %d", note.noteNumber, note.velocity, instrumentId);
-                    } else {
-                        LOGW("Failed to trigger note %d on instrument %d", note.noteNumber, instrumentId);
-                    }
-                }
+        // Append the valid points, sort just the new run, then merge it in.
+        // The undo level is recorded once a point is accepted, before the
+        // lane is unshared from the snapshot it takes.
+        AutomationLane& lane = trackIt->second.volumeAutomation;
+        std::vector<AutomationPoint>* points = nullptr;
+        size_t oldSize = lane.points->size();
+        for (int i = 0; i < count; i++) {
+            if (!std::isfinite(beats[i]) || beats[i] < 0.0 || !std::isfinite(values[i]) || values[i] < 0.0f) {
+                LOGW("Skipping invalid automation point: beat=%f, value=%f", beats[i], values[i]);
+                continue;
+            }
+            if (!points) {
+                recordUndo(sequenceId);
+                points = &lane.edit();
+                points->reserve(oldSize + count);
             }
+            points->push_back({beats[i], values[i]});
+        }
+        if (!points) {
+            return 0;
         }
         
-        LOGI("Started playback of sequence %d", sequenceId);
-        return true;
+        auto byBeat = [](const AutomationPoint& a, const AutomationPoint& b) { return a.beat < b.beat; };
+        std::stable_sort(points->begin() + oldSize, points->end(), byBeat);
+        std::inplace_merge(points->begin(), points->begin() + oldSize, points->end(), byBeat);
+        lane.invalidateCursor();
+        
+        return static_cast<int>(points->size() - oldSize);
     } catch (const std::exception& e) {
-        LOGE("Exception in startPlayback: %s", e.what());
-        return false;
+        LOGE("Exception in addVolumeAutomation: %s", e.what());
+        return -1;
     } catch (...) {
-        LOGE("Unknown exception in startPlayback");
-        return false;
+        LOGE("Unknown exception in addVolumeAutomation");
+        return -1;
     }
 }
 
-bool SequenceManager::stopPlayback() {
-    LOGD("Stopping playback");
+int SequenceManager::removeVolumeAutomation(int sequenceId, int trackId, double startBeat, double endBeat) {
+    LOGD("Removing volume automation in [%f, %f) from track %d in sequence %d", startBeat, endBeat, trackId, sequenceId);
     try {
         std::lock_guard<std::mutex> lock(m_mutex);
         
-        if (!m_isPlaying) {
-            LOGW("No sequence is currently playing");
-            return true;
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return -1;
         }
         
-        // Stop all active notes
-        if (m_activeSequenceId >= 0) {
-            auto seqIt = m_sequences.find(m_activeSequenceId);
-            if (seqIt != m_sequences.end()) {
-                for (auto& trackPair : seqIt->second.tracks) {
-                    int instrumentId = trackPair.second.instrumentId;
-                    
-                    // Get all active notes for this instrument
-                    std::vector<int> activeNotes;
-                    for (auto& notePair : trackPair.second.notes) {
-                        activeNotes.push_back(notePair.second.noteNumber);
-                    }
-                    
-                    // Send note off for each active note
-                    for (int noteNumber : activeNotes) {
-                        m_instrumentManager->sendNoteOff(instrumentId, noteNumber);
-                    }
-                }
-                
-                seqIt->second.isPlaying = false;
-            }
+        auto trackIt = seqIt->second.tracks.find(trackId);
+        if (trackIt == seqIt->second.tracks.end()) {
+            LOGW("Track with ID %d not found in sequence %d", trackId, sequenceId);
+            return -1;
         }
         
-        m_activeSequenceId = -1;
-        m_isPlaying = false;
+        // Points are sorted, so the range is one contiguous run
+        const std::vector<AutomationPoint>& points = *trackIt->second.volumeAutomation.points;
+        auto first = std::lower_bound(points.begin(), points.end(), startBeat,
+                                      [](const AutomationPoint& p, double beat) { return p.beat < beat; });
+        auto last = std::lower_bound(first, points.end(), endBeat,
+                                     [](const AutomationPoint& p, double beat) { return p.beat < beat; });
+        int removed = static_cast<int>(last - first);
+        if (removed > 0) {
+            size_t from = static_cast<size_t>(first - points.begin());
+            recordUndo(sequenceId);
+            std::vector<AutomationPoint>& edited = trackIt->second.volumeAutomation.edit();
+            edited.erase(edited.begin() + from, edited.begin() + from + removed);
+            trackIt->second.volumeAutomation.invalidateCursor();
+        }
         
-        LOGI("Playback stopped");
-        return true;
+        return removed;
     } catch (const std::exception& e) {
-        LOGE("Exception in stopPlayback: %s", e.what());
-        return false;
+        LOGE("Exception in removeVolumeAutomation: %s", e.what());
+        return -1;
     } catch (...) {
-        LOGE("Unknown exception in stopPlayback");
-        return false;
+        LOGE("Unknown exception in removeVolumeAutomation");
+        return -1;
+    }
+}
+
+float AutomationLane::valueAt(double beat) {
+    const Points& points = *this->points;
+    if (points.empty()) {
+        return 1.0f;
+    }
+    if (beat < points.front().beat) {
+        cursor = 0;
+        return points.front().value;
+    }
+    
+    // Re-find the cursor only after an edit or when the playhead moved backwards
+    if (cursor >= points.size() || points[cursor].beat > beat) {
+        auto it = std::upper_bound(points.begin(), points.end(), beat,
+                                   [](double b, const AutomationPoint& p) { return b < p.beat; });
+        cursor = static_cast<size_t>(it - points.begin()) - 1;
+    }
+    while (cursor + 1 < points.size() && points[cursor + 1].beat <= beat) {
+        cursor++;
+    }
+    
+    if (cursor + 1 == points.size()) {
+        return points[cursor].value;
+    }
+    
+    const AutomationPoint& from = points[cursor];
+    const AutomationPoint& to = points[cursor + 1];
+    double t = (beat - from.beat) / (to.beat - from.beat);
+    return from.value + static_cast<float>(t) * (to.value - from.value);
+}
+
+// Events are sorted by tick with note offs ahead of note ons on the same tick,
+// so a note retriggered where it ends is released first
+bool SequenceManager::eventBefore(const NoteEvent& a, const NoteEvent& b) {
+    if (a.tick != b.tick) return a.tick < b.tick;
+    return a.velocity == 0 && b.velocity != 0;
+}
+
+void SequenceManager::appendEvents(std::vector<NoteEvent>& events, const Note& note) {
+    events.push_back({note.startTick, note.id, note.noteNumber, note.velocity});
+    events.push_back({note.startTick + note.durationTicks, note.id, note.noteNumber, 0});
+}
+
+void SequenceManager::insertEvent(Track& track, const NoteEvent& event) {
+    auto it = std::upper_bound(track.events.begin(), track.events.end(), event, eventBefore);
+    size_t index = static_cast<size_t>(it - track.events.begin());
+    track.events.insert(it, event);
+    track.loopCursor = Track::NO_CURSOR;
+    track.notesVersion++;
+    
+    // Events inserted behind the playhead must not fire in this pass
+    if (index < track.eventCursor) {
+        track.eventCursor++;
+    }
+}
+
+// Recompile the whole event list from the track's notes with a single sort;
+// cheaper than inserting one note at a time when many notes change at once.
+// Events before positionTick count as already fired.
+void SequenceManager::rebuildEvents(Track& track, double positionTick) {
+    track.events.clear();
+    track.events.reserve(track.notes.size() * 2);
+    for (const Note& note : track.notes) {
+        appendEvents(track.events, note);
+    }
+    std::stable_sort(track.events.begin(), track.events.end(), eventBefore);
+    track.loopCursor = Track::NO_CURSOR;
+    track.notesVersion++;
+    track.eventCursor = static_cast<size_t>(
+        std::lower_bound(track.events.begin(), track.events.end(), positionTick,
+                         [](const NoteEvent& event, double tick) { return event.tick < tick; }) -
+        track.events.begin());
+}
+
+// Merge a batch of new events into the sorted list in one pass. As with
+// insertEvent, new events go after equal ones and only those landing among the
+// already fired events move the cursor.
+void SequenceManager::mergeEvents(Track& track, std::vector<NoteEvent>& added) {
+    std::stable_sort(added.begin(), added.end(), eventBefore);
+    
+    size_t addedBeforeCursor = 0;
+    if (track.eventCursor > 0) {
+        addedBeforeCursor = static_cast<size_t>(
+            std::lower_bound(added.begin(), added.end(), track.events[track.eventCursor - 1], eventBefore) -
+            added.begin());
+    }
+    
+    std::vector<NoteEvent> merged;
+    merged.reserve(track.events.size() + added.size());
+    std::merge(track.events.begin(), track.events.end(), added.begin(), added.end(),
+               std::back_inserter(merged), eventBefore);
+    track.events.swap(merged);
+    track.eventCursor += addedBeforeCursor;
+    track.loopCursor = Track::NO_CURSOR;
+    track.notesVersion++;
+}
+
+// Replace the events of edited notes: one pass to drop the old ones, one merge
+// to add those of the notes that still exist
+void SequenceManager::recompileNotes(Track& track, std::vector<int>& noteIds) {
+    std::sort(noteIds.begin(), noteIds.end());
+    noteIds.erase(std::unique(noteIds.begin(), noteIds.end()), noteIds.end());
+    removeEvents(track, noteIds);
+    
+    std::vector<NoteEvent> added;
+    added.reserve(noteIds.size() * 2);
+    for (int noteId : noteIds) {
+        const Note* note = track.notes.find(noteId);
+        if (note) {
+            appendEvents(added, *note);
+        }
+    }
+    mergeEvents(track, added);
+}
+
+// Remove the events of every note in noteIds (sorted) in one pass
+void SequenceManager::removeEvents(Track& track, const std::vector<int>& noteIds) {
+    size_t write = 0;
+    size_t cursor = track.eventCursor;
+    for (size_t read = 0; read < track.events.size(); read++) {
+        if (std::binary_search(noteIds.begin(), noteIds.end(), track.events[read].noteId)) {
+            if (read < track.eventCursor) {
+                cursor--;
+            }
+            continue;
+        }
+        track.events[write++] = track.events[read];
+    }
+    track.events.resize(write);
+    track.eventCursor = cursor;
+    track.loopCursor = Track::NO_CURSOR;
+    track.notesVersion++;
+}
+
+void SequenceManager::reportLoadProgress(uint8_t kind, int id, float fraction) {
+    if (!m_events) {
+        return;
+    }
+    EngineEvent event = {};
+    event.frame = -1;
+    event.value = fraction;
+    event.id = id;
+    event.type = EngineEvent::LOAD_PROGRESS;
+    event.data1 = kind;
+    m_events->pushControl(event);
+}
+
+int SequenceManager::importMidiFile(const std::string& path, int instrumentId) {
+    LOGD("Importing MIDI file %s with instrument %d", path.c_str(), instrumentId);
+    try {
+        if (!m_instrumentManager) {
+            LOGE("InstrumentManager is null");
+            return -1;
+        }
+        if (!m_instrumentManager->getInstrument(instrumentId)) {
+            LOGW("Instrument with ID %d not found", instrumentId);
+            return -1;
+        }
+        
+        // Parse without holding the lock; large files take a while
+        MidiFileData data;
+        MidiFileReader reader;
+        reader.setProgressCallback([this](float fraction) {
+            reportLoadProgress(EngineEvent::LOAD_MIDI_FILE, -1, fraction);
+        });
+        reportLoadProgress(EngineEvent::LOAD_MIDI_FILE, -1, 0.0f);
+        if (!reader.read(path, data)) {
+            LOGE("Failed to read MIDI file %s: %s", path.c_str(), reader.getError().c_str());
+            return -1;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        int sequenceId = m_nextSequenceId++;
+        Sequence& sequence = m_sequences[sequenceId];
+        sequence.id = sequenceId;
+        sequence.ticksPerBeat = data.ticksPerBeat > 0 ? data.ticksPerBeat : m_ticksPerBeat;
+        sequence.isPlaying = false;
+        for (const MidiFileTempo& tempo : data.tempos) {
+            sequence.tempoMap.setTempo(tempo.beat, std::max(TempoMap::MIN_BPM, std::min(TempoMap::MAX_BPM, tempo.bpm)));
+        }
+        for (const MidiFileTimeSignature& timeSignature : data.timeSignatures) {
+            sequence.tempoMap.setTimeSignature(timeSignature.beat, timeSignature.numerator, timeSignature.denominator);
+        }
+        
+        size_t noteCount = 0;
+        for (const MidiFileTrack& fileTrack : data.tracks) {
+            int trackId = m_nextTrackId++;
+            Track& track = sequence.tracks[trackId];
+            track.id = trackId;
+            track.instrumentId = instrumentId;
+            track.volume = 1.0f;
+            track.pan = 0.0f;
+            track.busId = m_instrumentManager->getMixer().acquireBus(trackId);
+            if (track.busId < 0) {
+                LOGW("No free mixer bus for track %d, using master bus", trackId);
+                track.busId = Mixer::MASTER_BUS;
+            }
+            
+            track.notes.reserve(fileTrack.notes.size());
+            for (const MidiFileNote& fileNote : fileTrack.notes) {
+                int noteId = m_nextNoteId++;
+                Note note;
+                note.id = noteId;
+                note.noteNumber = fileNote.noteNumber;
+                note.velocity = std::max<uint8_t>(1, fileNote.velocity);
+                note.startTick = sequence.beatToTick(fileNote.startBeat);
+                note.durationTicks = std::max(1, sequence.beatToTick(fileNote.durationBeats));
+                track.notes.push_back(note);
+            }
+            rebuildEvents(track);
+            noteCount += fileTrack.notes.size();
+        }
+        
+        reportLoadProgress(EngineEvent::LOAD_MIDI_FILE, sequenceId, 1.0f);
+        LOGI("Imported MIDI file %s as sequence %d: %zu tracks, %zu notes, %zu tempo changes",
+             path.c_str(), sequenceId, data.tracks.size(), noteCount, data.tempos.size());
+        return sequenceId;
+    } catch (const std::exception& e) {
+        LOGE("Exception in importMidiFile: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in importMidiFile");
+        return -1;
+    }
+}
+
+int SequenceManager::exportMidiFile(int sequenceId, const std::string& path, ExportCallback onComplete) {
+    LOGD("Exporting sequence %d to MIDI file %s", sequenceId, path.c_str());
+    try {
+        // Snapshot the sequence; the writer never touches live state
+        auto snapshot = std::make_shared<MidiFileData>();
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            
+            auto seqIt = m_sequences.find(sequenceId);
+            if (seqIt == m_sequences.end()) {
+                LOGW("Sequence with ID %d not found", sequenceId);
+                return -1;
+            }
+            
+            snapshot->format = 1;
+            snapshot->ticksPerBeat = seqIt->second.ticksPerBeat;
+            
+            // MIDI tempos only step, so ramps go out as short steps at the
+            // tempo in the middle of each
+            const TempoMap& tempoMap = seqIt->second.tempoMap;
+            const std::vector<TempoEvent>& tempos = tempoMap.tempoEvents();
+            for (size_t i = 0; i < tempos.size(); i++) {
+                if (!tempos[i].ramp || i + 1 == tempos.size()) {
+                    snapshot->tempos.push_back({tempos[i].beat, tempos[i].bpm});
+                    continue;
+                }
+                for (double beat = tempos[i].beat; beat < tempos[i + 1].beat; beat += MIDI_RAMP_STEP) {
+                    double end = std::min(beat + MIDI_RAMP_STEP, tempos[i + 1].beat);
+                    snapshot->tempos.push_back({beat, tempoMap.tempoAt((beat + end) / 2)});
+                }
+            }
+            for (const TimeSignatureEvent& timeSignature : tempoMap.timeSignatures()) {
+                snapshot->timeSignatures.push_back({timeSignature.beat, timeSignature.numerator,
+                                                    timeSignature.denominator});
+            }
+            snapshot->tracks.reserve(seqIt->second.tracks.size());
+            for (const auto& trackPair : seqIt->second.tracks) {
+                const Track& track = trackPair.second;
+                MidiFileTrack fileTrack;
+                fileTrack.name = "Track " + std::to_string(track.id);
+                fileTrack.notes.reserve(track.notes.size());
+                for (const Note& note : track.notes) {
+                    fileTrack.notes.push_back({seqIt->second.tickToBeat(note.startTick),
+                                               seqIt->second.tickToBeat(note.durationTicks),
+                                               static_cast<uint8_t>(note.noteNumber),
+                                               static_cast<uint8_t>(note.velocity)});
+                }
+                snapshot->tracks.push_back(std::move(fileTrack));
+            }
+        }
+        
+        std::lock_guard<std::mutex> exportLock(m_exportMutex);
+        
+        // Reap exports that have already finished
+        for (auto it = m_exportJobs.begin(); it != m_exportJobs.end();) {
+            if ((*it)->finished.load()) {
+                (*it)->thread.join();
+                it = m_exportJobs.erase(it);
+            } else {
+                ++it;
+            }
+        }
+        
+        int exportId = m_nextExportId++;
+        m_exportJobs.push_back(std::make_unique<ExportJob>());
+        ExportJob* job = m_exportJobs.back().get();
+        job->thread = std::thread([job, exportId, path, snapshot, onComplete]() {
+            MidiFileWriter writer;
+            bool success = writer.write(path, *snapshot);
+            if (success) {
+                LOGI("Exported MIDI file %s (export %d)", path.c_str(), exportId);
+            } else {
+                LOGE("Failed to export MIDI file %s: %s", path.c_str(), writer.getError().c_str());
+            }
+            if (onComplete) {
+                onComplete(exportId, success);
+            }
+            job->finished.store(true);
+        });
+        
+        return exportId;
+    } catch (const std::exception& e) {
+        LOGE("Exception in exportMidiFile: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in exportMidiFile");
+        return -1;
+    }
+}
+
+bool SequenceManager::saveProject(const std::string& path) {
+    LOGD("Saving project to %s", path.c_str());
+    try {
+        // Encode under the lock, write outside it
+        project::ProjectData data;
+        size_t noteCount = 0;
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            
+            data.nextSequenceId = m_nextSequenceId;
+            data.nextTrackId = m_nextTrackId;
+            data.nextNoteId = m_nextNoteId;
+            data.ticksPerBeat = static_cast<uint32_t>(m_ticksPerBeat);
+            data.sequences.reserve(m_sequences.size());
+            for (const auto& seqPair : m_sequences) {
+                const Sequence& sequence = seqPair.second;
+                project::SequenceRecord seqRecord = {};
+                seqRecord.id = sequence.id;
+                seqRecord.firstTrack = static_cast<uint32_t>(data.tracks.size());
+                seqRecord.trackCount = static_cast<uint32_t>(sequence.tracks.size());
+                seqRecord.ticksPerBeat = static_cast<uint32_t>(sequence.ticksPerBeat);
+                data.sequences.push_back(seqRecord);
+                
+                data.tempos.emplace_back();
+                for (const TempoEvent& tempo : sequence.tempoMap.tempoEvents()) {
+                    data.tempos.back().push_back({tempo.beat, tempo.bpm, tempo.ramp ? 1u : 0u, 0});
+                }
+                data.timeSignatures.emplace_back();
+                for (const TimeSignatureEvent& timeSignature : sequence.tempoMap.timeSignatures()) {
+                    data.timeSignatures.back().push_back({timeSignature.beat, timeSignature.numerator,
+                                                          timeSignature.denominator});
+                }
+                
+                for (const auto& trackPair : sequence.tracks) {
+                    const Track& track = trackPair.second;
+                    project::TrackRecord record = {};
+                    record.id = track.id;
+                    record.instrumentId = track.instrumentId;
+                    record.volume = track.volume;
+                    record.pan = track.pan;
+                    data.tracks.push_back(record);
+                    
+                    data.notes.emplace_back();
+                    std::vector<project::NoteRecord>& notes = data.notes.back();
+                    notes.reserve(track.notes.size());
+                    int previousId = 0;
+                    int64_t previousStart = 0;
+                    for (const Note& note : track.notes) {
+                        project::NoteRecord noteRecord = {};
+                        noteRecord.idDelta = static_cast<uint32_t>(note.id - previousId);
+                        noteRecord.startDelta = static_cast<int32_t>(note.startTick - previousStart);
+                        noteRecord.durationTicks = static_cast<uint32_t>(note.durationTicks);
+                        noteRecord.noteNumber = note.noteNumber;
+                        noteRecord.velocity = note.velocity;
+                        notes.push_back(noteRecord);
+                        previousId = note.id;
+                        previousStart = note.startTick;
+                    }
+                    noteCount += notes.size();
+                    
+                    data.automation.emplace_back();
+                    data.automation.back().reserve(track.volumeAutomation.points->size());
+                    for (const AutomationPoint& point : *track.volumeAutomation.points) {
+                        data.automation.back().push_back({point.beat, point.value, 0});
+                    }
+                }
+            }
+        }
+        
+        std::string error;
+        if (!project::writeFile(path, data, error)) {
+            LOGE("Failed to save project: %s", error.c_str());
+            return false;
+        }
+        
+        LOGI("Saved project %s: %zu sequences, %zu tracks, %zu notes",
+             path.c_str(), data.sequences.size(), data.tracks.size(), noteCount);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in saveProject: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in saveProject");
+        return false;
+    }
+}
+
+int SequenceManager::loadProject(const std::string& path) {
+    LOGD("Loading project from %s", path.c_str());
+    try {
+        if (!m_instrumentManager) {
+            LOGE("InstrumentManager is null");
+            return -1;
+        }
+        
+        std::string error;
+        project::MappedFile file;
+        if (!file.open(path, error)) {
+            LOGE("Failed to load project %s: %s", path.c_str(), error.c_str());
+            return -1;
+        }
+        
+        // Decode straight from the mapping into flat per-track arrays
+        const project::FileHeader& header = file.header();
+        std::map<int, Sequence> sequences;
+        int maxSequenceId = 0, maxTrackId = 0, maxNoteId = 0;
+        
+        reportLoadProgress(EngineEvent::LOAD_PROJECT, -1, 0.0f);
+        for (uint32_t s = 0; s < header.sequenceCount; s++) {
+            if (s > 0) {
+                reportLoadProgress(EngineEvent::LOAD_PROJECT, -1, static_cast<float>(s) / header.sequenceCount);
+            }
+            const project::SequenceRecord& seqRecord = file.sequences()[s];
+            if (seqRecord.id <= 0 || sequences.count(seqRecord.id)) {
+                LOGE("Failed to load project %s: invalid sequence ID %d", path.c_str(), seqRecord.id);
+                return -1;
+            }
+            if (seqRecord.ticksPerBeat > MAX_TICKS_PER_BEAT) {
+                LOGE("Failed to load project %s: invalid tick grid in sequence %d", path.c_str(), seqRecord.id);
+                return -1;
+            }
+            Sequence& sequence = sequences[seqRecord.id];
+            sequence.id = seqRecord.id;
+            sequence.ticksPerBeat = static_cast<int>(seqRecord.ticksPerBeat);
+            sequence.isPlaying = false;
+            
+            const project::TempoRecord* tempos = file.tempos(seqRecord);
+            for (uint32_t i = 0; i < seqRecord.tempoCount; i++) {
+                if (!sequence.tempoMap.setTempo(tempos[i].beat, tempos[i].bpm, tempos[i].ramp != 0)) {
+                    LOGW("Skipping invalid tempo change in sequence %d", seqRecord.id);
+                }
+            }
+            const project::TimeSignatureRecord* timeSignatures = file.timeSignatures(seqRecord);
+            for (uint32_t i = 0; i < seqRecord.timeSignatureCount; i++) {
+                if (!sequence.tempoMap.setTimeSignature(timeSignatures[i].beat, timeSignatures[i].numerator,
+                                                        timeSignatures[i].denominator)) {
+                    LOGW("Skipping invalid time signature in sequence %d", seqRecord.id);
+                }
+            }
+            maxSequenceId = std::max(maxSequenceId, seqRecord.id);
+            
+            for (uint32_t t = seqRecord.firstTrack; t < seqRecord.firstTrack + seqRecord.trackCount; t++) {
+                const project::TrackRecord& trackRecord = file.tracks()[t];
+                if (trackRecord.id <= 0 || sequence.tracks.count(trackRecord.id)) {
+                    LOGE("Failed to load project %s: invalid track ID %d", path.c_str(), trackRecord.id);
+                    return -1;
+                }
+                Track& track = sequence.tracks[trackRecord.id];
+                track.id = trackRecord.id;
+                track.instrumentId = trackRecord.instrumentId;
+                track.volume = std::isfinite(trackRecord.volume) ? std::max(0.0f, trackRecord.volume) : 1.0f;
+                track.pan = std::isfinite(trackRecord.pan) ? std::max(-1.0f, std::min(1.0f, trackRecord.pan)) : 0.0f;
+                track.busId = Mixer::MASTER_BUS;
+                maxTrackId = std::max(maxTrackId, trackRecord.id);
+                
+                const project::NoteRecord* records = file.notes(trackRecord);
+                track.notes.reserve(trackRecord.noteCount);
+                int64_t id = 0;
+                int64_t start = 0;
+                for (uint32_t n = 0; n < trackRecord.noteCount; n++) {
+                    const project::NoteRecord& record = records[n];
+                    id += record.idDelta;
+                    start += record.startDelta;
+                    if (record.idDelta == 0 || id > INT32_MAX || start < 0 || start > MAX_NOTE_TICK ||
+                        record.durationTicks > static_cast<uint32_t>(MAX_NOTE_TICK) || record.noteNumber > 127) {
+                        LOGE("Failed to load project %s: corrupt note data in track %d", path.c_str(), track.id);
+                        return -1;
+                    }
+                    Note note;
+                    note.id = static_cast<int>(id);
+                    note.noteNumber = record.noteNumber;
+                    note.velocity = static_cast<uint8_t>(std::max(1, std::min(127, static_cast<int>(record.velocity))));
+                    note.startTick = static_cast<int32_t>(start);
+                    note.durationTicks = static_cast<int32_t>(std::max<uint32_t>(1, record.durationTicks));
+                    track.notes.push_back(note);
+                }
+                if (!track.notes.empty()) {
+                    maxNoteId = std::max(maxNoteId, track.notes.back().id);
+                }
+                
+                const project::AutomationRecord* automation = file.automation(trackRecord);
+                std::vector<AutomationPoint>& points = track.volumeAutomation.edit();
+                points.reserve(trackRecord.automationCount);
+                for (uint32_t a = 0; a < trackRecord.automationCount; a++) {
+                    if (std::isfinite(automation[a].beat) && std::isfinite(automation[a].value)) {
+                        points.push_back({automation[a].beat, std::max(0.0f, automation[a].value)});
+                    }
+                }
+                std::stable_sort(points.begin(), points.end(),
+                                 [](const AutomationPoint& a, const AutomationPoint& b) { return a.beat < b.beat; });
+                track.volumeAutomation.invalidateCursor();
+                
+                rebuildEvents(track);
+            }
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        // Replace the current sequences and move the mixer strips over
+        if (m_isPlaying) {
+            stopPlaybackLocked();
+        }
+        Mixer& mixer = m_instrumentManager->getMixer();
+        for (auto& seqPair : m_sequences) {
+            for (auto& trackPair : seqPair.second.tracks) {
+                mixer.releaseBus(trackPair.second.busId);
+            }
+        }
+        m_sequences.swap(sequences);
+        clearHistory();
+        
+        for (auto& seqPair : m_sequences) {
+            for (auto& trackPair : seqPair.second.tracks) {
+                Track& track = trackPair.second;
+                track.busId = mixer.acquireBus(track.id);
+                if (track.busId < 0) {
+                    LOGW("No free mixer bus for track %d, using master bus", track.id);
+                    track.busId = Mixer::MASTER_BUS;
+                    continue;
+                }
+                mixer.setBusGain(track.busId, track.volume);
+                mixer.setBusPan(track.busId, track.pan);
+            }
+        }
+        
+        m_nextSequenceId = std::max(maxSequenceId + 1, header.nextSequenceId);
+        m_nextTrackId = std::max(maxTrackId + 1, header.nextTrackId);
+        m_nextNoteId = std::max(maxNoteId + 1, header.nextNoteId);
+        if (header.ticksPerBeat <= static_cast<uint32_t>(MAX_TICKS_PER_BEAT)) {
+            m_ticksPerBeat = static_cast<int>(header.ticksPerBeat);
+        }
+        m_currentPositionInBeats = 0.0;
+        
+        reportLoadProgress(EngineEvent::LOAD_PROJECT, -1, 1.0f);
+        LOGI("Loaded project %s: %u sequences, %u tracks",
+             path.c_str(), header.sequenceCount, header.trackCount);
+        return static_cast<int>(header.sequenceCount);
+    } catch (const std::exception& e) {
+        LOGE("Exception in loadProject: %s", e.what());
+        return -1;
+    } catch (...) {
+        LOGE("Unknown exception in loadProject");
+        return -1;
+    }
+}
+
+bool SequenceManager::undo() {
+    LOGD("Undo");
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return stepHistory(m_undoStack, m_redoStack);
+    } catch (const std::exception& e) {
+        LOGE("Exception in undo: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in undo");
+        return false;
+    }
+}
+
+bool SequenceManager::redo() {
+    LOGD("Redo");
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return stepHistory(m_redoStack, m_undoStack);
+    } catch (const std::exception& e) {
+        LOGE("Exception in redo: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in redo");
+        return false;
+    }
+}
+
+void SequenceManager::setUndoLimits(int maxLevels, size_t maxBytes) {
+    LOGD("Setting undo limits: %d levels, %zu bytes", maxLevels, maxBytes);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_maxUndoLevels = std::max(0, maxLevels);
+    m_maxUndoBytes = maxBytes;
+    trimHistory();
+}
+
+void SequenceManager::clearHistory() {
+    m_undoStack.clear();
+    m_redoStack.clear();
+    m_historyBytes = 0;
+}
+
+SequenceManager::HistoryEntry SequenceManager::snapshotSequences(const std::vector<int>& sequenceIds) const {
+    HistoryEntry entry;
+    for (int sequenceId : sequenceIds) {
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            continue;
+        }
+        
+        // Copying a NoteList only copies its chunk pointers, and the automation
+        // is shared the same way
+        SequenceSnapshot snapshot;
+        snapshot.sequenceId = sequenceId;
+        snapshot.tempoMap = seqIt->second.tempoMap;
+        snapshot.tracks.reserve(seqIt->second.tracks.size());
+        for (const auto& trackPair : seqIt->second.tracks) {
+            const Track& track = trackPair.second;
+            snapshot.tracks.push_back({track.id, track.instrumentId, track.volume, track.pan,
+                                       track.notes, track.volumeAutomation.points});
+        }
+        entry.sequences.push_back(std::move(snapshot));
+    }
+    return entry;
+}
+
+// Memory an entry holds on its own: its pointer arrays, plus the note chunks
+// and automation the following version no longer shares (the ones the edit
+// after it copied). Without a following version only the overhead counts.
+//
+// Snapshot tracks are in ID order and an edit copies chunks in place, so the
+// chunks the two versions share are the common run at each end of the track;
+// everything between is counted as the entry's own. Edits to several separate
+// spots of one track count the chunks between them too, which errs towards
+// trimming history early rather than late.
+size_t SequenceManager::snapshotBytes(const HistoryEntry& entry, const HistoryEntry* next) {
+    size_t bytes = sizeof(HistoryEntry);
+    for (const SequenceSnapshot& sequence : entry.sequences) {
+        const SequenceSnapshot* nextSequence = nullptr;
+        if (next) {
+            for (const SequenceSnapshot& candidate : next->sequences) {
+                if (candidate.sequenceId == sequence.sequenceId) {
+                    nextSequence = &candidate;
+                }
+            }
+        }
+        
+        size_t nextIndex = 0;
+        for (const TrackSnapshot& track : sequence.tracks) {
+            bytes += sizeof(TrackSnapshot) + track.notes.chunkCount() * sizeof(std::shared_ptr<void>);
+            if (!next) {
+                continue;
+            }
+            
+            const TrackSnapshot* nextTrack = nullptr;
+            if (nextSequence) {
+                const std::vector<TrackSnapshot>& nextTracks = nextSequence->tracks;
+                while (nextIndex < nextTracks.size() && nextTracks[nextIndex].id < track.id) {
+                    nextIndex++;
+                }
+                if (nextIndex < nextTracks.size() && nextTracks[nextIndex].id == track.id) {
+                    nextTrack = &nextTracks[nextIndex];
+                }
+            }
+            if (!nextTrack || nextTrack->automation != track.automation) {
+                bytes += track.automation->capacity() * sizeof(AutomationPoint);
+            }
+            const NoteList* nextNotes = nextTrack ? &nextTrack->notes : nullptr;
+            
+            size_t count = track.notes.chunkCount();
+            size_t head = 0;
+            size_t tail = 0;
+            if (nextNotes) {
+                size_t nextCount = nextNotes->chunkCount();
+                while (head < count && head < nextCount &&
+                       track.notes.chunkAt(head) == nextNotes->chunkAt(head)) {
+                    head++;
+                }
+                while (tail < count - head && tail < nextCount - head &&
+                       track.notes.chunkAt(count - 1 - tail) == nextNotes->chunkAt(nextCount - 1 - tail)) {
+                    tail++;
+                }
+            }
+            for (size_t i = head; i < count - tail; i++) {
+                bytes += track.notes.chunkBytes(i);
+            }
+        }
+    }
+    return bytes;
+}
+
+void SequenceManager::recordUndo(const std::vector<int>& sequenceIds) {
+    if (m_maxUndoLevels == 0) {
+        return;
+    }
+    
+    HistoryEntry entry = snapshotSequences(sequenceIds);
+    if (entry.sequences.empty()) {
+        return;
+    }
+    
+    // The previous top now knows which chunks it alone keeps
+    if (!m_undoStack.empty()) {
+        HistoryEntry& previous = m_undoStack.back();
+        m_historyBytes -= previous.bytes;
+        previous.bytes = snapshotBytes(previous, &entry);
+        m_historyBytes += previous.bytes;
+    }
+    
+    entry.bytes = snapshotBytes(entry, nullptr);
+    m_historyBytes += entry.bytes;
+    m_undoStack.push_back(std::move(entry));
+    
+    // A new edit forks the history
+    for (const HistoryEntry& redo : m_redoStack) {
+        m_historyBytes -= redo.bytes;
+    }
+    m_redoStack.clear();
+    
+    trimHistory();
+}
+
+void SequenceManager::trimHistory() {
+    while (!m_undoStack.empty() &&
+           (static_cast<int>(m_undoStack.size()) > m_maxUndoLevels ||
+            (m_historyBytes > m_maxUndoBytes && m_undoStack.size() > 1))) {
+        m_historyBytes -= m_undoStack.front().bytes;
+        m_undoStack.pop_front();
+    }
+    while (m_historyBytes > m_maxUndoBytes && !m_redoStack.empty()) {
+        m_historyBytes -= m_redoStack.front().bytes;
+        m_redoStack.pop_front();
+    }
+}
+
+void SequenceManager::forgetSequenceHistory(int sequenceId) {
+    for (std::deque<HistoryEntry>* stack : {&m_undoStack, &m_redoStack}) {
+        for (auto it = stack->begin(); it != stack->end();) {
+            auto& sequences = it->sequences;
+            sequences.erase(std::remove_if(sequences.begin(), sequences.end(),
+                                           [sequenceId](const SequenceSnapshot& snapshot) {
+                                               return snapshot.sequenceId == sequenceId;
+                                           }),
+                            sequences.end());
+            if (sequences.empty()) {
+                m_historyBytes -= it->bytes;
+                it = stack->erase(it);
+            } else {
+                ++it;
+            }
+        }
+    }
+}
+
+// Swap the live state of the entry's sequences with the entry, moving the
+// replaced state onto the other stack
+bool SequenceManager::stepHistory(std::deque<HistoryEntry>& from, std::deque<HistoryEntry>& to) {
+    if (from.empty() || !m_instrumentManager) {
+        LOGD("Nothing to %s", &from == &m_undoStack ? "undo" : "redo");
+        return false;
+    }
+    
+    HistoryEntry entry = std::move(from.back());
+    from.pop_back();
+    m_historyBytes -= entry.bytes;
+    
+    std::vector<int> sequenceIds;
+    for (const SequenceSnapshot& snapshot : entry.sequences) {
+        sequenceIds.push_back(snapshot.sequenceId);
+    }
+    HistoryEntry current = snapshotSequences(sequenceIds);
+    
+    for (const SequenceSnapshot& snapshot : entry.sequences) {
+        restoreSequence(snapshot);
+    }
+    
+    current.bytes = snapshotBytes(current, nullptr);
+    m_historyBytes += current.bytes;
+    to.push_back(std::move(current));
+    trimHistory();
+    return true;
+}
+
+void SequenceManager::restoreSequence(const SequenceSnapshot& snapshot) {
+    auto seqIt = m_sequences.find(snapshot.sequenceId);
+    if (seqIt == m_sequences.end()) {
+        return;
+    }
+    Sequence& sequence = seqIt->second;
+    Mixer& mixer = m_instrumentManager->getMixer();
+    
+    // Release whatever is sounding; its note offs may not survive the swap
+    bool active = m_isPlaying && m_activeSequenceId == sequence.id;
+    double positionTick = active ? m_currentPositionInBeats * sequence.ticksPerBeat : 0.0;
+    if (active) {
+        for (auto& trackPair : sequence.tracks) {
+            releaseSounding(trackPair.second, m_audioFrame.load());
+        }
+    }
+    
+    // Drop tracks the snapshot doesn't have
+    for (auto it = sequence.tracks.begin(); it != sequence.tracks.end();) {
+        bool kept = std::any_of(snapshot.tracks.begin(), snapshot.tracks.end(),
+                                [&](const TrackSnapshot& track) { return track.id == it->first; });
+        if (kept) {
+            ++it;
+        } else {
+            mixer.releaseBus(it->second.busId);
+            it = sequence.tracks.erase(it);
+        }
+    }
+    
+    for (const TrackSnapshot& saved : snapshot.tracks) {
+        auto trackIt = sequence.tracks.find(saved.id);
+        if (trackIt == sequence.tracks.end()) {
+            Track& track = sequence.tracks[saved.id];
+            track.id = saved.id;
+            track.busId = mixer.acquireBus(saved.id);
+            if (track.busId < 0) {
+                LOGW("No free mixer bus for track %d, using master bus", saved.id);
+                track.busId = Mixer::MASTER_BUS;
+            }
+            trackIt = sequence.tracks.find(saved.id);
+        }
+        
+        Track& track = trackIt->second;
+        track.instrumentId = saved.instrumentId;
+        track.volume = saved.volume;
+        track.pan = saved.pan;
+        if (track.busId != Mixer::MASTER_BUS) {
+            mixer.setBusGain(track.busId, track.volume);
+            mixer.setBusPan(track.busId, track.pan);
+        }
+        track.notes = saved.notes;
+        track.volumeAutomation.points = saved.automation;
+        track.volumeAutomation.invalidateCursor();
+        rebuildEvents(track, positionTick);
+    }
+    
+    sequence.tempoMap = snapshot.tempoMap;
+}
+
+bool SequenceManager::setTempoChange(int sequenceId, double beat, double bpm, bool ramp) {
+    LOGD("Setting tempo of sequence %d at beat %f to %f (ramp=%d)", sequenceId, beat, bpm, ramp);
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        // Validate before recording, so a rejected change leaves no undo level
+        TempoMap tempoMap = seqIt->second.tempoMap;
+        if (!tempoMap.setTempo(beat, bpm, ramp)) {
+            LOGW("Invalid tempo change: %f BPM at beat %f", bpm, beat);
+            return false;
+        }
+        recordUndo(sequenceId);
+        seqIt->second.tempoMap = std::move(tempoMap);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in setTempoChange: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in setTempoChange");
+        return false;
+    }
+}
+
+bool SequenceManager::removeTempoChange(int sequenceId, double beat) {
+    LOGD("Removing tempo change of sequence %d at beat %f", sequenceId, beat);
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        TempoMap tempoMap = seqIt->second.tempoMap;
+        if (!tempoMap.removeTempo(beat)) {
+            LOGW("No removable tempo change at beat %f", beat);
+            return false;
+        }
+        recordUndo(sequenceId);
+        seqIt->second.tempoMap = std::move(tempoMap);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in removeTempoChange: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in removeTempoChange");
+        return false;
+    }
+}
+
+bool SequenceManager::setTimeSignature(int sequenceId, double beat, int numerator, int denominator) {
+    LOGD("Setting time signature of sequence %d at beat %f to %d/%d", sequenceId, beat, numerator, denominator);
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        TempoMap tempoMap = seqIt->second.tempoMap;
+        if (!tempoMap.setTimeSignature(beat, numerator, denominator)) {
+            LOGW("Invalid time signature %d/%d at beat %f", numerator, denominator, beat);
+            return false;
+        }
+        recordUndo(sequenceId);
+        seqIt->second.tempoMap = std::move(tempoMap);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in setTimeSignature: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in setTimeSignature");
+        return false;
+    }
+}
+
+double SequenceManager::beatToSeconds(int sequenceId, double beat) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto seqIt = m_sequences.find(sequenceId);
+    return seqIt == m_sequences.end() ? -1.0 : seqIt->second.tempoMap.secondsAt(beat);
+}
+
+double SequenceManager::secondsToBeat(int sequenceId, double seconds) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    auto seqIt = m_sequences.find(sequenceId);
+    return seqIt == m_sequences.end() ? -1.0 : seqIt->second.tempoMap.beatAt(seconds);
+}
+
+bool SequenceManager::setLoopRegion(int sequenceId, double startBeat, double endBeat) {
+    LOGD("Setting loop region of sequence %d to %f-%f", sequenceId, startBeat, endBeat);
+    try {
+        if (!std::isfinite(startBeat) || !std::isfinite(endBeat) || startBeat < 0.0) {
+            LOGW("Invalid loop region %f-%f", startBeat, endBeat);
+            return false;
+        }
+        
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        Sequence& sequence = seqIt->second;
+        bool empty = endBeat <= startBeat;
+        sequence.loopStart = empty ? 0.0 : startBeat;
+        sequence.loopEnd = empty ? 0.0 : endBeat;
+        
+        if (m_isPlaying && m_activeSequenceId == sequenceId) {
+            resolveLoopRegion(sequence);
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in setLoopRegion: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in setLoopRegion");
+        return false;
+    }
+}
+
+void SequenceManager::resolveLoopRegion(Sequence& sequence) {
+    if (sequence.loopEnd > sequence.loopStart) {
+        m_loopStart = sequence.loopStart;
+        m_loopEnd = sequence.loopEnd;
+    } else {
+        double end = 0.0;
+        for (const auto& trackPair : sequence.tracks) {
+            if (!trackPair.second.events.empty()) {
+                end = std::max(end, sequence.tickToBeat(trackPair.second.events.back().tick));
+            }
+        }
+        m_loopStart = 0.0;
+        m_loopEnd = std::ceil(end);
+    }
+    
+    for (auto& trackPair : sequence.tracks) {
+        trackPair.second.loopCursor = Track::NO_CURSOR;
+    }
+}
+
+bool SequenceManager::startPlayback(int sequenceId, bool loop) {
+    LOGD("Starting playback of sequence %d, loop=%d", sequenceId, loop);
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        // Check if the sequence exists
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        // Stop any currently playing sequence
+        if (m_isPlaying) {
+            stopPlaybackLocked();
+        }
+        
+        // Start from the cued position, chasing notes that span it; notes
+        // starting there fire on the next audio block
+        Sequence& sequence = seqIt->second;
+        for (auto& trackPair : sequence.tracks) {
+            trackPair.second.sounding.reset();
+        }
+        chaseTo(sequence, sequence.cuePosition, true);
+        sequence.cuePosition = 0.0;
+        m_looping = loop;
+        if (loop) {
+            resolveLoopRegion(seqIt->second);
+        }
+        
+        // Set the active sequence
+        m_activeSequenceId = sequenceId;
+        seqIt->second.isPlaying = true;
+        m_isPlaying = true;
+        
+        LOGI("Started playback of sequence %d", sequenceId);
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in startPlayback: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in startPlayback");
+        return false;
+    }
+}
+
+bool SequenceManager::stopPlayback() {
+    LOGD("Stopping playback");
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        return stopPlaybackLocked();
+    } catch (const std::exception& e) {
+        LOGE("Exception in stopPlayback: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in stopPlayback");
+        return false;
+    }
+}
+
+bool SequenceManager::stopPlaybackLocked() {
+    if (!m_isPlaying) {
+        LOGW("No sequence is currently playing");
+        return true;
+    }
+    
+    // Stop all active notes; events already queued ahead are dropped
+    restartTransport();
+    if (m_activeSequenceId >= 0) {
+        auto seqIt = m_sequences.find(m_activeSequenceId);
+        if (seqIt != m_sequences.end()) {
+            for (auto& trackPair : seqIt->second.tracks) {
+                releaseSounding(trackPair.second, m_scheduledFrame.load());
+            }
+            
+            seqIt->second.isPlaying = false;
+        }
+    }
+    
+    m_activeSequenceId = -1;
+    m_isPlaying = false;
+    m_looping = false;
+    
+    LOGI("Playback stopped");
+    return true;
+}
+
+bool SequenceManager::setPlaybackPosition(int sequenceId, double beat, bool offsetIntoNotes) {
+    LOGD("Setting playback position of sequence %d to beat %f", sequenceId, beat);
+    try {
+        if (!std::isfinite(beat) || beat < 0.0) {
+            LOGW("Invalid playback position: %f", beat);
+            return false;
+        }
+        
+        std::unique_lock<std::mutex> lock(m_mutex);
+        
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return false;
+        }
+        
+        if (m_isPlaying && m_activeSequenceId == sequenceId) {
+            // Bring the note indexes up to date first; their sorts release the
+            // lock, so the sequence is looked up again afterwards
+            std::vector<int> trackIds;
+            for (const auto& trackPair : seqIt->second.tracks) {
+                trackIds.push_back(trackPair.first);
+            }
+            for (int trackId : trackIds) {
+                indexedTrack(lock, sequenceId, trackId);
+            }
+            seqIt = m_sequences.find(sequenceId);
+            if (seqIt == m_sequences.end()) {
+                LOGW("Sequence with ID %d not found", sequenceId);
+                return false;
+            }
+        }
+        
+        if (m_isPlaying && m_activeSequenceId == sequenceId) {
+            chaseTo(seqIt->second, beat, offsetIntoNotes);
+        } else {
+            seqIt->second.cuePosition = beat;
+        }
+        return true;
+    } catch (const std::exception& e) {
+        LOGE("Exception in setPlaybackPosition: %s", e.what());
+        return false;
+    } catch (...) {
+        LOGE("Unknown exception in setPlaybackPosition");
+        return false;
+    }
+}
+
+double SequenceManager::getPlaybackPosition(int sequenceId) {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    
+    auto seqIt = m_sequences.find(sequenceId);
+    if (seqIt == m_sequences.end()) {
+        LOGW("Sequence with ID %d not found", sequenceId);
+        return -1.0;
+    }
+    if (m_isPlaying && m_activeSequenceId == sequenceId) {
+        return m_audiblePosition.load();
+    }
+    return seqIt->second.cuePosition;
+}
+
+bool SequenceManager::getAudiblePosition(double& beat, double& beatsPerSecond, int& sequenceId) const {
+    beat = m_audiblePosition.load(std::memory_order_relaxed);
+    if (!m_isPlaying) {
+        beatsPerSecond = 0.0;
+        sequenceId = -1;
+        return false;
+    }
+    beatsPerSecond = m_audibleTempo.load(std::memory_order_relaxed);
+    sequenceId = m_audibleSequenceId.load(std::memory_order_relaxed);
+    return true;
+}
+
+bool SequenceManager::setLookahead(int blocks) {
+    if (blocks < 1 || blocks > MAX_LOOKAHEAD_BLOCKS) {
+        LOGW("Invalid scheduler lookahead: %d blocks", blocks);
+        return false;
+    }
+    m_lookaheadBlocks.store(blocks);
+    return true;
+}
+
+void SequenceManager::runScheduler() {
+    LOGD("Scheduler thread started");
+    while (m_schedulerRunning.load()) {
+        int sampleRate = m_renderSampleRate.load(std::memory_order_relaxed);
+        int blockFrames = m_renderBlockFrames.load(std::memory_order_relaxed);
+        int waitMs = 5;
+        if (sampleRate > 0 && blockFrames > 0) {
+            // Keep the queue filled lookahead blocks past the audio clock,
+            // leaving headroom for edits that queue note offs
+            int64_t target = m_audioFrame.load(std::memory_order_acquire) +
+                             static_cast<int64_t>(m_lookaheadBlocks.load()) * blockFrames;
+            while (m_isPlaying && m_scheduledFrame.load() < target &&
+                   m_eventQueue.freeSpace() >= m_eventQueue.capacity() / 2) {
+                scheduleBlock(blockFrames, sampleRate);
+            }
+            
+            // Poll a few times per block, so the render thread never signals
+            waitMs = std::max(1, blockFrames * 1000 / sampleRate / 4);
+        }
+        
+        std::unique_lock<std::mutex> lock(m_schedulerMutex);
+        m_schedulerWakeup.wait_for(lock, std::chrono::milliseconds(waitMs),
+                                   [this] { return !m_schedulerRunning.load(); });
+    }
+    LOGD("Scheduler thread stopped");
+}
+
+void SequenceManager::stopScheduler() {
+    {
+        std::lock_guard<std::mutex> lock(m_schedulerMutex);
+        m_schedulerRunning.store(false);
+    }
+    m_schedulerWakeup.notify_all();
+    if (m_schedulerThread.joinable()) {
+        m_schedulerThread.join();
+    }
+}
+
+// Invalidate what is queued ahead and schedule from the audio clock again
+void SequenceManager::restartTransport() {
+    m_generation.fetch_add(1, std::memory_order_release);
+    m_scheduledFrame.store(m_audioFrame.load(std::memory_order_acquire));
+}
+
+void SequenceManager::queueEvent(const ScheduledEvent& event) {
+    if (!m_eventQueue.push(event)) {
+        if (m_droppedEvents++ == 0) {
+            LOGW("Event queue full, dropping scheduled events");
+        }
+    }
+}
+
+void SequenceManager::renderEvents(int numFrames, int sampleRate) {
+    if (numFrames <= 0 || sampleRate <= 0 || !m_instrumentManager) {
+        return;
+    }
+    m_renderSampleRate.store(sampleRate, std::memory_order_relaxed);
+    m_renderBlockFrames.store(numFrames, std::memory_order_relaxed);
+    
+    int64_t blockStart = m_audioFrame.load(std::memory_order_relaxed);
+    int64_t blockEnd = blockStart + numFrames;
+    uint32_t generation = m_generation.load(std::memory_order_acquire);
+    Mixer& mixer = m_instrumentManager->getMixer();
+    
+    // Published events are stamped on the instruments' render frame counter,
+    // the timeline every other engine event uses
+    int64_t renderFrame = m_instrumentManager->getRenderedFrames();
+    auto publishEvent = [&](uint8_t type, int32_t sequenceId, double value, int delay) {
+        if (m_events) {
+            EngineEvent published = {};
+            published.frame = renderFrame + delay;
+            published.value = value;
+            published.id = sequenceId;
+            published.type = type;
+            m_events->pushAudio(published);
+        }
+    };
+    
+    // Events come in the order they were queued, which is time order within a
+    // generation. A newer generation is bumped before its events are queued,
+    // so re-reading it tells a stale event from one queued after the read.
+    while (const ScheduledEvent* event = m_eventQueue.front()) {
+        if (event->generation != generation) {
+            generation = m_generation.load(std::memory_order_acquire);
+        }
+        bool stale = event->generation != generation;
+        if (!stale && event->frame >= blockEnd) {
+            break;
+        }
+        
+        // Notes land on their own frame within the block; late ones at its start
+        int delay = stale ? 0 : static_cast<int>(std::max<int64_t>(0, event->frame - blockStart));
+        switch (event->type) {
+            case ScheduledEvent::NOTE_ON:
+                if (!stale) {
+                    m_instrumentManager->sendNoteOn(event->instrumentId, event->noteNumber, event->velocity,
+                                                    event->bus, event->value, delay);
+                }
+                break;
+            case ScheduledEvent::NOTE_OFF:
+                // Stale note offs still apply: their note ons may have sounded
+                m_instrumentManager->sendNoteOff(event->instrumentId, event->noteNumber, delay);
+                break;
+            case ScheduledEvent::AUTOMATION:
+                if (!stale) {
+                    mixer.rampBusAutomation(event->bus, static_cast<float>(event->value), numFrames);
+                }
+                break;
+            case ScheduledEvent::POSITION:
+                if (!stale) {
+                    m_audiblePosition.store(event->value, std::memory_order_relaxed);
+                    m_audibleTempo.store(event->tempo, std::memory_order_relaxed);
+                    m_audibleSequenceId.store(event->instrumentId, std::memory_order_relaxed);
+                    publishEvent(EngineEvent::POSITION, event->instrumentId, event->value, delay);
+                }
+                break;
+            case ScheduledEvent::LOOP_WRAP:
+                if (!stale) {
+                    publishEvent(EngineEvent::LOOP_WRAPPED, event->instrumentId, event->value, delay);
+                }
+                break;
+        }
+        m_eventQueue.pop();
+    }
+    
+    m_audioFrame.store(blockEnd, std::memory_order_release);
+}
+
+void SequenceManager::scheduleBlock(int numFrames, int sampleRate) {
+    if (!m_isPlaying || numFrames <= 0 || sampleRate <= 0) {
+        return;
+    }
+    
+    try {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        
+        // Claim the frames first so a failed pass can't stall the scheduler
+        int64_t blockFrame = m_scheduledFrame.load();
+        m_scheduledFrame.store(blockFrame + numFrames);
+        uint32_t generation = m_generation.load(std::memory_order_relaxed);
+        
+        auto seqIt = m_sequences.find(m_activeSequenceId);
+        if (seqIt == m_sequences.end()) {
+            return;
+        }
+        Sequence& sequence = seqIt->second;
+        
+        const TempoMap& tempoMap = sequence.tempoMap;
+        
+        ScheduledEvent position = {};
+        position.frame = blockFrame;
+        position.value = m_currentPositionInBeats;
+        position.generation = generation;
+        position.instrumentId = sequence.id;
+        position.tempo = static_cast<float>(tempoMap.tempoAt(m_currentPositionInBeats) / 60.0);
+        position.type = ScheduledEvent::POSITION;
+        
+        // Advance in time through the tempo map. Play up to the loop end, wrap
+        // on the first frame that reaches it and carry the overshoot past the
+        // loop start, so the loop never drifts. A playhead already past the
+        // loop end plays on without looping.
+        int frame = 0;
+        while (frame < numFrames) {
+            double position = m_currentPositionInBeats;
+            double positionSeconds = tempoMap.secondsAt(position);
+            double segmentEnd = tempoMap.beatAt(positionSeconds + static_cast<double>(numFrames - frame) / sampleRate);
+            bool wraps = m_looping && m_loopEnd > m_loopStart && position < m_loopEnd && segmentEnd >= m_loopEnd;
+            EventClock clock = {blockFrame + frame, positionSeconds, sampleRate};
+            if (!wraps) {
+                for (auto& trackPair : sequence.tracks) {
+                    fireEvents(trackPair.second, sequence, segmentEnd * sequence.ticksPerBeat, clock);
+                }
+                m_currentPositionInBeats = segmentEnd;
+                break;
+            }
+            
+            double loopStartSeconds = tempoMap.secondsAt(m_loopStart);
+            double loopEndSeconds = tempoMap.secondsAt(m_loopEnd);
+            int wrapFrames = static_cast<int>(std::ceil((loopEndSeconds - positionSeconds) * sampleRate));
+            wrapFrames = std::max(1, std::min(wrapFrames, numFrames - frame));
+            for (auto& trackPair : sequence.tracks) {
+                Track& track = trackPair.second;
+                fireEvents(track, sequence, m_loopEnd * sequence.ticksPerBeat, clock);
+                
+                // Notes still held at the loop end would otherwise never get
+                // their note off; the cursor jump is O(1) once found
+                releaseSounding(track, blockFrame + frame + wrapFrames);
+                if (track.loopCursor == Track::NO_CURSOR) {
+                    track.loopCursor = static_cast<size_t>(
+                        std::lower_bound(track.events.begin(), track.events.end(), m_loopStart * sequence.ticksPerBeat,
+                                         [](const NoteEvent& event, double tick) { return event.tick < tick; }) -
+                        track.events.begin());
+                }
+                track.eventCursor = track.loopCursor;
+            }
+            
+            ScheduledEvent wrap = {};
+            wrap.frame = blockFrame + frame + wrapFrames;
+            wrap.value = m_loopStart;
+            wrap.generation = generation;
+            wrap.instrumentId = sequence.id;
+            wrap.type = ScheduledEvent::LOOP_WRAP;
+            queueEvent(wrap);
+            
+            // Loops shorter than a frame still have to land inside the region
+            double overshoot = positionSeconds + static_cast<double>(wrapFrames) / sampleRate - loopEndSeconds;
+            if (overshoot >= loopEndSeconds - loopStartSeconds) {
+                overshoot = std::fmod(overshoot, loopEndSeconds - loopStartSeconds);
+            }
+            frame += wrapFrames;
+            m_currentPositionInBeats = tempoMap.beatAt(loopStartSeconds + overshoot);
+        }
+        
+        // Ramp each strip's automation gain to the lane's value at the block end
+        for (auto& trackPair : sequence.tracks) {
+            Track& track = trackPair.second;
+            if (track.busId != Mixer::MASTER_BUS) {
+                ScheduledEvent event = {};
+                event.frame = blockFrame;
+                event.value = track.volumeAutomation.valueAt(m_currentPositionInBeats);
+                event.generation = generation;
+                event.bus = static_cast<int16_t>(track.busId);
+                event.type = ScheduledEvent::AUTOMATION;
+                queueEvent(event);
+            }
+        }
+        
+        queueEvent(position);
+    } catch (const std::exception& e) {
+        LOGE("Exception in scheduleBlock: %s", e.what());
+    } catch (...) {
+        LOGE("Unknown exception in scheduleBlock");
+    }
+}
+
+// Queue the track's events before endTick, each stamped with the frame the
+// clock reaches it at. Note offs are only queued for notes this track started,
+// so a loop or seek never sends stray ones.
+void SequenceManager::fireEvents(Track& track, const Sequence& sequence, double endTick, const EventClock& clock) {
+    while (track.eventCursor < track.events.size() && track.events[track.eventCursor].tick < endTick) {
+        const NoteEvent& noteEvent = track.events[track.eventCursor++];
+        if (noteEvent.velocity == 0 && !track.sounding.test(noteEvent.noteNumber)) {
+            continue;
+        }
+        track.sounding.set(noteEvent.noteNumber, noteEvent.velocity > 0);
+        
+        double seconds = sequence.tempoMap.secondsAt(sequence.tickToBeat(noteEvent.tick));
+        ScheduledEvent event = {};
+        event.frame = clock.frame + std::max<int64_t>(0, std::llround((seconds - clock.seconds) * clock.sampleRate));
+        event.generation = m_generation.load(std::memory_order_relaxed);
+        event.instrumentId = track.instrumentId;
+        event.bus = static_cast<int16_t>(track.busId);
+        event.type = noteEvent.velocity > 0 ? ScheduledEvent::NOTE_ON : ScheduledEvent::NOTE_OFF;
+        event.noteNumber = noteEvent.noteNumber;
+        event.velocity = noteEvent.velocity;
+        queueEvent(event);
+    }
+}
+
+void SequenceManager::releaseSounding(Track& track, int64_t frame) {
+    ScheduledEvent event = {};
+    event.frame = frame;
+    event.generation = m_generation.load(std::memory_order_relaxed);
+    event.instrumentId = track.instrumentId;
+    event.type = ScheduledEvent::NOTE_OFF;
+    for (int noteNumber = 0; noteNumber < 128 && track.sounding.any(); noteNumber++) {
+        if (track.sounding.test(noteNumber)) {
+            track.sounding.reset(noteNumber);
+            event.noteNumber = static_cast<uint8_t>(noteNumber);
+            queueEvent(event);
+        }
+    }
+}
+
+// Queue the note off for a note about to be edited or deleted if it has been
+// scheduled to start and not yet to end. The scheduler runs ahead of what is
+// audible, so its note on may still be queued: the note off goes behind it
+// at the scheduled frame rather than straight to the instruments, and the
+// sounding bit is only cleared once it's queued.
+void SequenceManager::releaseEditedNote(Track& track, const Sequence& sequence, const Note& note) {
+    double positionTick = m_currentPositionInBeats * sequence.ticksPerBeat;
+    if (note.startTick >= positionTick || note.startTick + note.durationTicks < positionTick ||
+        !track.sounding.test(note.noteNumber)) {
+        return;
+    }
+    ScheduledEvent event = {};
+    event.frame = m_scheduledFrame.load();
+    event.generation = m_generation.load(std::memory_order_relaxed);
+    event.instrumentId = track.instrumentId;
+    event.type = ScheduledEvent::NOTE_OFF;
+    event.noteNumber = note.noteNumber;
+    track.sounding.reset(note.noteNumber);
+    queueEvent(event);
+}
+
+// Move the playhead to beat as if playback had run up to it: release what's
+// sounding, re-find each event cursor and start the notes spanning beat. Notes
+// starting exactly at beat are left to their events.
+void SequenceManager::chaseTo(Sequence& sequence, double beat, bool offsetIntoNotes) {
+    restartTransport();
+    int64_t frame = m_scheduledFrame.load();
+    uint32_t generation = m_generation.load(std::memory_order_relaxed);
+    const TempoMap& tempoMap = sequence.tempoMap;
+    double positionTick = beat * sequence.ticksPerBeat;
+    double positionSeconds = tempoMap.secondsAt(beat);
+    int32_t tick = static_cast<int32_t>(std::min<double>(std::floor(positionTick), INT32_MAX - 1));
+    
+    for (auto& trackPair : sequence.tracks) {
+        Track& track = trackPair.second;
+        releaseSounding(track, frame);
+        track.eventCursor = static_cast<size_t>(
+            std::lower_bound(track.events.begin(), track.events.end(), positionTick,
+                             [](const NoteEvent& event, double t) { return event.tick < t; }) -
+            track.events.begin());
+        track.volumeAutomation.invalidateCursor();
+        if (positionTick <= 0.0) {
+            continue;
+        }
+        
+        if (track.indexVersion != track.notesVersion) {
+            track.noteIndex.build(track.notes);
+            track.indexVersion = track.notesVersion;
+        }
+        track.noteIndex.query(tick, tick + 1, [&](const NoteIndex::Entry& entry) {
+            if (entry.startTick >= positionTick || entry.endTick <= positionTick ||
+                track.sounding.test(entry.noteNumber)) {
+                return;
+            }
+            ScheduledEvent event = {};
+            event.frame = frame;
+            if (offsetIntoNotes) {
+                event.value = positionSeconds - tempoMap.secondsAt(sequence.tickToBeat(entry.startTick));
+            }
+            event.generation = generation;
+            event.instrumentId = track.instrumentId;
+            event.bus = static_cast<int16_t>(track.busId);
+            event.type = ScheduledEvent::NOTE_ON;
+            event.noteNumber = entry.noteNumber;
+            event.velocity = entry.velocity;
+            track.sounding.set(entry.noteNumber);
+            queueEvent(event);
+        });
+    }
+    m_currentPositionInBeats = beat;
+    m_audiblePosition.store(beat);
+}
+
+// Bring a track's note index up to date and return the track, or null if it
+// doesn't exist. The index is sorted from a copy of the note list (its chunks
+// are shared, so copying is cheap) with the lock released, so playback isn't
+// held up; the lock is held again on return.
+Track* SequenceManager::indexedTrack(std::unique_lock<std::mutex>& lock, int sequenceId, int trackId) {
+    auto findTrack = [&]() -> Track* {
+        auto seqIt = m_sequences.find(sequenceId);
+        if (seqIt == m_sequences.end()) {
+            LOGW("Sequence with ID %d not found", sequenceId);
+            return nullptr;
+        }
+        auto trackIt = seqIt->second.tracks.find(trackId);
+        if (trackIt == seqIt->second.tracks.end()) {
+            LOGW("Track with ID %d not found in sequence %d", trackId, sequenceId);
+            return nullptr;
+        }
+        return &trackIt->second;
+    };
+    
+    Track* track = findTrack();
+    if (!track || track->indexVersion == track->notesVersion) {
+        return track;
+    }
+    
+    NoteList notes = track->notes;
+    uint64_t version = track->notesVersion;
+    lock.unlock();
+    NoteIndex index;
+    index.build(notes);
+    lock.lock();
+    
+    track = findTrack();
+    if (!track) {
+        return nullptr;
+    }
+    if (track->notesVersion == version) {
+        track->noteIndex = std::move(index);
+    } else {
+        // Edited meanwhile; rebuild in place rather than race again
+        track->noteIndex.build(track->notes);
     }
+    track->indexVersion = track->notesVersion;
+    return track;
 }
 
 void SequenceManager::processActiveNotes() {
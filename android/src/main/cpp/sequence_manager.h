@@ -6,34 +6,149 @@
 #include <set>
 #include <mutex>
 #include <atomic>
+#include <bitset>
 #include <string>
+#include <cstdint>
+#include <deque>
+#include <functional>
+#include <list>
+#include <memory>
+#include <thread>
+#include <condition_variable>
+#include "note_list.h"
+#include "note_index.h"
+#include "spsc_queue.h"
+#include "tempo_map.h"
 
 class InstrumentManager;
 class AudioEngine;
+class EventPublisher;
+struct EditCommand;
 
-// Structure to represent a note
-struct Note {
-    int id;
-    int noteNumber;
-    int velocity;
+// Note on/off event compiled from a track's notes; velocity 0 is a note off
+struct NoteEvent {
+    int32_t tick;
+    int32_t noteId;
+    uint8_t noteNumber;
+    uint8_t velocity;
+};
+
+// Event handed from the scheduler thread to the render thread, stamped with
+// the audio frame it is due at
+struct ScheduledEvent {
+    enum Type : uint8_t {
+        NOTE_ON,
+        NOTE_OFF,
+        AUTOMATION,  // value is the strip's automation gain at the block end
+        POSITION,    // value is the transport beat at the block start
+        LOOP_WRAP    // value is the loop start beat; instrumentId holds the sequence
+    };
+    int64_t frame;
+    double value;         // See the type; for a note on, seconds into the note to start at
+    uint32_t generation;  // Transport generation it was scheduled in
+    int32_t instrumentId;  // For a position, the playing sequence
+    float tempo;           // For a position, beats per second at the block start
+    int16_t bus;
+    uint8_t type;
+    uint8_t noteNumber;
+    uint8_t velocity;
+};
+
+// Note starts and durations are each capped here so a note's end tick fits
+static constexpr int32_t MAX_NOTE_TICK = INT32_MAX / 2;
+
+// Packed note for bulk insertion; layout matches NoteRecord in the Dart FFI layer
+struct NoteRecord {
     double startTime;
     double duration;
+    int32_t noteNumber;
+    int32_t velocity;
+};
+static_assert(sizeof(NoteRecord) == 24, "NoteRecord layout is shared with Dart");
+
+// Note returned by a range query; layout matches NoteQueryRecord in the Dart FFI layer
+struct NoteQueryRecord {
+    double startTime;
+    double duration;
+    int32_t noteId;
+    int32_t noteNumber;
+    int32_t velocity;
+    int32_t reserved;
+};
+static_assert(sizeof(NoteQueryRecord) == 32, "NoteQueryRecord layout is shared with Dart");
+
+// Breakpoint of a track's volume automation lane
+struct AutomationPoint {
+    double beat;
+    float value;
+};
+
+// Volume automation lane: breakpoints sorted by beat plus a playback cursor.
+// Evaluating at a playhead that moves forward is amortised O(1); jumping
+// backwards re-finds the cursor with a binary search.
+//
+// The breakpoints are shared with undo snapshots the way NoteList chunks are:
+// snapshots copy the pointer, and edit() clones the array first if a snapshot
+// still holds it, so only automation edits pay for a copy.
+struct AutomationLane {
+    using Points = std::vector<AutomationPoint>;
+
+    std::shared_ptr<Points> points = std::make_shared<Points>();
+    size_t cursor = 0;  // Last point at or before the playhead
+
+    // Linear interpolation between breakpoints; 1.0 (no change) when empty
+    float valueAt(double beat);
+
+    // Breakpoints to modify, unshared from any snapshot
+    Points& edit() {
+        if (points.use_count() > 1) {
+            points = std::make_shared<Points>(*points);
+        }
+        return *points;
+    }
+
+    // Force the next valueAt() to re-find the cursor
+    void invalidateCursor() { cursor = points->size(); }
 };
 
 // Structure to represent a track
 struct Track {
     int id;
     int instrumentId;
-    std::map<int, Note> notes;
+    NoteList notes;                // Sorted by ID; IDs only grow, so new notes append
     float volume;
+    float pan;      // -1 (left) to 1 (right)
+    int busId;      // Mixer strip this track renders into
+    
+    // Playback data
+    std::vector<NoteEvent> events;     // Sorted by tick, note offs first on ties
+    size_t eventCursor = 0;            // Next event to fire
+    size_t loopCursor = NO_CURSOR;     // First event at or after the loop start, found lazily
+    std::bitset<128> sounding;         // Note numbers started and not yet released
+    AutomationLane volumeAutomation;   // Multiplies the track volume
+    
+    // Range query index, rebuilt on the first query after the notes change
+    NoteIndex noteIndex;
+    uint64_t notesVersion = 1;         // Bumped whenever the events are recompiled
+    uint64_t indexVersion = 0;         // notesVersion the index was built from
+    
+    static constexpr size_t NO_CURSOR = static_cast<size_t>(-1);
 };
 
 // Structure to represent a sequence
 struct Sequence {
     int id;
-    int tempo;
+    int ticksPerBeat;  // Note positions are whole ticks of this grid
+    TempoMap tempoMap;
     std::map<int, Track> tracks;
     bool isPlaying;
+    double loopStart = 0.0;  // Loop region in beats; empty (end <= start) loops
+    double loopEnd = 0.0;    // the whole sequence
+    double cuePosition = 0.0;  // Beat the next playback starts from
+    
+    // Nearest tick to beat, clamped to [0, MAX_NOTE_TICK]
+    int32_t beatToTick(double beat) const;
+    double tickToBeat(int64_t tick) const { return static_cast<double>(tick) / ticksPerBeat; }
 };
 
 class SequenceManager {
@@ -45,32 +160,238 @@ public:
     // Initialize the sequence manager
     bool init();
 
+    // Tick grid (PPQ) for sequences created from now on; MIDI imports keep
+    // their file's division instead
+    static constexpr int DEFAULT_TICKS_PER_BEAT = 960;
+    static constexpr int MAX_TICKS_PER_BEAT = 32767;
+    bool setTicksPerBeat(int ticksPerBeat);
+
     // Sequence operations
-    int createSequence(int tempo);
+    int createSequence(double bpm, int timeSignatureNumerator = 4, int timeSignatureDenominator = 4);
     bool deleteSequence(int sequenceId);
 
     // Track operations
     int addTrack(int sequenceId, int instrumentId);
     bool deleteTrack(int sequenceId, int trackId);
+    bool setTrackVolume(int sequenceId, int trackId, float volume);
+    bool setTrackPan(int sequenceId, int trackId, float pan);
 
     // Note operations
     int addNote(int sequenceId, int trackId, int noteNumber, int velocity, double startTime, double duration);
     bool deleteNote(int sequenceId, int trackId, int noteId);
 
+    // Add many notes under one lock. outIds[i] receives the ID of records[i],
+    // or -1 if it was rejected; returns the number of notes added or -1 on error
+    int addNotes(int sequenceId, int trackId, const NoteRecord* records, int count, int32_t* outIds);
+
+    // Notes overlapping [startBeat, endBeat) with note numbers in [lowNote,
+    // highNote], in start order; O(log n + k) once the track's index is built.
+    // Writes the first capacity matches to out and returns the total number of
+    // matches, so a caller can retry with a larger buffer, or -1 on error.
+    int queryNotes(int sequenceId, int trackId, double startBeat, double endBeat,
+                   int lowNote, int highNote, NoteQueryRecord* out, int capacity);
+
+    // Apply a batch of decoded edit commands under one lock, so playback never
+    // sees a half-applied batch. Commands that refer to missing sequences,
+    // tracks or notes are skipped; returns the number applied.
+    int applyCommands(const std::vector<EditCommand>& commands);
+
+    // Tempo map edits. A tempo change with ramp set moves linearly to the next
+    // change's tempo; the change at beat 0 can be replaced but not removed.
+    bool setTempoChange(int sequenceId, double beat, double bpm, bool ramp);
+    bool removeTempoChange(int sequenceId, double beat);
+    bool setTimeSignature(int sequenceId, double beat, int numerator, int denominator);
+
+    // Convert between beats and seconds through a sequence's tempo map;
+    // O(log n) in its tempo changes. Return -1 if the sequence doesn't exist.
+    double beatToSeconds(int sequenceId, double beat);
+    double secondsToBeat(int sequenceId, double seconds);
+
+    // Volume automation; returns the number of points added or removed, or -1 on error
+    int addVolumeAutomation(int sequenceId, int trackId, const double* beats, const float* values, int count);
+    int removeVolumeAutomation(int sequenceId, int trackId, double startBeat, double endBeat);
+
+    // Import a Standard MIDI File as a new sequence with one track per MIDI
+    // track and channel, all using the given instrument; returns the sequence ID or -1
+    int importMidiFile(const std::string& path, int instrumentId);
+
+    // Export a sequence to a Standard MIDI File (type 1) on a background
+    // thread. The sequence is snapshotted first, so editing can continue while
+    // the file is written. Returns an export ID passed to onComplete, or -1.
+    using ExportCallback = std::function<void(int exportId, bool success)>;
+    int exportMidiFile(int sequenceId, const std::string& path, ExportCallback onComplete);
+
+    // Save all sequences to a binary project file (see project_file.h)
+    bool saveProject(const std::string& path);
+
+    // Replace all sequences with those of a project file, keeping their saved
+    // IDs; returns the number of sequences loaded or -1 on error
+    int loadProject(const std::string& path);
+
+    // Undo history. Note, track, automation and command-buffer edits are
+    // recorded; direct setTrackVolume/setTrackPan calls are mixer moves and
+    // are not. Each level shares unchanged note chunks with its neighbours.
+    static constexpr int DEFAULT_UNDO_LEVELS = 100;
+    static constexpr size_t DEFAULT_UNDO_MEMORY = 32 * 1024 * 1024;
+    bool undo();
+    bool redo();
+    void setUndoLimits(int maxLevels, size_t maxBytes);
+    void clearHistory();
+
+    // Set a sequence's loop region; an empty region (end <= start) loops the
+    // whole sequence, from beat 0 to the end of its last note rounded up to a beat
+    bool setLoopRegion(int sequenceId, double startBeat, double endBeat);
+
     // Playback control
-    bool startPlayback(int sequenceId);
+    bool startPlayback(int sequenceId, bool loop = false);
     bool stopPlayback();
 
+    // Move the playhead. On the playing sequence every event cursor is re-found
+    // with a binary search and the notes spanning the new position are started
+    // at once (chased), found through the track's note index; with
+    // offsetIntoNotes they start as far in as playback would have got. On any
+    // other sequence this cues where its next playback starts.
+    bool setPlaybackPosition(int sequenceId, double beat, bool offsetIntoNotes = true);
+    double getPlaybackPosition(int sequenceId);
+
+    // Engine events (positions, loop wraps, load progress) go here; may be null
+    void setEventPublisher(EventPublisher* events) { m_events = events; }
+
+    // Lock-free view of the transport as of the last rendered block, for the
+    // audio clock: false while stopped, when beat holds the last position
+    bool getAudiblePosition(double& beat, double& beatsPerSecond, int& sequenceId) const;
+
+    // Lookahead scheduling. A scheduler thread runs the transport up to
+    // lookaheadBlocks audio blocks ahead of the audio clock, walking tracks
+    // and tempo maps under m_mutex, and queues timestamped events; the render
+    // thread only applies those that are due. More blocks ride out scheduler
+    // stalls at the cost of edits taking longer to be heard.
+    static constexpr int DEFAULT_LOOKAHEAD_BLOCKS = 2;
+    static constexpr int MAX_LOOKAHEAD_BLOCKS = 16;
+    bool setLookahead(int blocks);
+
+    // Called on the audio thread before the instruments render: hands the
+    // instruments the queued events due in the next numFrames frames, each
+    // delayed to its own frame, and advances the audio clock. Takes no lock
+    // of this class.
+    void renderEvents(int numFrames, int sampleRate);
+
+    // Advance the transport by numFrames frames past what is already
+    // scheduled, queueing the note events and automation ramps due in them.
+    // Called by the scheduler thread.
+    void scheduleBlock(int numFrames, int sampleRate);
+
 private:
     // Member variables
     InstrumentManager* m_instrumentManager;
+    EventPublisher* m_events = nullptr;
     std::map<int, Sequence> m_sequences;
     int m_nextSequenceId;
     int m_nextTrackId;
     int m_nextNoteId;
+    int m_ticksPerBeat = DEFAULT_TICKS_PER_BEAT;
     int m_activeSequenceId;
+    double m_currentPositionInBeats;
     std::atomic<bool> m_isPlaying;
     std::mutex m_mutex;
+    
+    // Loop region of the playing sequence, resolved from its settings
+    bool m_looping = false;
+    double m_loopStart = 0.0;
+    double m_loopEnd = 0.0;
+
+    // Scheduler thread and the audio clock it runs ahead of. Start, stop and
+    // seek bump the generation: the render thread then drops the note ons
+    // and ramps queued before it and applies its note offs straight away.
+    static constexpr size_t EVENT_QUEUE_CAPACITY = 8192;
+    SpscQueue<ScheduledEvent> m_eventQueue{EVENT_QUEUE_CAPACITY};  // Pushed under m_mutex
+    std::atomic<int64_t> m_audioFrame{0};      // Frames rendered so far
+    std::atomic<int64_t> m_scheduledFrame{0};  // Frame the transport is scheduled up to
+    std::atomic<uint32_t> m_generation{0};
+    std::atomic<double> m_audiblePosition{0.0};  // Transport beat at the last rendered block's start
+    std::atomic<double> m_audibleTempo{0.0};     // Beats per second there
+    std::atomic<int> m_audibleSequenceId{-1};
+    std::atomic<int> m_renderSampleRate{0};
+    std::atomic<int> m_renderBlockFrames{0};
+    std::atomic<int> m_lookaheadBlocks{DEFAULT_LOOKAHEAD_BLOCKS};
+    std::atomic<bool> m_schedulerRunning{false};
+    std::thread m_schedulerThread;
+    std::mutex m_schedulerMutex;
+    std::condition_variable m_schedulerWakeup;
+    size_t m_droppedEvents = 0;
+
+    // Background MIDI file exports; finished jobs are joined on the next export
+    struct ExportJob {
+        std::thread thread;
+        std::atomic<bool> finished{false};
+    };
+    std::list<std::unique_ptr<ExportJob>> m_exportJobs;
+    std::mutex m_exportMutex;
+    int m_nextExportId = 1;
+
+    // Undo history: each entry holds the state of the sequences an edit
+    // touched from before the edit (undo) or before the undo (redo)
+    struct TrackSnapshot {
+        int id;
+        int instrumentId;
+        float volume;
+        float pan;
+        NoteList notes;
+        std::shared_ptr<AutomationLane::Points> automation;
+    };
+    struct SequenceSnapshot {
+        int sequenceId;
+        TempoMap tempoMap;
+        std::vector<TrackSnapshot> tracks;
+    };
+    struct HistoryEntry {
+        std::vector<SequenceSnapshot> sequences;
+        size_t bytes = 0;  // Approximate memory not shared with the next version
+    };
+    std::deque<HistoryEntry> m_undoStack;
+    std::deque<HistoryEntry> m_redoStack;
+    int m_maxUndoLevels = DEFAULT_UNDO_LEVELS;
+    size_t m_maxUndoBytes = DEFAULT_UNDO_MEMORY;
+    size_t m_historyBytes = 0;
+
+    // History helpers (caller holds m_mutex)
+    void recordUndo(const std::vector<int>& sequenceIds);
+    void recordUndo(int sequenceId) { recordUndo(std::vector<int>{sequenceId}); }
+    HistoryEntry snapshotSequences(const std::vector<int>& sequenceIds) const;
+    void restoreSequence(const SequenceSnapshot& snapshot);
+    bool stepHistory(std::deque<HistoryEntry>& from, std::deque<HistoryEntry>& to);
+    void trimHistory();
+    void forgetSequenceHistory(int sequenceId);
+    static size_t snapshotBytes(const HistoryEntry& entry, const HistoryEntry* next);
+
+    void reportLoadProgress(uint8_t kind, int id, float fraction);
+    void runScheduler();
+    void stopScheduler();
+
+    // Frame at which the pass being scheduled reaches a point in time
+    struct EventClock {
+        int64_t frame;   // Audio frame the pass starts at
+        double seconds;  // Sequence time at that frame
+        int sampleRate;
+    };
+
+    // Helpers (caller holds m_mutex)
+    bool stopPlaybackLocked();
+    void resolveLoopRegion(Sequence& sequence);
+    void restartTransport();
+    void queueEvent(const ScheduledEvent& event);
+    void fireEvents(Track& track, const Sequence& sequence, double endTick, const EventClock& clock);
+    void releaseSounding(Track& track, int64_t frame);
+    void releaseEditedNote(Track& track, const Sequence& sequence, const Note& note);
+    void chaseTo(Sequence& sequence, double beat, bool offsetIntoNotes);
+    Track* indexedTrack(std::unique_lock<std::mutex>& lock, int sequenceId, int trackId);
+    static bool eventBefore(const NoteEvent& a, const NoteEvent& b);
+    static void appendEvents(std::vector<NoteEvent>& events, const Note& note);
+    static void insertEvent(Track& track, const NoteEvent& event);
+    static void rebuildEvents(Track& track, double positionTick = 0.0);
+    static void mergeEvents(Track& track, std::vector<NoteEvent>& added);
+    static void recompileNotes(Track& track, std::vector<int>& noteIds);
+    static void removeEvents(Track& track, const std::vector<int>& noteIds);
 
     // Process active notes
     void processActiveNotes();
@@ -0,0 +1,79 @@
+#ifndef SPSC_QUEUE_H
+#define SPSC_QUEUE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Bounded wait-free queue between one producer and one consumer thread, used
+// to hand work to the audio thread without locks. Capacity is rounded up to a
+// power of two. Several producers may share it if they serialize their pushes
+// with a mutex of their own; the consumer side must stay on one thread.
+template <typename T>
+class SpscQueue {
+public:
+    explicit SpscQueue(size_t capacity) {
+        size_t size = 1;
+        while (size < capacity) {
+            size <<= 1;
+        }
+        m_slots.resize(size);
+        m_mask = size - 1;
+    }
+
+    SpscQueue(const SpscQueue&) = delete;
+    SpscQueue& operator=(const SpscQueue&) = delete;
+
+    // Producer side; false if the queue is full
+    bool push(const T& item) {
+        size_t write = m_write.load(std::memory_order_relaxed);
+        if (write - m_readCache > m_mask) {
+            m_readCache = m_read.load(std::memory_order_acquire);
+            if (write - m_readCache > m_mask) {
+                return false;
+            }
+        }
+        m_slots[write & m_mask] = item;
+        m_write.store(write + 1, std::memory_order_release);
+        return true;
+    }
+
+    // Producer side; a lower bound, as the consumer may free more meanwhile
+    size_t freeSpace() const {
+        return m_slots.size() - (m_write.load(std::memory_order_relaxed) - m_read.load(std::memory_order_acquire));
+    }
+
+    // Consumer side: the oldest item, or null if the queue is empty. It stays
+    // queued until pop().
+    const T* front() {
+        size_t read = m_read.load(std::memory_order_relaxed);
+        if (read == m_writeCache) {
+            m_writeCache = m_write.load(std::memory_order_acquire);
+            if (read == m_writeCache) {
+                return nullptr;
+            }
+        }
+        return &m_slots[read & m_mask];
+    }
+
+    // Consumer side; only after front() returned an item
+    void pop() {
+        m_read.store(m_read.load(std::memory_order_relaxed) + 1, std::memory_order_release);
+    }
+
+    size_t capacity() const { return m_slots.size(); }
+
+private:
+    std::vector<T> m_slots;
+    size_t m_mask = 0;
+
+    // Each index sits on its own cache line next to the other side's cached
+    // copy of it, so the threads don't contend on every operation
+    alignas(64) std::atomic<size_t> m_write{0};
+    size_t m_readCache = 0;  // Producer's last view of m_read
+    alignas(64) std::atomic<size_t> m_read{0};
+    size_t m_writeCache = 0;  // Consumer's last view of m_write
+};
+
+#endif // SPSC_QUEUE_H
@@ -0,0 +1,141 @@
+#include "tempo_map.h"
+#include <algorithm>
+#include <cmath>
+
+TempoMap::TempoMap(double bpm, int numerator, int denominator) {
+    m_tempos.push_back({0.0, validTempo(bpm) ? bpm : 120.0, false});
+    if (validTimeSignature(numerator, denominator)) {
+        m_timeSignatures.push_back({0.0, numerator, denominator});
+    } else {
+        m_timeSignatures.push_back({0.0, 4, 4});
+    }
+    rebuild();
+}
+
+bool TempoMap::validTempo(double bpm) {
+    return std::isfinite(bpm) && bpm >= MIN_BPM && bpm <= MAX_BPM;
+}
+
+bool TempoMap::validTimeSignature(int numerator, int denominator) {
+    // Denominators are powers of two, as in Standard MIDI Files
+    return numerator >= 1 && numerator <= 255 && denominator >= 1 && denominator <= 64 &&
+           (denominator & (denominator - 1)) == 0;
+}
+
+bool TempoMap::setTempo(double beat, double bpm, bool ramp) {
+    if (!std::isfinite(beat) || beat < 0.0 || !validTempo(bpm)) {
+        return false;
+    }
+    auto it = std::lower_bound(m_tempos.begin(), m_tempos.end(), beat,
+                               [](const TempoEvent& event, double b) { return event.beat < b; });
+    if (it != m_tempos.end() && it->beat == beat) {
+        it->bpm = bpm;
+        it->ramp = ramp;
+    } else {
+        m_tempos.insert(it, {beat, bpm, ramp});
+    }
+    rebuild();
+    return true;
+}
+
+bool TempoMap::removeTempo(double beat) {
+    auto it = std::lower_bound(m_tempos.begin(), m_tempos.end(), beat,
+                               [](const TempoEvent& event, double b) { return event.beat < b; });
+    if (it == m_tempos.begin() || it == m_tempos.end() || it->beat != beat) {
+        return false;
+    }
+    m_tempos.erase(it);
+    rebuild();
+    return true;
+}
+
+bool TempoMap::setTimeSignature(double beat, int numerator, int denominator) {
+    if (!std::isfinite(beat) || beat < 0.0 || !validTimeSignature(numerator, denominator)) {
+        return false;
+    }
+    auto it = std::lower_bound(m_timeSignatures.begin(), m_timeSignatures.end(), beat,
+                               [](const TimeSignatureEvent& event, double b) { return event.beat < b; });
+    if (it != m_timeSignatures.end() && it->beat == beat) {
+        it->numerator = numerator;
+        it->denominator = denominator;
+    } else {
+        m_timeSignatures.insert(it, {beat, numerator, denominator});
+    }
+    return true;
+}
+
+bool TempoMap::removeTimeSignature(double beat) {
+    auto it = std::lower_bound(m_timeSignatures.begin(), m_timeSignatures.end(), beat,
+                               [](const TimeSignatureEvent& event, double b) { return event.beat < b; });
+    if (it == m_timeSignatures.begin() || it == m_timeSignatures.end() || it->beat != beat) {
+        return false;
+    }
+    m_timeSignatures.erase(it);
+    return true;
+}
+
+// Integrate 60 / bpm over each segment; a linear ramp bpm(b) = bpm0 + k * b
+// takes 60 / k * ln(bpm(b) / bpm0) seconds
+void TempoMap::rebuild() {
+    size_t count = m_tempos.size();
+    m_startSeconds.assign(count, 0.0);
+    m_slopes.assign(count, 0.0);
+    for (size_t i = 0; i + 1 < count; i++) {
+        const TempoEvent& from = m_tempos[i];
+        const TempoEvent& to = m_tempos[i + 1];
+        double length = to.beat - from.beat;
+        double seconds;
+        if (from.ramp && to.bpm != from.bpm) {
+            m_slopes[i] = (to.bpm - from.bpm) / length;
+            seconds = 60.0 / m_slopes[i] * std::log(to.bpm / from.bpm);
+        } else {
+            seconds = 60.0 * length / from.bpm;
+        }
+        m_startSeconds[i + 1] = m_startSeconds[i] + seconds;
+    }
+}
+
+size_t TempoMap::segmentAtBeat(double beat) const {
+    auto it = std::upper_bound(m_tempos.begin(), m_tempos.end(), beat,
+                               [](double b, const TempoEvent& event) { return b < event.beat; });
+    return it == m_tempos.begin() ? 0 : static_cast<size_t>(it - m_tempos.begin()) - 1;
+}
+
+size_t TempoMap::segmentAtSeconds(double seconds) const {
+    auto it = std::upper_bound(m_startSeconds.begin(), m_startSeconds.end(), seconds);
+    return it == m_startSeconds.begin() ? 0 : static_cast<size_t>(it - m_startSeconds.begin()) - 1;
+}
+
+double TempoMap::tempoAt(double beat) const {
+    size_t segment = segmentAtBeat(beat);
+    const TempoEvent& event = m_tempos[segment];
+    return event.bpm + m_slopes[segment] * std::max(0.0, beat - event.beat);
+}
+
+double TempoMap::secondsAt(double beat) const {
+    size_t segment = segmentAtBeat(beat);
+    const TempoEvent& event = m_tempos[segment];
+    double offset = beat - event.beat;
+    double slope = m_slopes[segment];
+    if (slope == 0.0 || offset <= 0.0) {
+        return m_startSeconds[segment] + 60.0 * offset / event.bpm;
+    }
+    return m_startSeconds[segment] + 60.0 / slope * std::log((event.bpm + slope * offset) / event.bpm);
+}
+
+double TempoMap::beatAt(double seconds) const {
+    size_t segment = segmentAtSeconds(seconds);
+    const TempoEvent& event = m_tempos[segment];
+    double offset = seconds - m_startSeconds[segment];
+    double slope = m_slopes[segment];
+    if (slope == 0.0 || offset <= 0.0) {
+        return event.beat + offset * event.bpm / 60.0;
+    }
+    return event.beat + event.bpm * std::expm1(slope * offset / 60.0) / slope;
+}
+
+const TimeSignatureEvent& TempoMap::timeSignatureAt(double beat) const {
+    auto it = std::upper_bound(m_timeSignatures.begin(), m_timeSignatures.end(), beat,
+                               [](double b, const TimeSignatureEvent& event) { return b < event.beat; });
+    return it == m_timeSignatures.begin() ? m_timeSignatures.front() : *(it - 1);
+}
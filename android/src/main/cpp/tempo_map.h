@@ -0,0 +1,66 @@
+#ifndef TEMPO_MAP_H
+#define TEMPO_MAP_H
+
+#include <cstddef>
+#include <vector>
+
+// Tempo change; with ramp set the tempo moves linearly (in BPM per beat) to
+// the next change's tempo, otherwise it steps there
+struct TempoEvent {
+    double beat;
+    double bpm;
+    bool ramp;
+};
+
+struct TimeSignatureEvent {
+    double beat;
+    int numerator;
+    int denominator;
+};
+
+// Tempo and time signature changes of a sequence.
+//
+// Every edit recomputes the time at which each tempo segment starts, so
+// converting between beats and seconds is a binary search plus a closed form
+// within the segment: O(log n) in the number of changes, with no error that
+// accumulates along the song. Multiply seconds by the sample rate for frames.
+// There is always a tempo change and a time signature at beat 0.
+class TempoMap {
+public:
+    static constexpr double MIN_BPM = 1.0;
+    static constexpr double MAX_BPM = 999.0;
+
+    explicit TempoMap(double bpm = 120.0, int numerator = 4, int denominator = 4);
+
+    // Add a change, replacing any at the same beat; O(n)
+    bool setTempo(double beat, double bpm, bool ramp = false);
+    bool setTimeSignature(double beat, int numerator, int denominator);
+
+    // Remove the change at exactly beat; the one at beat 0 stays
+    bool removeTempo(double beat);
+    bool removeTimeSignature(double beat);
+
+    const std::vector<TempoEvent>& tempoEvents() const { return m_tempos; }
+    const std::vector<TimeSignatureEvent>& timeSignatures() const { return m_timeSignatures; }
+
+    // Lookups; beats before 0 continue at the initial tempo
+    double tempoAt(double beat) const;
+    double secondsAt(double beat) const;
+    double beatAt(double seconds) const;
+    const TimeSignatureEvent& timeSignatureAt(double beat) const;
+
+    static bool validTempo(double bpm);
+    static bool validTimeSignature(int numerator, int denominator);
+
+private:
+    void rebuild();
+    size_t segmentAtBeat(double beat) const;
+    size_t segmentAtSeconds(double seconds) const;
+
+    std::vector<TempoEvent> m_tempos;                  // Sorted by beat
+    std::vector<double> m_startSeconds;                // Per tempo change
+    std::vector<double> m_slopes;                      // BPM per beat; 0 unless ramping
+    std::vector<TimeSignatureEvent> m_timeSignatures;  // Sorted by beat
+};
+
+#endif // TEMPO_MAP_H
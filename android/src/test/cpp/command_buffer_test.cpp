@@ -0,0 +1,229 @@
+#include "command_buffer.h"
+#include <cstring>
+#include <string>
+#include <vector>
+#include "test_support.h"
+
+// Builds buffers the way CommandBuffer in the Dart FFI layer does: an opcode
+// byte, then the payload, little-endian
+class Encoder {
+public:
+    void setTrackVolume(int32_t sequenceId, int32_t trackId, float volume) {
+        begin(CommandType::SET_TRACK_VOLUME, 12);
+        put(sequenceId);
+        put(trackId);
+        put(volume);
+    }
+    void setTrackPan(int32_t sequenceId, int32_t trackId, float pan) {
+        begin(CommandType::SET_TRACK_PAN, 12);
+        put(sequenceId);
+        put(trackId);
+        put(pan);
+    }
+    void deleteNote(int32_t sequenceId, int32_t trackId, int32_t noteId) {
+        begin(CommandType::DELETE_NOTE, 12);
+        put(sequenceId);
+        put(trackId);
+        put(noteId);
+    }
+    void moveNote(int32_t sequenceId, int32_t trackId, int32_t noteId, double startBeat, double durationBeats) {
+        begin(CommandType::MOVE_NOTE, 28);
+        put(sequenceId);
+        put(trackId);
+        put(noteId);
+        put(startBeat);
+        put(durationBeats);
+    }
+    void transposeNote(int32_t sequenceId, int32_t trackId, int32_t noteId, int32_t semitones) {
+        begin(CommandType::TRANSPOSE_NOTE, 16);
+        put(sequenceId);
+        put(trackId);
+        put(noteId);
+        put(semitones);
+    }
+    void setNoteVelocity(int32_t sequenceId, int32_t trackId, int32_t noteId, int32_t velocity) {
+        begin(CommandType::SET_NOTE_VELOCITY, 16);
+        put(sequenceId);
+        put(trackId);
+        put(noteId);
+        put(velocity);
+    }
+    void setTempo(int32_t sequenceId, double bpm) {
+        begin(CommandType::SET_TEMPO, 12);
+        put(sequenceId);
+        put(bpm);
+    }
+
+    const std::vector<uint8_t>& bytes() const { return m_bytes; }
+
+    // Each command's size must match the payload size the Dart encoder reserves
+    bool sizesMatch() const { return m_bytes.size() == m_expected; }
+
+private:
+    void begin(CommandType type, size_t payloadSize) {
+        m_bytes.push_back(static_cast<uint8_t>(type));
+        m_expected = m_bytes.size() + payloadSize;
+    }
+
+    template <typename T>
+    void put(T value) {
+        uint8_t raw[sizeof(T)];
+        std::memcpy(raw, &value, sizeof(T));
+        m_bytes.insert(m_bytes.end(), raw, raw + sizeof(T));
+    }
+
+    std::vector<uint8_t> m_bytes;
+    size_t m_expected = 0;
+};
+
+static bool decode(const std::vector<uint8_t>& bytes, size_t length, std::vector<EditCommand>& commands,
+                   std::string& error) {
+    commands.clear();
+    error.clear();
+    return decodeCommands(bytes.data(), length, commands, error);
+}
+
+static void eachCommand() {
+    std::vector<EditCommand> commands;
+    std::string error;
+
+    struct Case {
+        const char* name;
+        size_t size;  // Opcode plus payload
+        void (*encode)(Encoder&);
+        void (*check)(const EditCommand&);
+    };
+    const Case cases[] = {
+        {"SET_TRACK_VOLUME", 13, [](Encoder& e) { e.setTrackVolume(3, 4, 0.75f); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::SET_TRACK_VOLUME);
+             CHECK(c.sequenceId == 3 && c.trackId == 4 && c.floatValue == 0.75f);
+         }},
+        {"SET_TRACK_PAN", 13, [](Encoder& e) { e.setTrackPan(3, 4, -0.5f); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::SET_TRACK_PAN);
+             CHECK(c.sequenceId == 3 && c.trackId == 4 && c.floatValue == -0.5f);
+         }},
+        {"DELETE_NOTE", 13, [](Encoder& e) { e.deleteNote(3, 4, 123456); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::DELETE_NOTE);
+             CHECK(c.sequenceId == 3 && c.trackId == 4 && c.noteId == 123456);
+         }},
+        {"MOVE_NOTE", 29, [](Encoder& e) { e.moveNote(3, 4, 5, 12.375, 0.1); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::MOVE_NOTE);
+             CHECK(c.sequenceId == 3 && c.trackId == 4 && c.noteId == 5);
+             CHECK(c.startBeat == 12.375 && c.durationBeats == 0.1);
+         }},
+        {"TRANSPOSE_NOTE", 17, [](Encoder& e) { e.transposeNote(3, 4, 5, -12); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::TRANSPOSE_NOTE);
+             CHECK(c.sequenceId == 3 && c.trackId == 4 && c.noteId == 5 && c.intValue == -12);
+         }},
+        {"SET_NOTE_VELOCITY", 17, [](Encoder& e) { e.setNoteVelocity(3, 4, 5, 99); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::SET_NOTE_VELOCITY);
+             CHECK(c.sequenceId == 3 && c.trackId == 4 && c.noteId == 5 && c.intValue == 99);
+         }},
+        {"SET_TEMPO", 13, [](Encoder& e) { e.setTempo(3, 97.25); },
+         [](const EditCommand& c) {
+             CHECK(c.type == CommandType::SET_TEMPO);
+             CHECK(c.sequenceId == 3 && c.bpm == 97.25);
+         }},
+    };
+
+    for (const Case& testCase : cases) {
+        Encoder encoder;
+        testCase.encode(encoder);
+        CHECK(encoder.sizesMatch());
+        CHECK(encoder.bytes().size() == testCase.size);
+        CHECK(decode(encoder.bytes(), encoder.bytes().size(), commands, error));
+        CHECK(error.empty());
+        CHECK(commands.size() == 1);
+        if (commands.size() == 1) {
+            testCase.check(commands[0]);
+        } else {
+            std::fprintf(stderr, "  %s decoded to %zu commands\n", testCase.name, commands.size());
+        }
+
+        // One byte short of the command
+        CHECK(!decode(encoder.bytes(), encoder.bytes().size() - 1, commands, error));
+        CHECK(error.find("Truncated") == 0);
+    }
+}
+
+static Encoder mixedBatch() {
+    Encoder encoder;
+    encoder.setTrackVolume(1, 2, 0.5f);
+    encoder.moveNote(1, 2, 3, 4.0, 1.0);
+    encoder.setTempo(1, 140.0);
+    encoder.transposeNote(1, 2, 3, 7);
+    encoder.deleteNote(1, 2, 3);
+    return encoder;
+}
+
+static void batchInOrder() {
+    Encoder encoder = mixedBatch();
+    std::vector<EditCommand> commands;
+    std::string error;
+    CHECK(decode(encoder.bytes(), encoder.bytes().size(), commands, error));
+    CHECK(commands.size() == 5);
+    if (commands.size() == 5) {
+        CHECK(commands[0].type == CommandType::SET_TRACK_VOLUME);
+        CHECK(commands[1].type == CommandType::MOVE_NOTE && commands[1].startBeat == 4.0);
+        CHECK(commands[2].type == CommandType::SET_TEMPO && commands[2].bpm == 140.0);
+        CHECK(commands[3].type == CommandType::TRANSPOSE_NOTE && commands[3].intValue == 7);
+        CHECK(commands[4].type == CommandType::DELETE_NOTE);
+    }
+
+    // An empty buffer is an empty batch, even without a pointer
+    CHECK(decode(encoder.bytes(), 0, commands, error));
+    CHECK(commands.empty());
+    commands.clear();
+    CHECK(decodeCommands(nullptr, 0, commands, error));
+    CHECK(commands.empty());
+    CHECK(!decodeCommands(nullptr, 4, commands, error));
+}
+
+static void truncatedBuffer() {
+    // Every cut inside a command is rejected; cuts on command boundaries
+    // decode the commands before them
+    Encoder encoder = mixedBatch();
+    const size_t boundaries[] = {0, 13, 42, 55, 72, 85};
+    std::vector<EditCommand> commands;
+    std::string error;
+    size_t next = 0;
+    for (size_t length = 0; length <= encoder.bytes().size(); length++) {
+        bool boundary = length == boundaries[next];
+        bool ok = decode(encoder.bytes(), length, commands, error);
+        CHECK(ok == boundary);
+        if (boundary) {
+            CHECK(commands.size() == next);
+            next++;
+        } else {
+            CHECK(error == "Truncated command " + std::to_string(commands.size()));
+        }
+    }
+    CHECK(next == 6);
+}
+
+static void unknownOpcode() {
+    std::vector<EditCommand> commands;
+    std::string error;
+    for (uint8_t opcode : {uint8_t(0), uint8_t(8), uint8_t(0x7F), uint8_t(0xFF)}) {
+        Encoder encoder = mixedBatch();
+        std::vector<uint8_t> bytes = encoder.bytes();
+        // Replace the third command's opcode, keeping its payload
+        bytes[42] = opcode;
+        CHECK(!decode(bytes, bytes.size(), commands, error));
+        CHECK(error == "Unknown command opcode " + std::to_string(opcode) + " at command 2");
+    }
+}
+
+int main() {
+    RUN_TEST(eachCommand);
+    RUN_TEST(batchInOrder);
+    RUN_TEST(truncatedBuffer);
+    RUN_TEST(unknownOpcode);
+    return testResult();
+}
@@ -0,0 +1,279 @@
+#include "midi_file.h"
+#include <cstdio>
+#include <string>
+#include <vector>
+#include "test_support.h"
+
+static constexpr double TOLERANCE = 1e-9;
+
+using Bytes = std::vector<uint8_t>;
+
+// Test files live in the working directory (the build tree under CTest)
+static std::string testPath(const char* name) {
+    return std::string("midi_file_test_") + name + ".mid";
+}
+
+static void writeBytes(const std::string& path, const Bytes& bytes) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file) {
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    }
+}
+
+static Bytes chunk(const char* type, const Bytes& body) {
+    Bytes bytes(type, type + 4);
+    uint32_t length = static_cast<uint32_t>(body.size());
+    bytes.insert(bytes.end(), {static_cast<uint8_t>(length >> 24), static_cast<uint8_t>(length >> 16),
+                               static_cast<uint8_t>(length >> 8), static_cast<uint8_t>(length)});
+    bytes.insert(bytes.end(), body.begin(), body.end());
+    return bytes;
+}
+
+static Bytes header(uint16_t format, uint16_t tracks, uint16_t division) {
+    return chunk("MThd", {static_cast<uint8_t>(format >> 8), static_cast<uint8_t>(format),
+                          static_cast<uint8_t>(tracks >> 8), static_cast<uint8_t>(tracks),
+                          static_cast<uint8_t>(division >> 8), static_cast<uint8_t>(division)});
+}
+
+static Bytes concat(std::initializer_list<Bytes> parts) {
+    Bytes bytes;
+    for (const Bytes& part : parts) {
+        bytes.insert(bytes.end(), part.begin(), part.end());
+    }
+    return bytes;
+}
+
+static void checkSameData(const MidiFileData& actual, const MidiFileData& expected) {
+    CHECK(actual.ticksPerBeat == expected.ticksPerBeat);
+    CHECK(actual.tempos.size() == expected.tempos.size());
+    for (size_t i = 0; i < std::min(actual.tempos.size(), expected.tempos.size()); i++) {
+        CHECK_NEAR(actual.tempos[i].beat, expected.tempos[i].beat, TOLERANCE);
+        CHECK_NEAR(actual.tempos[i].bpm, expected.tempos[i].bpm, 1e-3);
+    }
+    CHECK(actual.timeSignatures.size() == expected.timeSignatures.size());
+    for (size_t i = 0; i < std::min(actual.timeSignatures.size(), expected.timeSignatures.size()); i++) {
+        CHECK_NEAR(actual.timeSignatures[i].beat, expected.timeSignatures[i].beat, TOLERANCE);
+        CHECK(actual.timeSignatures[i].numerator == expected.timeSignatures[i].numerator);
+        CHECK(actual.timeSignatures[i].denominator == expected.timeSignatures[i].denominator);
+    }
+    CHECK(actual.tracks.size() == expected.tracks.size());
+    for (size_t t = 0; t < std::min(actual.tracks.size(), expected.tracks.size()); t++) {
+        const MidiFileTrack& a = actual.tracks[t];
+        const MidiFileTrack& e = expected.tracks[t];
+        CHECK(a.name == e.name);
+        CHECK(a.channel == e.channel);
+        CHECK(a.notes.size() == e.notes.size());
+        for (size_t n = 0; n < std::min(a.notes.size(), e.notes.size()); n++) {
+            CHECK_NEAR(a.notes[n].startBeat, e.notes[n].startBeat, TOLERANCE);
+            CHECK_NEAR(a.notes[n].durationBeats, e.notes[n].durationBeats, TOLERANCE);
+            CHECK(a.notes[n].noteNumber == e.notes[n].noteNumber);
+            CHECK(a.notes[n].velocity == e.notes[n].velocity);
+        }
+    }
+}
+
+static void roundTrip() {
+    MidiFileData data;
+    data.ticksPerBeat = 960;
+    data.tempos = {{0.0, 120.0}, {8.0, 90.0}, {16.5, 150.0}};
+    data.timeSignatures = {{0.0, 4, 4}, {8.0, 7, 8}};
+
+    MidiFileTrack lead;
+    lead.name = "Lead";
+    lead.channel = 0;
+    // Notes come back in note-off order, so keep these in that order
+    lead.notes = {{0.0, 1.0, 60, 100}, {1.0, 0.5, 62, 90}, {1.0, 1.0, 64, 80}, {4.25, 0.125, 127, 1}};
+    MidiFileTrack bass;
+    bass.name = "Bass";
+    bass.channel = 9;
+    // A retrigger on the tick the previous note ends, and overlapping same-key notes
+    bass.notes = {{0.0, 2.0, 36, 127}, {2.0, 2.0, 36, 64}, {10.0, 3.0, 40, 70}, {11.0, 3.0, 40, 71}};
+    data.tracks = {lead, bass};
+
+    std::string first = testPath("round_trip");
+    std::string second = testPath("round_trip_again");
+    MidiFileWriter writer;
+    CHECK(writer.write(first, data));
+    CHECK(writer.getError().empty());
+
+    MidiFileReader reader;
+    MidiFileData read;
+    CHECK(reader.read(first, read));
+    CHECK(reader.getError().empty());
+    CHECK(read.format == 1);
+    checkSameData(read, data);
+
+    // Writing what was read gives the same data back again
+    CHECK(writer.write(second, read));
+    MidiFileData reread;
+    CHECK(reader.read(second, reread));
+    checkSameData(reread, data);
+
+    std::remove(first.c_str());
+    std::remove(second.c_str());
+}
+
+static void runningStatus() {
+    // Division 96: note on, then note ons under running status (velocity 0
+    // as note off), a note off message, then a meta event, which cancels
+    // running status
+    Bytes track = {
+        0x00, 0x91, 0x3C, 0x64,  // Channel 2 note on C4
+        0x30, 0x40, 0x50,        // Running status: note on E4
+        0x30, 0x3C, 0x00,        // Running status: C4 off at tick 96
+        0x18, 0x40, 0x00,        // E4 off at tick 120
+        0x00, 0x81, 0x3E, 0x40,  // Stray note off, ignored
+        0x00, 0x43, 0xC0,        // Running status (now note off) on a key that isn't held
+        0x00, 0x91, 0x43, 0xFF,  // Velocity byte with the top bit set is masked to 7 bits
+        0x60, 0x43, 0x00,
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    std::string path = testPath("running_status");
+    writeBytes(path, concat({header(0, 1, 96), chunk("MTrk", track)}));
+
+    MidiFileReader reader;
+    MidiFileData data;
+    CHECK(reader.read(path, data));
+    CHECK(data.ticksPerBeat == 96);
+    CHECK(data.tracks.size() == 1);
+    if (data.tracks.size() == 1) {
+        const MidiFileTrack& notes = data.tracks[0];
+        CHECK(notes.channel == 1);
+        CHECK(notes.notes.size() == 3);
+        if (notes.notes.size() == 3) {
+            CHECK(notes.notes[0].noteNumber == 0x3C && notes.notes[0].velocity == 0x64);
+            CHECK_NEAR(notes.notes[0].startBeat, 0.0, TOLERANCE);
+            CHECK_NEAR(notes.notes[0].durationBeats, 1.0, TOLERANCE);
+            CHECK(notes.notes[1].noteNumber == 0x40 && notes.notes[1].velocity == 0x50);
+            CHECK_NEAR(notes.notes[1].startBeat, 0.5, TOLERANCE);
+            CHECK_NEAR(notes.notes[1].durationBeats, 0.75, TOLERANCE);
+            CHECK(notes.notes[2].noteNumber == 0x43 && notes.notes[2].velocity == 0x7F);
+            CHECK_NEAR(notes.notes[2].durationBeats, 1.0, TOLERANCE);
+        }
+    }
+
+    // A data byte straight after a meta event has no status to run on
+    Bytes cancelled = {
+        0x00, 0x90, 0x3C, 0x64,
+        0x00, 0xFF, 0x01, 0x00,  // Empty text event
+        0x10, 0x3C, 0x00,
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    writeBytes(path, concat({header(0, 1, 96), chunk("MTrk", cancelled)}));
+    CHECK(!reader.read(path, data));
+    CHECK(!reader.getError().empty());
+
+    std::remove(path.c_str());
+}
+
+static void truncatedChunk() {
+    Bytes track = {
+        0x00, 0x90, 0x3C, 0x64,
+        0x60, 0x3C, 0x00,
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    Bytes file = concat({header(0, 1, 480), chunk("MTrk", track)});
+    std::string path = testPath("truncated");
+    MidiFileReader reader;
+    MidiFileData data;
+
+    // Cut inside the track body, inside the chunk header and inside MThd
+    for (size_t cut : {file.size() - 3, static_cast<size_t>(14 + 6), static_cast<size_t>(10)}) {
+        writeBytes(path, Bytes(file.begin(), file.begin() + cut));
+        CHECK(!reader.read(path, data));
+        CHECK(!reader.getError().empty());
+    }
+
+    // A chunk that claims more bytes than the file holds
+    Bytes overlong = file;
+    overlong[14 + 7] = 0x40;
+    writeBytes(path, overlong);
+    CHECK(!reader.read(path, data));
+
+    // The same reader recovers once given a whole file
+    writeBytes(path, file);
+    CHECK(reader.read(path, data));
+    CHECK(reader.getError().empty());
+    CHECK(data.tracks.size() == 1 && data.tracks[0].notes.size() == 1);
+
+    // Not a MIDI file at all, and a missing file
+    writeBytes(path, {'R', 'I', 'F', 'F', 0, 0, 0, 0, 0, 0, 0, 0, 0, 0});
+    CHECK(!reader.read(path, data));
+    CHECK(!reader.read(testPath("missing"), data));
+
+    std::remove(path.c_str());
+}
+
+static void tempoMetaEvents() {
+    // PPQ 480: 120 BPM at 0, 60 BPM at beat 2, 3/4 at beat 4, with the tempo
+    // map split across two tracks as type 1 files allow
+    Bytes conductor = {
+        0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,        // 500000 us per beat
+        0x87, 0x40, 0xFF, 0x51, 0x03, 0x0F, 0x42, 0x40,  // 1000000 us per beat at tick 960
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    Bytes notes = {
+        0x00, 0xFF, 0x03, 0x04, 'K', 'e', 'y', 's',
+        0x00, 0x90, 0x3C, 0x64,
+        0x8F, 0x00, 0xFF, 0x58, 0x04, 0x03, 0x02, 0x18, 0x08,  // 3/4 at tick 1920
+        0x00, 0x80, 0x3C, 0x00,
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    std::string path = testPath("tempo");
+    writeBytes(path, concat({header(1, 2, 480), chunk("MTrk", conductor), chunk("MTrk", notes)}));
+
+    MidiFileReader reader;
+    MidiFileData data;
+    CHECK(reader.read(path, data));
+    CHECK(data.tempos.size() == 2);
+    if (data.tempos.size() == 2) {
+        CHECK_NEAR(data.tempos[0].beat, 0.0, TOLERANCE);
+        CHECK_NEAR(data.tempos[0].bpm, 120.0, TOLERANCE);
+        CHECK_NEAR(data.tempos[1].beat, 2.0, TOLERANCE);
+        CHECK_NEAR(data.tempos[1].bpm, 60.0, TOLERANCE);
+    }
+    CHECK(data.timeSignatures.size() == 1);
+    if (data.timeSignatures.size() == 1) {
+        CHECK_NEAR(data.timeSignatures[0].beat, 4.0, TOLERANCE);
+        CHECK(data.timeSignatures[0].numerator == 3 && data.timeSignatures[0].denominator == 4);
+    }
+    CHECK(data.tracks.size() == 1);
+    if (data.tracks.size() == 1) {
+        CHECK(data.tracks[0].name == "Keys");
+        CHECK(data.tracks[0].notes.size() == 1);
+        CHECK_NEAR(data.tracks[0].notes[0].durationBeats, 4.0, TOLERANCE);
+    }
+
+    // SMPTE timing (25 fps, 40 ticks per frame: 1000 ticks a second) maps
+    // ticks to beats through the tempo: 1 s at 120 BPM, then 1 s at 60 BPM
+    Bytes smpte = {
+        0x00, 0xFF, 0x51, 0x03, 0x07, 0xA1, 0x20,
+        0x00, 0x90, 0x3C, 0x64,
+        0x87, 0x68, 0xFF, 0x51, 0x03, 0x0F, 0x42, 0x40,  // Tick 1000
+        0x87, 0x68, 0x80, 0x3C, 0x00,                    // Tick 2000
+        0x00, 0xFF, 0x2F, 0x00,
+    };
+    writeBytes(path, concat({header(0, 1, 0xE728), chunk("MTrk", smpte)}));
+    CHECK(reader.read(path, data));
+    CHECK(data.ticksPerBeat == 0);
+    CHECK(data.tempos.size() == 2);
+    if (data.tempos.size() == 2) {
+        CHECK_NEAR(data.tempos[1].beat, 2.0, TOLERANCE);
+    }
+    CHECK(data.tracks.size() == 1 && data.tracks[0].notes.size() == 1);
+    if (data.tracks.size() == 1 && data.tracks[0].notes.size() == 1) {
+        CHECK_NEAR(data.tracks[0].notes[0].durationBeats, 3.0, TOLERANCE);
+    }
+
+    std::remove(path.c_str());
+}
+
+int main() {
+    RUN_TEST(roundTrip);
+    RUN_TEST(runningStatus);
+    RUN_TEST(truncatedChunk);
+    RUN_TEST(tempoMetaEvents);
+    return testResult();
+}
@@ -0,0 +1,144 @@
+#include "note_index.h"
+#include <algorithm>
+#include <random>
+#include <vector>
+#include "note_list.h"
+#include "test_support.h"
+
+static NoteList makeNotes(const std::vector<Note>& notes) {
+    NoteList list;
+    for (const Note& note : notes) {
+        list.push_back(note);
+    }
+    return list;
+}
+
+// IDs of the notes overlapping [startTick, endTick), in the order reported
+static std::vector<int32_t> queryIds(const NoteIndex& index, int32_t startTick, int32_t endTick) {
+    std::vector<int32_t> ids;
+    index.query(startTick, endTick, [&](const NoteIndex::Entry& entry) { ids.push_back(entry.noteId); });
+    return ids;
+}
+
+// Every note of the list overlapping the range, checked one by one
+static std::vector<int32_t> scanIds(const NoteList& notes, int32_t startTick, int32_t endTick) {
+    std::vector<int32_t> ids;
+    for (const Note& note : notes) {
+        if (note.startTick < endTick && note.startTick + note.durationTicks > startTick) {
+            ids.push_back(note.id);
+        }
+    }
+    return ids;
+}
+
+// The index reports exactly the scan's notes, in start order
+static void checkQuery(const NoteIndex& index, const NoteList& notes, int32_t startTick, int32_t endTick) {
+    std::vector<int32_t> found = queryIds(index, startTick, endTick);
+    std::vector<int32_t> expected = scanIds(notes, startTick, endTick);
+
+    std::vector<int32_t> starts;
+    for (int32_t id : found) {
+        starts.push_back(notes.find(id)->startTick);
+    }
+    CHECK(std::is_sorted(starts.begin(), starts.end()));
+
+    std::sort(found.begin(), found.end());
+    CHECK(found == expected);
+    if (found != expected) {
+        std::fprintf(stderr, "  range [%d, %d) over %zu notes: %zu found, %zu expected\n",
+                     startTick, endTick, notes.size(), found.size(), expected.size());
+    }
+}
+
+static void emptyIndex() {
+    NoteList notes;
+    NoteIndex index;
+    index.build(notes);
+    CHECK(index.size() == 0);
+    CHECK(queryIds(index, 0, 1000).empty());
+    CHECK(queryIds(index, -1000, 1000).empty());
+}
+
+static void singleNote() {
+    NoteList notes = makeNotes({{1, 100, 50, 60, 100}});
+    NoteIndex index;
+    index.build(notes);
+    CHECK(index.size() == 1);
+
+    // Ranges are half-open on both sides
+    CHECK(queryIds(index, 0, 100).empty());
+    CHECK(queryIds(index, 150, 200).empty());
+    CHECK(queryIds(index, 0, 101).size() == 1);
+    CHECK(queryIds(index, 149, 200).size() == 1);
+    CHECK(queryIds(index, 120, 130).size() == 1);
+    CHECK(queryIds(index, 120, 120).empty());
+    CHECK(queryIds(index, 130, 120).empty());
+
+    std::vector<NoteIndex::Entry> entries;
+    index.query(0, 1000, [&](const NoteIndex::Entry& entry) { entries.push_back(entry); });
+    CHECK(entries.size() == 1);
+    CHECK(entries[0].startTick == 100 && entries[0].endTick == 150);
+    CHECK(entries[0].noteNumber == 60 && entries[0].velocity == 100);
+}
+
+static void matchesScan() {
+    // Sizes either side of each power of two, where the implicit tree gains
+    // a level and the last subtree is only partly filled
+    std::mt19937 random(12345);
+    std::vector<int> sizes = {2, 3, 5, 7, 8, 9, 15, 16, 17, 31, 33, 63, 64, 65, 100, 127, 128, 129, 1000, 1023, 4097};
+    for (int size : sizes) {
+        std::uniform_int_distribution<int32_t> start(0, size * 40);
+        std::uniform_int_distribution<int32_t> shortLength(1, 60);
+        std::uniform_int_distribution<int32_t> longLength(1, size * 20);
+        std::uniform_int_distribution<int> kind(0, 9);
+
+        // Mostly short notes with a few long ones spanning many others, added
+        // in ID order but not start order
+        std::vector<Note> generated;
+        for (int i = 0; i < size; i++) {
+            int32_t length = kind(random) == 0 ? longLength(random) : shortLength(random);
+            generated.push_back({i + 1, start(random), length, static_cast<uint8_t>(i % 128), 100});
+        }
+        NoteList notes = makeNotes(generated);
+        NoteIndex index;
+        index.build(notes);
+        CHECK(index.size() == static_cast<size_t>(size));
+
+        int32_t end = size * 40 + size * 20 + 60;
+        std::uniform_int_distribution<int32_t> point(-100, end + 100);
+        for (int q = 0; q < 200; q++) {
+            int32_t a = point(random);
+            int32_t b = point(random);
+            checkQuery(index, notes, std::min(a, b), std::max(a, b) + 1);
+        }
+        checkQuery(index, notes, INT32_MIN, INT32_MAX);
+        checkQuery(index, notes, -100, 0);
+        checkQuery(index, notes, end + 1, end + 100);
+    }
+}
+
+static void sharedStartTicks() {
+    // Chords: many notes starting on the same tick with different lengths
+    std::vector<Note> generated;
+    int id = 1;
+    for (int32_t tick = 0; tick < 960 * 8; tick += 480) {
+        for (int voice = 0; voice < 6; voice++) {
+            generated.push_back({id++, tick, 120 * (voice + 1), static_cast<uint8_t>(60 + voice), 90});
+        }
+    }
+    NoteList notes = makeNotes(generated);
+    NoteIndex index;
+    index.build(notes);
+    for (int32_t tick = -10; tick < 960 * 9; tick += 37) {
+        checkQuery(index, notes, tick, tick + 1);
+        checkQuery(index, notes, tick, tick + 500);
+    }
+}
+
+int main() {
+    RUN_TEST(emptyIndex);
+    RUN_TEST(singleNote);
+    RUN_TEST(matchesScan);
+    RUN_TEST(sharedStartTicks);
+    return testResult();
+}
@@ -0,0 +1,292 @@
+#include "project_file.h"
+#include <cstddef>
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include "test_support.h"
+
+using namespace project;
+
+using Bytes = std::vector<uint8_t>;
+
+// Test files live in the working directory (the build tree under CTest)
+static std::string testPath(const char* name) {
+    return std::string("project_file_test_") + name + ".mtp";
+}
+
+static Bytes readBytes(const std::string& path) {
+    Bytes bytes;
+    FILE* file = std::fopen(path.c_str(), "rb");
+    CHECK(file != nullptr);
+    if (file) {
+        uint8_t buffer[4096];
+        size_t count;
+        while ((count = std::fread(buffer, 1, sizeof(buffer), file)) > 0) {
+            bytes.insert(bytes.end(), buffer, buffer + count);
+        }
+        std::fclose(file);
+    }
+    return bytes;
+}
+
+static void writeBytes(const std::string& path, const Bytes& bytes) {
+    FILE* file = std::fopen(path.c_str(), "wb");
+    CHECK(file != nullptr);
+    if (file) {
+        std::fwrite(bytes.data(), 1, bytes.size(), file);
+        std::fclose(file);
+    }
+}
+
+template <typename T>
+static T get(const Bytes& bytes, size_t offset) {
+    T value;
+    std::memcpy(&value, bytes.data() + offset, sizeof(T));
+    return value;
+}
+
+template <typename T>
+static void put(Bytes& bytes, size_t offset, T value) {
+    std::memcpy(bytes.data() + offset, &value, sizeof(T));
+}
+
+// One sequence of two tracks with tempos, time signatures, notes and automation
+static ProjectData sampleProject() {
+    ProjectData data;
+    data.nextSequenceId = 2;
+    data.nextTrackId = 3;
+    data.nextNoteId = 4;
+    data.ticksPerBeat = 480;
+
+    SequenceRecord sequence = {};
+    sequence.id = 1;
+    sequence.firstTrack = 0;
+    sequence.trackCount = 2;
+    sequence.ticksPerBeat = 480;
+    data.sequences.push_back(sequence);
+    data.tempos.push_back({{0.0, 120.0, 1, 0}, {8.0, 90.0, 0, 0}});
+    data.timeSignatures.push_back({{0.0, 4, 4}, {16.0, 7, 8}});
+
+    for (int32_t id = 1; id <= 2; id++) {
+        TrackRecord track = {};
+        track.id = id;
+        track.instrumentId = id * 10;
+        track.volume = 0.8f;
+        track.pan = id == 1 ? -0.5f : 0.5f;
+        data.tracks.push_back(track);
+    }
+    data.notes.push_back({{1, 0, 480, 60, 100, 0}, {1, 480, 240, 64, 90, 0}});
+    data.notes.push_back({{3, 960, 960, 67, 80, 0}});
+    data.automation.push_back({{0.0, 1.0f, 0}, {4.0, 0.25f, 0}});
+    data.automation.push_back({});
+    return data;
+}
+
+static Bytes writeSample(const char* name) {
+    ProjectData data = sampleProject();
+    std::string error;
+    CHECK(writeFile(testPath(name), data, error));
+    Bytes bytes = readBytes(testPath(name));
+    std::remove(testPath(name).c_str());
+    return bytes;
+}
+
+// Write the bytes back and open them, returning the validation error
+static std::string openError(const char* name, const Bytes& bytes) {
+    writeBytes(testPath(name), bytes);
+    MappedFile file;
+    std::string error;
+    bool ok = file.open(testPath(name), error);
+    std::remove(testPath(name).c_str());
+    CHECK(ok == error.empty());
+    return error;
+}
+
+static void validFile() {
+    ProjectData data = sampleProject();
+    std::string error;
+    CHECK(writeFile(testPath("valid"), data, error));
+
+    MappedFile file;
+    CHECK(file.open(testPath("valid"), error));
+    CHECK(error.empty());
+    const FileHeader& header = file.header();
+    CHECK(header.magic == MAGIC && header.version == VERSION);
+    CHECK(header.ticksPerBeat == 480);
+    CHECK(header.sequenceCount == 1 && header.trackCount == 2);
+    CHECK(header.nextSequenceId == 2 && header.nextTrackId == 3 && header.nextNoteId == 4);
+
+    const SequenceRecord& sequence = file.sequences()[0];
+    CHECK(sequence.id == 1 && sequence.trackCount == 2 && sequence.ticksPerBeat == 480);
+    CHECK(sequence.tempoCount == 2 && sequence.timeSignatureCount == 2);
+    CHECK(file.tempos(sequence)[1].beat == 8.0 && file.tempos(sequence)[1].bpm == 90.0);
+    CHECK(file.tempos(sequence)[0].ramp == 1);
+    CHECK(file.timeSignatures(sequence)[1].numerator == 7 && file.timeSignatures(sequence)[1].denominator == 8);
+
+    const TrackRecord* tracks = file.tracks();
+    CHECK(tracks[0].instrumentId == 10 && tracks[1].instrumentId == 20);
+    CHECK(tracks[0].noteCount == 2 && tracks[1].noteCount == 1);
+    CHECK(tracks[0].automationCount == 2 && tracks[1].automationCount == 0);
+    CHECK(file.notes(tracks[0])[1].startDelta == 480 && file.notes(tracks[0])[1].noteNumber == 64);
+    CHECK(file.notes(tracks[1])[0].idDelta == 3 && file.notes(tracks[1])[0].durationTicks == 960);
+    CHECK(file.automation(tracks[0])[1].value == 0.25f);
+
+    // Every offset is 8-byte aligned
+    CHECK(header.sequencesOffset % 8 == 0 && header.tracksOffset % 8 == 0);
+    CHECK(sequence.temposOffset % 8 == 0 && sequence.timeSignaturesOffset % 8 == 0);
+    CHECK(tracks[0].notesOffset % 8 == 0 && tracks[1].automationOffset % 8 == 0);
+    std::remove(testPath("valid").c_str());
+
+    // An empty project is valid too
+    ProjectData empty;
+    CHECK(writeFile(testPath("empty"), empty, error));
+    MappedFile emptyFile;
+    CHECK(emptyFile.open(testPath("empty"), error));
+    CHECK(emptyFile.header().sequenceCount == 0 && emptyFile.header().trackCount == 0);
+    std::remove(testPath("empty").c_str());
+
+    // The unmodified bytes pass through the same path as the corrupt ones below
+    CHECK(openError("roundtrip", writeSample("roundtrip")).empty());
+}
+
+static void corruptHeader() {
+    const Bytes valid = writeSample("header");
+
+    Bytes bytes = valid;
+    put<uint32_t>(bytes, offsetof(FileHeader, magic), 0x12345678);
+    CHECK(openError("header", bytes) == "Not a project file");
+
+    bytes = valid;
+    put<uint32_t>(bytes, offsetof(FileHeader, version), VERSION + 1);
+    CHECK(openError("header", bytes) == "Unsupported project version: " + std::to_string(VERSION + 1));
+
+    bytes = valid;
+    put<uint32_t>(bytes, offsetof(FileHeader, ticksPerBeat), 0);
+    CHECK(openError("header", bytes) == "Corrupt project header");
+
+    // The recorded size must match the file: truncated, or with trailing bytes
+    bytes = valid;
+    bytes.resize(bytes.size() - 8);
+    CHECK(openError("header", bytes) == "Corrupt project header");
+    bytes = valid;
+    bytes.resize(bytes.size() + 8);
+    CHECK(openError("header", bytes) == "Corrupt project header");
+
+    // Shorter than the header itself
+    bytes = valid;
+    bytes.resize(sizeof(FileHeader) - 1);
+    CHECK(openError("header", bytes).find("Not a project file") == 0);
+}
+
+static void headerOffsetsOutOfBounds() {
+    const Bytes valid = writeSample("tables");
+    const uint64_t size = valid.size();
+
+    struct Case {
+        size_t field;
+        uint64_t value;
+    };
+    const Case cases[] = {
+        {offsetof(FileHeader, sequencesOffset), size + 8},                       // Past the end
+        {offsetof(FileHeader, sequencesOffset), size - 8},                       // Table runs off the end
+        {offsetof(FileHeader, sequencesOffset), 60},                             // Misaligned
+        {offsetof(FileHeader, tracksOffset), size},                              // Exactly at the end
+        {offsetof(FileHeader, tracksOffset), UINT64_MAX - 7},                    // Would wrap
+        {offsetof(FileHeader, tracksOffset), get<uint64_t>(valid, offsetof(FileHeader, tracksOffset)) + 1},
+    };
+    for (const Case& testCase : cases) {
+        Bytes bytes = valid;
+        put<uint64_t>(bytes, testCase.field, testCase.value);
+        CHECK(openError("tables", bytes) == "Corrupt project header");
+    }
+
+    // Counts larger than the file can hold
+    Bytes bytes = valid;
+    put<uint32_t>(bytes, offsetof(FileHeader, trackCount), 0x10000000);
+    CHECK(openError("tables", bytes) == "Corrupt project header");
+    bytes = valid;
+    put<uint32_t>(bytes, offsetof(FileHeader, sequenceCount), UINT32_MAX);
+    CHECK(openError("tables", bytes) == "Corrupt project header");
+}
+
+static void sequenceOffsetsOutOfBounds() {
+    const Bytes valid = writeSample("sequences");
+    const uint64_t size = valid.size();
+    const size_t record = static_cast<size_t>(get<uint64_t>(valid, offsetof(FileHeader, sequencesOffset)));
+
+    Bytes bytes = valid;
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, ticksPerBeat), 0);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+
+    bytes = valid;
+    put<uint64_t>(bytes, record + offsetof(SequenceRecord, temposOffset), size + 8);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+
+    bytes = valid;
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, tempoCount), 0x01000000);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+
+    bytes = valid;
+    put<uint64_t>(bytes, record + offsetof(SequenceRecord, timeSignaturesOffset), size - 8);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+
+    // Track ranges must lie inside the track table, without wrapping
+    bytes = valid;
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, trackCount), 3);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+    bytes = valid;
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, firstTrack), 3);
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, trackCount), 0);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+    bytes = valid;
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, firstTrack), 1);
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, trackCount), UINT32_MAX);
+    CHECK(openError("sequences", bytes) == "Corrupt sequence table");
+
+    // An empty array may sit at the end of the file
+    bytes = valid;
+    put<uint32_t>(bytes, record + offsetof(SequenceRecord, timeSignatureCount), 0);
+    put<uint64_t>(bytes, record + offsetof(SequenceRecord, timeSignaturesOffset), size);
+    CHECK(openError("sequences", bytes).empty());
+}
+
+static void trackOffsetsOutOfBounds() {
+    const Bytes valid = writeSample("tracks");
+    const uint64_t size = valid.size();
+    const size_t second = static_cast<size_t>(get<uint64_t>(valid, offsetof(FileHeader, tracksOffset))) +
+                          sizeof(TrackRecord);
+
+    Bytes bytes = valid;
+    put<uint64_t>(bytes, second + offsetof(TrackRecord, notesOffset), size);
+    CHECK(openError("tracks", bytes) == "Corrupt track table");
+
+    bytes = valid;
+    put<uint64_t>(bytes, second + offsetof(TrackRecord, notesOffset),
+                  get<uint64_t>(valid, second + offsetof(TrackRecord, notesOffset)) + 4);
+    CHECK(openError("tracks", bytes) == "Corrupt track table");
+
+    bytes = valid;
+    put<uint32_t>(bytes, second + offsetof(TrackRecord, noteCount), 0x20000000);
+    CHECK(openError("tracks", bytes) == "Corrupt track table");
+
+    bytes = valid;
+    put<uint32_t>(bytes, second + offsetof(TrackRecord, automationCount), 1);
+    put<uint64_t>(bytes, second + offsetof(TrackRecord, automationOffset), size - 8);
+    CHECK(openError("tracks", bytes) == "Corrupt track table");
+
+    // The last record exactly filling the file is in bounds
+    bytes = valid;
+    put<uint32_t>(bytes, second + offsetof(TrackRecord, automationCount), 1);
+    put<uint64_t>(bytes, second + offsetof(TrackRecord, automationOffset), size - sizeof(AutomationRecord));
+    CHECK(openError("tracks", bytes).empty());
+}
+
+int main() {
+    RUN_TEST(validFile);
+    RUN_TEST(corruptHeader);
+    RUN_TEST(headerOffsetsOutOfBounds);
+    RUN_TEST(sequenceOffsetsOutOfBounds);
+    RUN_TEST(trackOffsetsOutOfBounds);
+    return testResult();
+}
@@ -0,0 +1,144 @@
+#include "tempo_map.h"
+#include <cmath>
+#include "test_support.h"
+
+static constexpr double TOLERANCE = 1e-9;
+static constexpr int TICKS_PER_BEAT = 480;
+
+// Every tick in [0, endBeat) maps to a time and back to the same beat, and
+// time never runs backwards
+static void checkRoundTrips(const TempoMap& map, double endBeat) {
+    double previous = -1.0;
+    for (int tick = 0; tick < endBeat * TICKS_PER_BEAT; tick += 7) {
+        double beat = static_cast<double>(tick) / TICKS_PER_BEAT;
+        double seconds = map.secondsAt(beat);
+        CHECK(seconds > previous);
+        CHECK_NEAR(map.beatAt(seconds), beat, TOLERANCE);
+        previous = seconds;
+    }
+}
+
+static void constantTempo() {
+    TempoMap map(120.0);
+    CHECK_NEAR(map.secondsAt(0.0), 0.0, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(1.0), 0.5, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(1000.0), 500.0, TOLERANCE);
+    CHECK_NEAR(map.beatAt(3.25), 6.5, TOLERANCE);
+    CHECK_NEAR(map.tempoAt(17.0), 120.0, TOLERANCE);
+    checkRoundTrips(map, 16.0);
+}
+
+static void rampUp() {
+    // 60 to 120 BPM over four beats: 60 / k * ln(120 / 60) seconds, k = 15 BPM per beat
+    TempoMap map(60.0);
+    CHECK(map.setTempo(0.0, 60.0, true));
+    CHECK(map.setTempo(4.0, 120.0));
+    CHECK_NEAR(map.tempoAt(2.0), 90.0, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(4.0), 4.0 * std::log(2.0), TOLERANCE);
+    CHECK_NEAR(map.secondsAt(2.0), 4.0 * std::log(1.5), TOLERANCE);
+    CHECK_NEAR(map.beatAt(4.0 * std::log(1.5)), 2.0, TOLERANCE);
+
+    // After the ramp the tempo holds at 120
+    CHECK_NEAR(map.secondsAt(6.0), 4.0 * std::log(2.0) + 1.0, TOLERANCE);
+    CHECK_NEAR(map.tempoAt(10.0), 120.0, TOLERANCE);
+    checkRoundTrips(map, 8.0);
+}
+
+static void rampDown() {
+    TempoMap map(180.0);
+    CHECK(map.setTempo(0.0, 180.0, true));
+    CHECK(map.setTempo(2.0, 90.0));
+    CHECK_NEAR(map.secondsAt(2.0), 60.0 / -45.0 * std::log(0.5), TOLERANCE);
+    checkRoundTrips(map, 4.0);
+}
+
+static void flatRamp() {
+    // A ramp to the same tempo is a constant segment
+    TempoMap map(100.0);
+    CHECK(map.setTempo(0.0, 100.0, true));
+    CHECK(map.setTempo(3.0, 100.0));
+    CHECK_NEAR(map.secondsAt(3.0), 1.8, TOLERANCE);
+    checkRoundTrips(map, 6.0);
+}
+
+static void multipleSegments() {
+    // Step, ramp, step, and a ramp flag on the last change (nothing to ramp to)
+    TempoMap map(120.0);
+    CHECK(map.setTempo(4.0, 90.0, true));
+    CHECK(map.setTempo(8.0, 150.0));
+    CHECK(map.setTempo(12.0, 75.0, true));
+
+    double rampSeconds = 60.0 / 15.0 * std::log(150.0 / 90.0);
+    CHECK_NEAR(map.secondsAt(4.0), 2.0, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(8.0), 2.0 + rampSeconds, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(12.0), 2.0 + rampSeconds + 1.6, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(14.0), 2.0 + rampSeconds + 1.6 + 1.6, TOLERANCE);
+    CHECK_NEAR(map.tempoAt(13.0), 75.0, TOLERANCE);
+    checkRoundTrips(map, 16.0);
+
+    // Edits in any order give the same map
+    TempoMap reordered(120.0);
+    CHECK(reordered.setTempo(12.0, 75.0, true));
+    CHECK(reordered.setTempo(8.0, 150.0));
+    CHECK(reordered.setTempo(4.0, 90.0, true));
+    for (double beat = 0.0; beat < 16.0; beat += 0.5) {
+        CHECK_NEAR(reordered.secondsAt(beat), map.secondsAt(beat), TOLERANCE);
+    }
+
+    // Removing the ramp's end stretches the ramp to the next change
+    CHECK(map.removeTempo(8.0));
+    CHECK_NEAR(map.tempoAt(8.0), 82.5, TOLERANCE);
+    CHECK_NEAR(map.secondsAt(12.0), 2.0 + 60.0 / (-15.0 / 8.0) * std::log(75.0 / 90.0), TOLERANCE);
+    checkRoundTrips(map, 16.0);
+}
+
+static void boundaryTicks() {
+    TempoMap map(120.0);
+    CHECK(map.setTempo(2.0, 60.0, true));
+    CHECK(map.setTempo(4.0, 240.0));
+
+    // Exactly on a change, and one tick either side of it, the time is
+    // continuous and the tempo is the new segment's
+    for (double change : {2.0, 4.0}) {
+        double before = map.secondsAt(change - 1.0 / TICKS_PER_BEAT);
+        double at = map.secondsAt(change);
+        double after = map.secondsAt(change + 1.0 / TICKS_PER_BEAT);
+        CHECK(before < at && at < after);
+        CHECK_NEAR(map.beatAt(at), change, TOLERANCE);
+        CHECK_NEAR(map.beatAt(before), change - 1.0 / TICKS_PER_BEAT, TOLERANCE);
+        CHECK_NEAR(map.beatAt(after), change + 1.0 / TICKS_PER_BEAT, TOLERANCE);
+    }
+    CHECK_NEAR(map.tempoAt(2.0), 60.0, TOLERANCE);
+    CHECK_NEAR(map.tempoAt(4.0), 240.0, TOLERANCE);
+
+    // Before beat 0 the initial tempo continues
+    CHECK_NEAR(map.secondsAt(-1.0), -0.5, TOLERANCE);
+    CHECK_NEAR(map.beatAt(-0.5), -1.0, TOLERANCE);
+    CHECK_NEAR(map.tempoAt(-1.0), 120.0, TOLERANCE);
+
+    // Far past the last change
+    CHECK_NEAR(map.beatAt(map.secondsAt(1e6)), 1e6, 1e-6);
+}
+
+static void rejectsInvalidChanges() {
+    TempoMap map(120.0);
+    CHECK(!map.setTempo(-1.0, 100.0));
+    CHECK(!map.setTempo(1.0, 0.0));
+    CHECK(!map.setTempo(1.0, TempoMap::MAX_BPM + 1.0));
+    CHECK(!map.setTempo(NAN, 100.0));
+    CHECK(!map.removeTempo(0.0));
+    CHECK(!map.removeTempo(3.0));
+    CHECK(map.tempoEvents().size() == 1);
+    CHECK_NEAR(map.secondsAt(4.0), 2.0, TOLERANCE);
+}
+
+int main() {
+    RUN_TEST(constantTempo);
+    RUN_TEST(rampUp);
+    RUN_TEST(rampDown);
+    RUN_TEST(flatRamp);
+    RUN_TEST(multipleSegments);
+    RUN_TEST(boundaryTicks);
+    RUN_TEST(rejectsInvalidChanges);
+    return testResult();
+}
@@ -0,0 +1,45 @@
+#ifndef TEST_SUPPORT_H
+#define TEST_SUPPORT_H
+
+#include <cmath>
+#include <cstdio>
+
+// Minimal checks for the native tests: a failed check is reported and
+// counted, and the test binary exits non-zero if any failed
+
+inline int& testFailures() {
+    static int failures = 0;
+    return failures;
+}
+
+#define CHECK(condition)                                                                            \
+    do {                                                                                            \
+        if (!(condition)) {                                                                         \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, #condition);      \
+            testFailures()++;                                                                       \
+        }                                                                                           \
+    } while (0)
+
+#define CHECK_NEAR(actual, expected, tolerance)                                                     \
+    do {                                                                                            \
+        double checkActual = (actual);                                                              \
+        double checkExpected = (expected);                                                          \
+        if (!(std::fabs(checkActual - checkExpected) <= (tolerance))) {                             \
+            std::fprintf(stderr, "%s:%d: CHECK_NEAR(%s, %s) failed: %.12g vs %.12g\n",              \
+                         __FILE__, __LINE__, #actual, #expected, checkActual, checkExpected);       \
+            testFailures()++;                                                                       \
+        }                                                                                           \
+    } while (0)
+
+#define RUN_TEST(test)                                                                              \
+    do {                                                                                            \
+        int failuresBefore = testFailures();                                                        \
+        test();                                                                                     \
+        std::printf("%s %s\n", testFailures() == failuresBefore ? "PASS" : "FAIL", #test);          \
+    } while (0)
+
+inline int testResult() {
+    return testFailures() == 0 ? 0 : 1;
+}
+
+#endif // TEST_SUPPORT_H
@@ -8,6 +8,7 @@
 #include <string>
 #include <vector>
 #include <unordered_map>
+#include <algorithm>
 #include <mutex>
 #include <sfizz.hpp>
 
@@ -130,7 +131,8 @@ public:
     int id;
     int instrumentId;
     std::vector<Note> notes;
-    std::vector<AutomationPoint> volumeAutomation;
+    std::vector<AutomationPoint> volumeAutomation;  // Sorted by timeInBeats
+    size_t automationCursor = 0;                     // Last point at or before the playhead
     float volume;
 };
 
@@ -189,8 +191,10 @@ private:
     std::mutex m_mutex;
     
     // Helper methods
-    float getTrackVolumeAtPosition(const Track& track, double positionInBeats);
+    float getTrackVolumeAtPosition(Track& track, double positionInBeats);
     void processActiveNotes(double positionInBeats, double previousPositionInBeats, double sampleRate);
+    void releaseNotesHeldAt(double positionInBeats);
+    void chaseNotesAt(double positionInBeats);
 };
 
 // C++ implementation of the AudioEngine for iOS
@@ -591,8 +595,12 @@ int SequenceManager::addVolumeAutomation(int sequenceId, int trackId, double tim
     point.timeInBeats = timeInBeats;
     point.value = volume;
     
-    track.volumeAutomation.push_back(point);
-    return track.volumeAutomation.size() - 1; // Return the index as automation ID
+    // Keep the lane sorted so playback can walk it with a cursor
+    auto it = std::upper_bound(track.volumeAutomation.begin(), track.volumeAutomation.end(), timeInBeats,
+                               [](double time, const AutomationPoint& p) { return time < p.timeInBeats; });
+    it = track.volumeAutomation.insert(it, point);
+    track.automationCursor = 0;
+    return static_cast<int>(it - track.volumeAutomation.begin()); // Return the index as automation ID
 }
 
 bool SequenceManager::deleteVolumeAutomation(int sequenceId, int trackId, int automationId) {
@@ -615,6 +623,7 @@ bool SequenceManager::deleteVolumeAutomation(int sequenceId, int trackId, int au
     }
     
     track.volumeAutomation.erase(track.volumeAutomation.begin() + automationId);
+    track.automationCursor = 0;
     return true;
 }
 
@@ -657,9 +666,15 @@ void SequenceManager::stopPlayback() {
     NSLog(@"Stopped playback");
 }
 
+// Seeking during playback releases the notes held at the old position and
+// restarts those spanning the new one, so long notes keep sounding
 void SequenceManager::setPlaybackPosition(double positionInBeats) {
     std::lock_guard<std::mutex> lock(m_mutex);
     
+    if (m_isPlaying && m_activeSequenceId != -1) {
+        releaseNotesHeldAt(m_currentPositionInBeats);
+        chaseNotesAt(positionInBeats);
+    }
     m_currentPositionInBeats = positionInBeats;
 }
 
@@ -709,47 +724,89 @@ void SequenceManager::processAudio(double sampleRate, double bufferSize) {
     
     // Calculate positions
     double prevPosition = m_currentPositionInBeats;
-    m_currentPositionInBeats += bufferSizeInBeats;
+    double position = prevPosition + bufferSizeInBeats;
     
-    // Handle looping
-    if (sequence->isLooping && m_currentPositionInBeats >= sequence->lengthInBeats) {
-        m_currentPositionInBeats = fmod(m_currentPositionInBeats, sequence->lengthInBeats);
-        prevPosition = -1; // Force processing of all notes
+    // Handle looping: finish the pass up to the loop end, release notes still
+    // held there, then play only the overshoot from the start
+    double length = sequence->lengthInBeats;
+    if (sequence->isLooping && length > 0 && prevPosition < length && position >= length) {
+        processActiveNotes(length, prevPosition, sampleRate);
+        releaseNotesHeldAt(length);
+        prevPosition = 0;
+        position = fmod(position - length, length);
     }
+    m_currentPositionInBeats = position;
     
     // Process notes
     processActiveNotes(m_currentPositionInBeats, prevPosition, sampleRate);
 }
 
-float SequenceManager::getTrackVolumeAtPosition(const Track& track, double positionInBeats) {
-    if (track.volumeAutomation.empty()) {
-        return track.volume;
+void SequenceManager::releaseNotesHeldAt(double positionInBeats) {
+    auto* sequence = getSequence(m_activeSequenceId);
+    if (!sequence) {
+        return;
     }
     
-    // Find the two automation points surrounding the position
-    const AutomationPoint* prev = nullptr;
-    const AutomationPoint* next = nullptr;
+    for (const auto& trackPair : sequence->tracks) {
+        const auto& track = trackPair.second;
+        for (const auto& note : track.notes) {
+            if (note.startTimeInBeats < positionInBeats &&
+                note.startTimeInBeats + note.durationInBeats >= positionInBeats) {
+                m_instrumentManager->sendNoteOff(track.instrumentId, note.noteNumber);
+            }
+        }
+    }
+}
+
+// Start the notes that began before positionInBeats and are still held there;
+// those starting exactly at it are left to the next processAudio pass
+void SequenceManager::chaseNotesAt(double positionInBeats) {
+    auto* sequence = getSequence(m_activeSequenceId);
+    if (!sequence) {
+        return;
+    }
     
-    for (const auto& point : track.volumeAutomation) {
-        if (point.timeInBeats <= positionInBeats) {
-            prev = &point;
-        } else {
-            next = &point;
-            break;
+    for (const auto& trackPair : sequence->tracks) {
+        const auto& track = trackPair.second;
+        for (const auto& note : track.notes) {
+            if (note.startTimeInBeats < positionInBeats &&
+                note.startTimeInBeats + note.durationInBeats > positionInBeats) {
+                m_instrumentManager->sendNoteOn(track.instrumentId, note.noteNumber, note.velocity);
+            }
         }
     }
+}
+
+float SequenceManager::getTrackVolumeAtPosition(Track& track, double positionInBeats) {
+    const auto& points = track.volumeAutomation;
+    if (points.empty()) {
+        return track.volume;
+    }
+    if (positionInBeats < points.front().timeInBeats) {
+        track.automationCursor = 0;
+        return points.front().value;
+    }
     
-    if (!prev) {
-        return next ? next->value : track.volume;
+    // Walk forward from the last position; binary search only when the playhead moved back
+    size_t& cursor = track.automationCursor;
+    if (cursor >= points.size() || points[cursor].timeInBeats > positionInBeats) {
+        auto it = std::upper_bound(points.begin(), points.end(), positionInBeats,
+                                   [](double time, const AutomationPoint& p) { return time < p.timeInBeats; });
+        cursor = static_cast<size_t>(it - points.begin()) - 1;
+    }
+    while (cursor + 1 < points.size() && points[cursor + 1].timeInBeats <= positionInBeats) {
+        cursor++;
     }
     
-    if (!next) {
-        return prev->value;
+    if (cursor + 1 == points.size()) {
+        return points[cursor].value;
     }
     
     // Interpolate between the two points
-    double t = (positionInBeats - prev->timeInBeats) / (next->timeInBeats - prev->timeInBeats);
-    return prev->value + t * (next->value - prev->value);
+    const AutomationPoint& prev = points[cursor];
+    const AutomationPoint& next = points[cursor + 1];
+    double t = (positionInBeats - prev.timeInBeats) / (next.timeInBeats - prev.timeInBeats);
+    return prev.value + t * (next.value - prev.value);
 }
 
 void SequenceManager::processActiveNotes(double positionInBeats, double previousPositionInBeats, double sampleRate) {
@@ -2,12 +2,638 @@ import 'dart:ffi';
 import 'dart:io';
 import 'dart:isolate';
 import 'dart:async';
+import 'dart:math' show min;
+import 'dart:typed_data';
 import 'dart:developer' as developer;
 import 'package:ffi/ffi.dart';
 
 /// Callback function type for native to Dart callbacks
 typedef NativeCallbackType = void Function(int type, int data1, int data2, double data3);
 
+/// Policy used by the native engine to pick a voice when a polyphony limit is reached.
+/// The order matches the native `VoiceStealingPolicy` enum.
+enum VoiceStealingPolicy { oldest, quietest, lowestPriority, sameNote }
+
+/// Segment shape of instrument envelopes. The order matches the native `EnvelopeCurve` enum.
+enum EnvelopeCurve { linear, exponential }
+
+/// Packed note for [MultiTrackerFFI.addNotesBulk]. The layout matches the
+/// native `NoteRecord` struct (24 bytes).
+final class NoteRecord extends Struct {
+  @Double()
+  external double startBeat;
+  
+  @Double()
+  external double durationBeats;
+  
+  @Int32()
+  external int noteNumber;
+  
+  @Int32()
+  external int velocity;
+}
+
+/// Note returned by [MultiTrackerFFI.queryNotes]. The layout matches the
+/// native `NoteQueryRecord` struct (32 bytes).
+final class NoteQueryRecord extends Struct {
+  @Double()
+  external double startBeat;
+  
+  @Double()
+  external double durationBeats;
+  
+  @Int32()
+  external int noteId;
+  
+  @Int32()
+  external int noteNumber;
+  
+  @Int32()
+  external int velocity;
+  
+  @Int32()
+  external int reserved;
+}
+
+/// Batch of sequence edits applied by [MultiTrackerFFI.submitCommands] in a
+/// single native call. Encodes the native command buffer format: a one-byte
+/// opcode followed by a packed little-endian payload per command.
+class CommandBuffer {
+  static const int _setTrackVolume = 1;
+  static const int _setTrackPan = 2;
+  static const int _deleteNote = 3;
+  static const int _moveNote = 4;
+  static const int _transposeNote = 5;
+  static const int _setNoteVelocity = 6;
+  static const int _setTempo = 7;
+  
+  Uint8List _bytes = Uint8List(256);
+  late ByteData _data = ByteData.sublistView(_bytes);
+  int _length = 0;
+  int _count = 0;
+  
+  /// Number of encoded commands
+  int get commandCount => _count;
+  
+  /// Encoded size in bytes
+  int get lengthInBytes => _length;
+  
+  /// The encoded commands
+  Uint8List get bytes => Uint8List.sublistView(_bytes, 0, _length);
+  
+  void clear() {
+    _length = 0;
+    _count = 0;
+  }
+  
+  void setTrackVolume(int sequenceId, int trackId, double volume) {
+    _begin(_setTrackVolume, 12);
+    _int32(sequenceId);
+    _int32(trackId);
+    _float32(volume);
+  }
+  
+  void setTrackPan(int sequenceId, int trackId, double pan) {
+    _begin(_setTrackPan, 12);
+    _int32(sequenceId);
+    _int32(trackId);
+    _float32(pan);
+  }
+  
+  void deleteNote(int sequenceId, int trackId, int noteId) {
+    _begin(_deleteNote, 12);
+    _int32(sequenceId);
+    _int32(trackId);
+    _int32(noteId);
+  }
+  
+  void moveNote(int sequenceId, int trackId, int noteId, double startBeat, double durationBeats) {
+    _begin(_moveNote, 28);
+    _int32(sequenceId);
+    _int32(trackId);
+    _int32(noteId);
+    _float64(startBeat);
+    _float64(durationBeats);
+  }
+  
+  void transposeNote(int sequenceId, int trackId, int noteId, int semitones) {
+    _begin(_transposeNote, 16);
+    _int32(sequenceId);
+    _int32(trackId);
+    _int32(noteId);
+    _int32(semitones);
+  }
+  
+  void setNoteVelocity(int sequenceId, int trackId, int noteId, int velocity) {
+    _begin(_setNoteVelocity, 16);
+    _int32(sequenceId);
+    _int32(trackId);
+    _int32(noteId);
+    _int32(velocity);
+  }
+  
+  void setTempo(int sequenceId, double bpm) {
+    _begin(_setTempo, 12);
+    _int32(sequenceId);
+    _float64(bpm);
+  }
+  
+  void _begin(int opcode, int payloadSize) {
+    final needed = _length + 1 + payloadSize;
+    if (needed > _bytes.length) {
+      var capacity = _bytes.length * 2;
+      while (capacity < needed) {
+        capacity *= 2;
+      }
+      _bytes = Uint8List(capacity)..setRange(0, _length, _bytes);
+      _data = ByteData.sublistView(_bytes);
+    }
+    _data.setUint8(_length++, opcode);
+    _count++;
+  }
+  
+  void _int32(int value) {
+    _data.setInt32(_length, value, Endian.little);
+    _length += 4;
+  }
+  
+  void _float32(double value) {
+    _data.setFloat32(_length, value, Endian.little);
+    _length += 4;
+  }
+  
+  void _float64(double value) {
+    _data.setFloat64(_length, value, Endian.little);
+    _length += 8;
+  }
+}
+
+/// Level meter snapshot pushed by the native engine. Values are linear
+/// amplitudes; peaks are the highest level since the previous snapshot.
+class MeterLevels {
+  /// Peak level per track ID
+  final Map<int, double> trackPeaks;
+  
+  /// Smoothed RMS level per track ID
+  final Map<int, double> trackRms;
+  
+  /// Peak level of the master output
+  final double masterPeak;
+  
+  /// Smoothed RMS level of the master output
+  final double masterRms;
+  
+  const MeterLevels({
+    required this.trackPeaks,
+    required this.trackRms,
+    required this.masterPeak,
+    required this.masterRms,
+  });
+}
+
+/// Kind of [EngineEvent]. The values match the native `EngineEvent::Type`.
+enum EngineEventType {
+  unknown,
+  noteStarted,
+  noteEnded,
+  position,
+  loopWrapped,
+  loadProgress,
+  underrun,
+}
+
+/// What an [EngineEventType.loadProgress] event is loading. The order matches
+/// the native `EngineEvent::LoadKind` enum.
+enum LoadKind { instrument, midiFile, project }
+
+/// Event reported by the native engine through [MultiTrackerFFI.engineEvents].
+class EngineEvent {
+  /// Size of one native event record in bytes
+  static const int recordSize = 24;
+  
+  final EngineEventType type;
+  
+  /// Render frame the event takes effect at, on the same counter as
+  /// [AudioClockSnapshot.frame]; -1 for load progress
+  final int frame;
+  
+  /// Instrument ID for note events, sequence ID for position and loop
+  /// events, the loaded instrument or sequence for load progress (-1 until
+  /// it is known)
+  final int id;
+  
+  /// Note number for note events
+  final int noteNumber;
+  
+  /// Velocity for note starts
+  final int velocity;
+  
+  /// Beat for position events, loop start beat for loop wraps, fraction
+  /// done (0-1) for load progress, milliseconds late for underruns
+  final double value;
+  
+  const EngineEvent({
+    required this.type,
+    required this.frame,
+    required this.id,
+    required this.noteNumber,
+    required this.velocity,
+    required this.value,
+  });
+  
+  /// What a load progress event is loading
+  LoadKind get loadKind => LoadKind.values[noteNumber.clamp(0, LoadKind.values.length - 1)];
+  
+  /// Decode a batch of native records: int64 frame, float64 value, int32 id,
+  /// then type, data1 and data2 bytes and one spare, little-endian
+  static List<EngineEvent> decodeBatch(Uint8List records) {
+    final data = ByteData.sublistView(records);
+    final events = <EngineEvent>[];
+    for (var offset = 0; offset + recordSize <= records.length; offset += recordSize) {
+      final type = data.getUint8(offset + 20);
+      events.add(EngineEvent(
+        type: type < EngineEventType.values.length ? EngineEventType.values[type] : EngineEventType.unknown,
+        frame: data.getInt64(offset, Endian.little),
+        value: data.getFloat64(offset + 8, Endian.little),
+        id: data.getInt32(offset + 16, Endian.little),
+        noteNumber: data.getUint8(offset + 21),
+        velocity: data.getUint8(offset + 22),
+      ));
+    }
+    return events;
+  }
+}
+
+/// Clock state the audio thread republishes every callback, read in place by
+/// [PlaybackClock]. The layout matches the native `AudioClockState` struct
+/// (48 bytes); [sequence] is odd while a write is in progress.
+final class AudioClockState extends Struct {
+  @Uint32()
+  external int sequence;
+  
+  @Int32()
+  external int playing;
+  
+  @Int32()
+  external int sampleRate;
+  
+  @Int32()
+  external int sequenceId;
+  
+  @Int64()
+  external int frame;
+  
+  @Int64()
+  external int hostTimeNanos;
+  
+  @Double()
+  external double beat;
+  
+  @Double()
+  external double beatsPerSecond;
+}
+
+/// Native layout of a recording status (40 bytes), filled in by
+/// `get_recording_status`
+final class _RecordingStatusStruct extends Struct {
+  @Int64()
+  external int framesWritten;
+  
+  @Int64()
+  external int framesDropped;
+  
+  @Int64()
+  external int startFrame;
+  
+  @Double()
+  external double startBeat;
+  
+  @Int32()
+  external int sequenceId;
+  
+  @Int32()
+  external int state;
+}
+
+/// State of the input recorder. The values match the native
+/// `RecordingStatus::State`.
+enum RecordingState { idle, recording, failed }
+
+/// Progress of the current (or last) input recording and where it sits on
+/// the timeline
+class RecordingStatus {
+  final RecordingState state;
+  
+  /// Frames written to the file so far
+  final int framesWritten;
+  
+  /// Frames lost because the disk writer fell behind
+  final int framesDropped;
+  
+  /// Render frame (as in [AudioClockSnapshot.frame]) the file's first frame
+  /// lines up with, latency compensated; -1 if the output clock wasn't running
+  final int startFrame;
+  
+  /// Transport beat at [startFrame] in [sequenceId]
+  final double startBeat;
+  
+  /// Sequence playing when recording began, or -1
+  final int sequenceId;
+  
+  const RecordingStatus({
+    required this.state,
+    required this.framesWritten,
+    required this.framesDropped,
+    required this.startFrame,
+    required this.startBeat,
+    required this.sequenceId,
+  });
+}
+
+/// Consistent copy of [AudioClockState]: at [hostTimeNanos] the engine
+/// started playing [frame], which is transport position [beat].
+class AudioClockSnapshot {
+  final bool playing;
+  final int sampleRate;
+  
+  /// Playing sequence, or -1
+  final int sequenceId;
+  final int frame;
+  final int hostTimeNanos;
+  final double beat;
+  
+  /// Transport speed at [beat]; 0 while stopped
+  final double beatsPerSecond;
+  
+  const AudioClockSnapshot({
+    required this.playing,
+    required this.sampleRate,
+    required this.sequenceId,
+    required this.frame,
+    required this.hostTimeNanos,
+    required this.beat,
+    required this.beatsPerSecond,
+  });
+}
+
+/// Playhead that reads the engine's shared clock through a pointer and
+/// extrapolates between callbacks, so a UI can animate every frame without
+/// calling into native code. Obtain one from [MultiTrackerFFI.playbackClock];
+/// it is invalid after [MultiTrackerFFI.dispose].
+class PlaybackClock {
+  static const int _maxReadAttempts = 8;
+  
+  final Pointer<AudioClockState> _state;
+  final int _hostTimeOffsetNanos;
+  final Stopwatch _stopwatch;
+  
+  AudioClockSnapshot? _last;
+  
+  PlaybackClock._(this._state, this._hostTimeOffsetNanos, this._stopwatch);
+  
+  /// Host time in the engine's clock (CLOCK_MONOTONIC nanoseconds), kept by
+  /// a stopwatch calibrated against the engine when the clock was created
+  int get hostTimeNanos => _hostTimeOffsetNanos + _stopwatch.elapsedMicroseconds * 1000;
+  
+  /// Latest consistent snapshot. The audio thread never waits for readers,
+  /// so a read that overlaps a write is retried; if it keeps overlapping the
+  /// previous snapshot is returned.
+  AudioClockSnapshot? read() {
+    final state = _state.ref;
+    for (int attempt = 0; attempt < _maxReadAttempts; attempt++) {
+      final before = state.sequence;
+      if (before == 0) {
+        return null;
+      }
+      if (before.isOdd) {
+        continue;
+      }
+      final snapshot = AudioClockSnapshot(
+        playing: state.playing != 0,
+        sampleRate: state.sampleRate,
+        sequenceId: state.sequenceId,
+        frame: state.frame,
+        hostTimeNanos: state.hostTimeNanos,
+        beat: state.beat,
+        beatsPerSecond: state.beatsPerSecond,
+      );
+      if (state.sequence == before) {
+        return _last = snapshot;
+      }
+    }
+    return _last;
+  }
+  
+  /// Transport beat heard at [hostTimeNanos] (default now), extrapolated
+  /// from the latest snapshot. Add the device's output latency to the
+  /// timestamp to line up with the speaker rather than the buffer queue.
+  double beatAt([int? hostTimeNanos]) {
+    final snapshot = read();
+    if (snapshot == null) {
+      return 0.0;
+    }
+    final elapsedSeconds = ((hostTimeNanos ?? this.hostTimeNanos) - snapshot.hostTimeNanos) / 1e9;
+    return snapshot.beat + snapshot.beatsPerSecond * elapsedSeconds;
+  }
+}
+
+/// Note input that writes events straight into native memory for the audio
+/// thread to pick up at its next callback, with no native call per note.
+/// Obtain one from [MultiTrackerFFI.createNoteInput]; it is invalid after
+/// [MultiTrackerFFI.dispose]. Single producer: use it from one isolate only.
+///
+/// Encodes the native `NoteInputRing` layout: a 128-byte header holding the
+/// write index (offset 0), capacity (4) and read index (64), then one 64-bit
+/// word per event.
+class NoteInputRing {
+  static const int _noteOn = 1;
+  static const int _noteOff = 2;
+  static const int _writeIndex = 0;
+  static const int _capacity = 1;
+  static const int _readIndex = 16;
+  static const int _headerBytes = 128;
+  
+  final Uint32List _header;
+  final Uint64List _events;
+  
+  NoteInputRing._(Pointer<Uint8> memory, Uint32List header)
+      : _header = header,
+        _events = Pointer<Uint64>.fromAddress(memory.address + _headerBytes).asTypedList(header[_capacity]);
+  
+  factory NoteInputRing._fromPointer(Pointer<Uint8> memory) {
+    return NoteInputRing._(memory, memory.cast<Uint32>().asTypedList(_headerBytes ~/ 4));
+  }
+  
+  /// Maximum number of events waiting for the audio thread
+  int get capacity => _events.length;
+  
+  /// Queue a note on; false if the ring is full
+  bool noteOn(int instrumentId, int noteNumber, int velocity) =>
+      _push(_noteOn, instrumentId, noteNumber, velocity);
+  
+  /// Queue a note off; false if the ring is full
+  bool noteOff(int instrumentId, int noteNumber) => _push(_noteOff, instrumentId, noteNumber, 0);
+  
+  bool _push(int type, int instrumentId, int noteNumber, int velocity) {
+    final write = _header[_writeIndex];
+    if (((write - _header[_readIndex]) & 0xFFFFFFFF) >= capacity) {
+      return false;
+    }
+    
+    // One word per event, stamped with its index, so the audio thread never
+    // takes a slot that hasn't landed yet
+    _events[write & (capacity - 1)] = ((write + 1) & 0xFFFF) |
+        (type << 16) |
+        ((noteNumber & 0xFF) << 24) |
+        ((velocity & 0xFF) << 32) |
+        ((instrumentId & 0xFFFFFF) << 40);
+    _header[_writeIndex] = (write + 1) & 0xFFFFFFFF;
+    return true;
+  }
+}
+
+/// Reader over a rendered audio tap: interleaved stereo float samples the
+/// audio thread writes into native memory, read here in place. Obtain one
+/// from [MultiTrackerFFI.createAudioTap]; it is invalid after
+/// [MultiTrackerFFI.dispose]. The audio thread never waits for readers, so
+/// any number of them can follow one tap, each with its own cursor.
+///
+/// Encodes the native `AudioTap` layout: a 64-byte header holding the
+/// written frame count (offset 0), the render frame of tap frame 0 (8), the
+/// capacity in frames (16), the channel count (20), the source track (24)
+/// and the guard (28), then the samples. The audio thread copies each block
+/// in before publishing its count, so the oldest [guard] frames may already
+/// be overwritten and are never read.
+class AudioTap {
+  static const int _written = 0;
+  static const int _startFrame = 1;
+  static const int _capacity = 4;
+  static const int _channels = 5;
+  static const int _source = 6;
+  static const int _guard = 7;
+  static const int _headerBytes = 64;
+  
+  final Int64List _header64;
+  final Int32List _header32;
+  
+  /// The tap's samples in place, [capacity] frames of [channels] floats.
+  /// Frame n lives at index `(n % capacity) * channels`; only the
+  /// `capacity - guard` frames before [written] are safe to read.
+  final Float32List samples;
+  
+  int _cursor;
+  int _droppedFrames = 0;
+  
+  AudioTap._(Pointer<Uint8> memory, this._header64, this._header32)
+      : samples = Pointer<Float>.fromAddress(memory.address + _headerBytes)
+            .asTypedList(_header32[_capacity] * _header32[_channels]),
+        _cursor = _header64[_written];
+  
+  factory AudioTap._fromPointer(Pointer<Uint8> memory) {
+    return AudioTap._(
+      memory,
+      memory.cast<Int64>().asTypedList(_headerBytes ~/ 8),
+      memory.cast<Int32>().asTypedList(_headerBytes ~/ 4),
+    );
+  }
+  
+  /// Frames the tap holds before the oldest is overwritten
+  int get capacity => _header32[_capacity];
+  
+  /// Samples per frame (stereo)
+  int get channels => _header32[_channels];
+  
+  /// Track ID the tap follows, or -1 for the master output
+  int get sourceTrackId => _header32[_source];
+  
+  /// Frames at the old end of the ring the next block may be overwriting
+  int get guard => _header32[_guard];
+  
+  /// Oldest frame that can be read while [writtenFrames] are published
+  int _oldestSafe(int writtenFrames) => writtenFrames - capacity + guard;
+  
+  /// Frames the audio thread has published so far
+  int get written => _header64[_written];
+  
+  /// Tap frame the next [read] starts at
+  int get position => _cursor;
+  
+  /// Frames this reader lost by falling more than [capacity] behind
+  int get droppedFrames => _droppedFrames;
+  
+  /// Render frame (as in [AudioClockSnapshot.frame]) tap frame [tapFrame]
+  /// was rendered at; -1 before the first block
+  int renderFrameOf(int tapFrame) {
+    final start = _header64[_startFrame];
+    return start < 0 ? -1 : start + tapFrame;
+  }
+  
+  /// Copy the frames published since the last read into [into] (interleaved,
+  /// up to `into.length ~/ channels` frames) and advance the cursor. Returns
+  /// the number of frames copied. A reader that fell behind skips to the
+  /// oldest frame safely held and counts the gap in [droppedFrames].
+  int read(Float32List into) {
+    final available = written;
+    final oldest = _oldestSafe(available);
+    if (_cursor < oldest) {
+      _droppedFrames += oldest - _cursor;
+      _cursor = oldest;
+    }
+    final frames = min(available - _cursor, into.length ~/ channels);
+    if (frames <= 0) {
+      return 0;
+    }
+    _copy(_cursor, frames, into);
+    
+    // Frames the writer lapped while we copied are torn; keep the rest
+    final overwritten = _oldestSafe(written) - _cursor;
+    if (overwritten > 0) {
+      final lost = min(overwritten, frames);
+      into.setRange(0, (frames - lost) * channels, into, lost * channels);
+      _droppedFrames += lost;
+      _cursor += frames;
+      return frames - lost;
+    }
+    _cursor += frames;
+    return frames;
+  }
+  
+  /// Copy the most recent frames (up to `into.length ~/ channels`) into
+  /// [into] without moving the cursor, for waveform displays. Returns the
+  /// number of frames copied.
+  int latest(Float32List into) {
+    final available = written;
+    final frames = min(min(available, capacity - guard), into.length ~/ channels);
+    if (frames <= 0) {
+      return 0;
+    }
+    final from = available - frames;
+    _copy(from, frames, into);
+    
+    // As in read, drop any frames lapped during the copy
+    final lost = min(_oldestSafe(written) - from, frames);
+    if (lost > 0) {
+      into.setRange(0, (frames - lost) * channels, into, lost * channels);
+      return frames - lost;
+    }
+    return frames;
+  }
+  
+  /// Move the cursor to the newest frame, skipping anything unread
+  void skipToLatest() {
+    _cursor = written;
+  }
+  
+  void _copy(int from, int frames, Float32List into) {
+    final offset = from % capacity;
+    final first = min(frames, capacity - offset);
+    into.setRange(0, first * channels, samples, offset * channels);
+    if (first < frames) {
+      into.setRange(first * channels, frames * channels, samples, 0);
+    }
+  }
+}
+
 /// FFI implementation for flutter_multitracker
 class MultiTrackerFFI {
   /// Singleton instance
@@ -27,9 +653,27 @@ class MultiTrackerFFI {
   final _callbacks = <int, NativeCallbackType>{};
   int _nextCallbackId = 1;
   
+  /// Meter levels streamed from native code
+  final _meterController = StreamController<MeterLevels>.broadcast();
+  
+  /// Meter snapshots, delivered while the meter stream is running
+  Stream<MeterLevels> get meterLevels => _meterController.stream;
+  
+  /// Engine events streamed from native code, one list per native batch
+  final _engineEventController = StreamController<List<EngineEvent>>.broadcast();
+  
+  /// Batches of engine events, delivered while the event stream is running
+  Stream<List<EngineEvent>> get engineEvents => _engineEventController.stream;
+  
+  /// MIDI file exports still being written natively, by export ID
+  final _pendingExports = <int, Completer<bool>>{};
+  
   /// Default timeout for native operations
   static const Duration defaultTimeout = Duration(seconds: 5);
   
+  /// Default timeout for a MIDI export, which writes the whole file natively
+  static const Duration defaultExportTimeout = Duration(seconds: 30);
+  
   /// Factory constructor for singleton access
   factory MultiTrackerFFI() {
     developer.log('Creating MultiTrackerFFI instance', name: 'MultiTrackerFFI');
@@ -47,7 +691,13 @@ class MultiTrackerFFI {
   void _setupCallbacks() {
     _log('Setting up callback mechanism');
     _callbackSubscription = _callbackPort.listen((dynamic message) {
-      if (message is List && message.length >= 4) {
+      if (message is List && message.length == 6 && message[0] == 'meters') {
+        _handleMeterMessage(message);
+      } else if (message is List && message.length == 2 && message[0] == 'events') {
+        _engineEventController.add(EngineEvent.decodeBatch(message[1] as Uint8List));
+      } else if (message is List && message.length == 3 && message[0] == 'midiExport') {
+        _pendingExports.remove(message[1] as int)?.complete(message[2] as bool);
+      } else if (message is List && message.length >= 4) {
         final callbackId = message[0] as int;
         final data1 = message[1] as int;
         final data2 = message[2] as int;
@@ -70,6 +720,25 @@ class MultiTrackerFFI {
     });
   }
   
+  /// Decode a meter message: ["meters", Int32List ids, Float32List peaks, Float32List rms, masterPeak, masterRms]
+  void _handleMeterMessage(List message) {
+    final ids = message[1] as Int32List;
+    final peaks = message[2] as Float32List;
+    final rms = message[3] as Float32List;
+    final trackPeaks = <int, double>{};
+    final trackRms = <int, double>{};
+    for (var i = 0; i < ids.length; i++) {
+      trackPeaks[ids[i]] = peaks[i];
+      trackRms[ids[i]] = rms[i];
+    }
+    _meterController.add(MeterLevels(
+      trackPeaks: trackPeaks,
+      trackRms: trackRms,
+      masterPeak: message[4] as double,
+      masterRms: message[5] as double,
+    ));
+  }
+  
   /// Logger function
   void _log(String message) {
     developer.log(message, name: 'MultiTrackerFFI');
@@ -163,6 +832,16 @@ class MultiTrackerFFI {
         _log('Callback registration not available or failed: $e');
       }
       
+      // Let native code post messages (meters) to the callback port
+      try {
+        final initDartApi = _nativeLib!
+          .lookupFunction<Int8 Function(Pointer<Void>), int Function(Pointer<Void>)>('init_dart_api');
+        final result = initDartApi(NativeApi.initializeApiDLData);
+        _log('Dart API initialization returned: $result');
+      } catch (e) {
+        _log('Dart API initialization not available or failed: $e');
+      }
+      
       // Verify the native library is properly initialized by calling a test function
       try {
         final testFunc = _nativeLib!.lookupFunction<Int8 Function(), int Function()>('test_init');
@@ -261,6 +940,12 @@ class MultiTrackerFFI {
           _callbackPort.close();
           _callbacks.clear();
           
+          // No completion messages can arrive once the port is closed
+          for (final completer in _pendingExports.values) {
+            completer.complete(false);
+          }
+          _pendingExports.clear();
+          
           // Call native dispose if initialized
           try {
             _log('Calling native dispose function');
@@ -403,7 +1088,7 @@ class MultiTrackerFFI {
       _ensureInitialized();
       
       _log('Creating sequence with BPM: $bpm, time signature: $timeSignatureNumerator/$timeSignatureDenominator');
-      final func = _nativeLib!.lookupFunction<Int32 Function(Float, Int32, Int32), int Function(double, int, int)>('create_sequence');
+      final func = _nativeLib!.lookupFunction<Int32 Function(Double, Int32, Int32), int Function(double, int, int)>('create_sequence');
       final result = func(bpm, timeSignatureNumerator, timeSignatureDenominator);
       _log('Create sequence returned ID: $result');
       
@@ -414,6 +1099,116 @@ class MultiTrackerFFI {
       return result;
     }, 'createSequence', timeout: timeout);
   }
+
+  /// Import a Standard MIDI File (type 0 or 1) as a new sequence with timeout.
+  ///
+  /// Each MIDI track and channel becomes its own track, all playing
+  /// [instrumentId]. Returns the ID of the new sequence.
+  Future<int> importMidiFile(String path, int instrumentId, {Duration timeout = defaultTimeout}) async {
+    return await _executeWithTimeout(() async {
+      _ensureInitialized();
+      
+      _log('Importing MIDI file from path: $path with instrument ID: $instrumentId');
+      final pathPointer = path.toNativeUtf8(allocator: malloc);
+      try {
+        final func = _nativeLib!.lookupFunction<Int32 Function(Pointer<Utf8>, Int32), int Function(Pointer<Utf8>, int)>('import_midi_file');
+        final result = func(pathPointer, instrumentId);
+        _log('Import MIDI file returned sequence ID: $result');
+        
+        if (result < 0) {
+          throw Exception('Failed to import MIDI file, code: $result');
+        }
+        
+        return result;
+      } finally {
+        malloc.free(pathPointer);
+      }
+    }, 'importMidiFile', timeout: timeout);
+  }
+
+  /// Save all sequences to a binary project file with timeout.
+  ///
+  /// Instruments are not saved; load the same instruments before loading the
+  /// project so the saved instrument IDs resolve.
+  Future<bool> saveProject(String path, {Duration timeout = defaultTimeout}) async {
+    return await _executeWithTimeout(() async {
+      _ensureInitialized();
+      
+      _log('Saving project to path: $path');
+      final pathPointer = path.toNativeUtf8(allocator: malloc);
+      try {
+        final func = _nativeLib!.lookupFunction<Int8 Function(Pointer<Utf8>), int Function(Pointer<Utf8>)>('save_project');
+        final result = func(pathPointer);
+        _log('Save project returned: $result');
+        return result == 1;
+      } finally {
+        malloc.free(pathPointer);
+      }
+    }, 'saveProject', timeout: timeout);
+  }
+  
+  /// Load a project file with timeout, replacing all sequences.
+  ///
+  /// Sequence, track and note IDs are restored as saved. Returns the number of
+  /// sequences loaded.
+  Future<int> loadProject(String path, {Duration timeout = defaultTimeout}) async {
+    return await _executeWithTimeout(() async {
+      _ensureInitialized();
+      
+      _log('Loading project from path: $path');
+      final pathPointer = path.toNativeUtf8(allocator: malloc);
+      try {
+        final func = _nativeLib!.lookupFunction<Int32 Function(Pointer<Utf8>), int Function(Pointer<Utf8>)>('load_project');
+        final result = func(pathPointer);
+        _log('Load project returned: $result');
+        
+        if (result < 0) {
+          throw Exception('Failed to load project, code: $result');
+        }
+        
+        return result;
+      } finally {
+        malloc.free(pathPointer);
+      }
+    }, 'loadProject', timeout: timeout);
+  }
+  
+  /// Export a sequence to a Standard MIDI File (type 1).
+  ///
+  /// The file is written on a native background thread from a snapshot of the
+  /// sequence, so it can be edited meanwhile. Completes with whether the file
+  /// was written, or with false if the native writer hasn't reported back
+  /// within [timeout].
+  Future<bool> exportMidiFile(int sequenceId, String path, {Duration timeout = defaultExportTimeout}) async {
+    _ensureInitialized();
+    
+    _log('Exporting sequence ID: $sequenceId to MIDI file: $path');
+    final pathPointer = path.toNativeUtf8(allocator: malloc);
+    try {
+      final func = _nativeLib!.lookupFunction<Int32 Function(Int32, Pointer<Utf8>), int Function(int, Pointer<Utf8>)>('export_midi_file');
+      final exportId = func(sequenceId, pathPointer);
+      _log('Export MIDI file returned export ID: $exportId');
+      
+      if (exportId < 0) {
+        return false;
+      }
+      
+      // Completed by the 'midiExport' message from the native writer
+      final completer = Completer<bool>();
+      _pendingExports[exportId] = completer;
+      return await completer.future.timeout(timeout, onTimeout: () {
+        // A late completion message finds no entry and is ignored
+        _pendingExports.remove(exportId);
+        _log('MIDI export $exportId timed out after ${timeout.inMilliseconds}ms');
+        return false;
+      });
+    } catch (e) {
+      _log('Error exporting MIDI file: $e');
+      return false;
+    } finally {
+      malloc.free(pathPointer);
+    }
+  }
                             
   /// Add a track to a sequence with timeout
   Future<int> addTrack(int sequenceId, int instrumentId, {Duration timeout = defaultTimeout}) async {
@@ -447,67 +1242,305 @@ class MultiTrackerFFI {
     }, 'addNote', timeout: timeout);
   }
                             
-  /// Play a sequence
-  int playSequence(int sequenceId, int loop) {
+  /// Add [count] notes to a track in one call, straight from a native
+  /// [NoteRecord] array (e.g. from `malloc<NoteRecord>(count)`) without copying.
+  /// [outIds] must hold [count] entries; each receives the note ID, or -1 if
+  /// that record was rejected. Returns the number of notes added or -1.
+  int addNotesBulk(int sequenceId, int trackId, Pointer<NoteRecord> records, int count, Pointer<Int32> outIds) {
     _ensureInitialized();
     
-    _log('Playing sequence ID: $sequenceId, loop: $loop');
+    _log('Adding $count notes to track ID: $trackId in sequence ID: $sequenceId');
     try {
-      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int8), int Function(int, int)>('play_sequence');
-      final result = func(sequenceId, loop);
-      _log('Play sequence returned: $result');
+      final func = _nativeLib!.lookupFunction<
+          Int32 Function(Int32, Int32, Pointer<NoteRecord>, Int32, Pointer<Int32>),
+          int Function(int, int, Pointer<NoteRecord>, int, Pointer<Int32>)>('add_notes_bulk');
+      final result = func(sequenceId, trackId, records, count, outIds);
+      _log('Add notes bulk returned: $result');
       return result;
     } catch (e) {
-      _log('Error playing sequence: $e');
-      return 0;
+      _log('Error adding notes in bulk: $e');
+      return -1;
     }
   }
-                            
-  /// Stop a sequence
-  int stopSequence(int sequenceId) {
+  
+  /// Find the notes of a track overlapping [startBeat, endBeat) with note
+  /// numbers in [lowNote, highNote], e.g. those visible in a piano-roll
+  /// viewport. Up to [capacity] notes are written to [out] in start order.
+  /// Returns the total number of matches, so a larger buffer can be passed
+  /// when it exceeds [capacity], or -1 on error.
+  int queryNotes(int sequenceId, int trackId, double startBeat, double endBeat,
+      int lowNote, int highNote, Pointer<NoteQueryRecord> out, int capacity) {
     _ensureInitialized();
     
-    _log('Stopping sequence ID: $sequenceId');
     try {
-      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('stop_sequence');
-      final result = func(sequenceId);
-      _log('Stop sequence returned: $result');
-      return result;
+      final func = _nativeLib!.lookupFunction<
+          Int32 Function(Int32, Int32, Double, Double, Int32, Int32, Pointer<NoteQueryRecord>, Int32),
+          int Function(int, int, double, double, int, int, Pointer<NoteQueryRecord>, int)>('query_notes');
+      return func(sequenceId, trackId, startBeat, endBeat, lowNote, highNote, out, capacity);
     } catch (e) {
-      _log('Error stopping sequence: $e');
-      return 0;
+      _log('Error querying notes: $e');
+      return -1;
     }
   }
-                            
-  /// Delete a sequence
-  int deleteSequence(int sequenceId) {
+  
+  /// Apply every command in [commands] in one native call and one lock.
+  /// Returns the number of commands applied (commands referring to missing
+  /// sequences, tracks or notes are skipped), or -1 if the buffer was rejected.
+  int submitCommands(CommandBuffer commands) {
     _ensureInitialized();
     
-    _log('Deleting sequence ID: $sequenceId');
+    final length = commands.lengthInBytes;
+    _log('Submitting ${commands.commandCount} edit commands ($length bytes)');
+    final pointer = malloc<Uint8>(length == 0 ? 1 : length);
     try {
-      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('delete_sequence');
-      final result = func(sequenceId);
-      _log('Delete sequence returned: $result');
+      pointer.asTypedList(length).setAll(0, commands.bytes);
+      final func = _nativeLib!.lookupFunction<
+          Int32 Function(Pointer<Uint8>, Int32),
+          int Function(Pointer<Uint8>, int)>('submit_commands');
+      final result = func(pointer, length);
+      _log('Submit commands returned: $result');
       return result;
     } catch (e) {
-      _log('Error deleting sequence: $e');
-      return 0;
+      _log('Error submitting commands: $e');
+      return -1;
+    } finally {
+      malloc.free(pointer);
     }
   }
-                            
-  /// Set playback position
-  int setPlaybackPosition(int sequenceId, double beat) {
+  
+  /// Undo the most recent sequence edit. Returns false if there is nothing to undo.
+  bool undo() {
     _ensureInitialized();
     
-    _log('Setting playback position of sequence ID: $sequenceId to beat: $beat');
+    _log('Undo');
     try {
-      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Float), int Function(int, double)>('set_playback_position');
-      final result = func(sequenceId, beat);
-      _log('Set playback position returned: $result');
-      return result;
+      final func = _nativeLib!.lookupFunction<Int8 Function(), int Function()>('undo');
+      return func() == 1;
     } catch (e) {
-      _log('Error setting playback position: $e');
-      return 0;
+      _log('Error undoing: $e');
+      return false;
+    }
+  }
+  
+  /// Redo the most recently undone edit. Returns false if there is nothing to redo.
+  bool redo() {
+    _ensureInitialized();
+    
+    _log('Redo');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(), int Function()>('redo');
+      return func() == 1;
+    } catch (e) {
+      _log('Error redoing: $e');
+      return false;
+    }
+  }
+  
+  /// Bound the undo history to [maxLevels] edits and roughly [maxBytes] of memory.
+  /// Defaults are 100 levels and 32 MB.
+  bool setUndoLimits(int maxLevels, int maxBytes) {
+    _ensureInitialized();
+    
+    _log('Setting undo limits: $maxLevels levels, $maxBytes bytes');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int64), int Function(int, int)>('set_undo_limits');
+      return func(maxLevels, maxBytes) == 1;
+    } catch (e) {
+      _log('Error setting undo limits: $e');
+      return false;
+    }
+  }
+  
+  /// Play a sequence
+  int playSequence(int sequenceId, int loop) {
+    _ensureInitialized();
+    
+    _log('Playing sequence ID: $sequenceId, loop: $loop');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int8), int Function(int, int)>('play_sequence');
+      final result = func(sequenceId, loop);
+      _log('Play sequence returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error playing sequence: $e');
+      return 0;
+    }
+  }
+
+  /// Set the tick grid (ticks per beat, 1-32767) that sequences created from
+  /// now on snap note positions to. Imported MIDI files keep their own.
+  int setTicksPerBeat(int ticksPerBeat) {
+    _ensureInitialized();
+
+    _log('Setting tick grid to $ticksPerBeat ticks per beat');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('set_ticks_per_beat');
+      final result = func(ticksPerBeat);
+      _log('Set ticks per beat returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting ticks per beat: $e');
+      return 0;
+    }
+  }
+
+  /// Set how many audio blocks (1-16, default 2) the sequencer schedules
+  /// ahead of playback. More blocks survive scheduling hiccups on busy
+  /// devices; fewer make edits to the playing sequence heard sooner.
+  int setSchedulerLookahead(int blocks) {
+    _ensureInitialized();
+
+    _log('Setting scheduler lookahead to $blocks blocks');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('set_scheduler_lookahead');
+      final result = func(blocks);
+      _log('Set scheduler lookahead returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting scheduler lookahead: $e');
+      return 0;
+    }
+  }
+
+  /// Add or replace a tempo change at [beat]; with [ramp] the tempo moves
+  /// linearly to the next change's tempo
+  int setTempoChange(int sequenceId, double beat, double bpm, {bool ramp = false}) {
+    _ensureInitialized();
+
+    _log('Setting tempo of sequence $sequenceId at beat $beat to $bpm, ramp: $ramp');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Double, Double, Int8), int Function(int, double, double, int)>('set_tempo_change');
+      final result = func(sequenceId, beat, bpm, ramp ? 1 : 0);
+      _log('Set tempo change returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting tempo change: $e');
+      return 0;
+    }
+  }
+
+  /// Remove the tempo change at [beat]; the one at beat 0 can't be removed
+  int removeTempoChange(int sequenceId, double beat) {
+    _ensureInitialized();
+
+    _log('Removing tempo change of sequence $sequenceId at beat $beat');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Double), int Function(int, double)>('remove_tempo_change');
+      final result = func(sequenceId, beat);
+      _log('Remove tempo change returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error removing tempo change: $e');
+      return 0;
+    }
+  }
+
+  /// Add or replace a time signature change at [beat]
+  int setTimeSignature(int sequenceId, double beat, int numerator, int denominator) {
+    _ensureInitialized();
+
+    _log('Setting time signature of sequence $sequenceId at beat $beat to $numerator/$denominator');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Double, Int32, Int32), int Function(int, double, int, int)>('set_time_signature');
+      final result = func(sequenceId, beat, numerator, denominator);
+      _log('Set time signature returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting time signature: $e');
+      return 0;
+    }
+  }
+
+  /// Convert a beat to seconds through the sequence's tempo map; -1 on error
+  double beatToSeconds(int sequenceId, double beat) {
+    _ensureInitialized();
+
+    try {
+      final func = _nativeLib!.lookupFunction<Double Function(Int32, Double), double Function(int, double)>('beat_to_seconds');
+      return func(sequenceId, beat);
+    } catch (e) {
+      _log('Error converting beat to seconds: $e');
+      return -1.0;
+    }
+  }
+
+  /// Convert seconds to a beat through the sequence's tempo map; -1 on error
+  double secondsToBeat(int sequenceId, double seconds) {
+    _ensureInitialized();
+
+    try {
+      final func = _nativeLib!.lookupFunction<Double Function(Int32, Double), double Function(int, double)>('seconds_to_beat');
+      return func(sequenceId, seconds);
+    } catch (e) {
+      _log('Error converting seconds to beat: $e');
+      return -1.0;
+    }
+  }
+
+  /// Set the region a sequence loops over when played with loop set; an
+  /// empty region (end <= start) loops the whole sequence
+  int setLoopRegion(int sequenceId, double startBeat, double endBeat) {
+    _ensureInitialized();
+
+    _log('Setting loop region of sequence $sequenceId to $startBeat-$endBeat');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Double, Double), int Function(int, double, double)>('set_loop_region');
+      final result = func(sequenceId, startBeat, endBeat);
+      _log('Set loop region returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting loop region: $e');
+      return 0;
+    }
+  }
+                            
+  /// Stop a sequence
+  int stopSequence(int sequenceId) {
+    _ensureInitialized();
+    
+    _log('Stopping sequence ID: $sequenceId');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('stop_sequence');
+      final result = func(sequenceId);
+      _log('Stop sequence returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error stopping sequence: $e');
+      return 0;
+    }
+  }
+                            
+  /// Delete a sequence
+  int deleteSequence(int sequenceId) {
+    _ensureInitialized();
+    
+    _log('Deleting sequence ID: $sequenceId');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('delete_sequence');
+      final result = func(sequenceId);
+      _log('Delete sequence returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error deleting sequence: $e');
+      return 0;
+    }
+  }
+                            
+  /// Set playback position. Seeking the playing sequence restarts the notes
+  /// that span [beat], partway in when [offsetIntoNotes] is set; seeking any
+  /// other sequence sets where its next playback starts.
+  int setPlaybackPosition(int sequenceId, double beat, {bool offsetIntoNotes = true}) {
+    _ensureInitialized();
+    
+    _log('Setting playback position of sequence ID: $sequenceId to beat: $beat');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Double, Int8), int Function(int, double, int)>('set_playback_position');
+      final result = func(sequenceId, beat, offsetIntoNotes ? 1 : 0);
+      _log('Set playback position returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting playback position: $e');
+      return 0;
     }
   }
                             
@@ -517,7 +1550,7 @@ class MultiTrackerFFI {
     
     _log('Getting playback position of sequence ID: $sequenceId');
     try {
-      final func = _nativeLib!.lookupFunction<Float Function(Int32), double Function(int)>('get_playback_position');
+      final func = _nativeLib!.lookupFunction<Double Function(Int32), double Function(int)>('get_playback_position');
       final result = func(sequenceId);
       _log('Get playback position returned: $result');
       return result;
@@ -527,6 +1560,134 @@ class MultiTrackerFFI {
     }
   }
                             
+  /// Shared-memory note input for high-rate live playing; the first call
+  /// sets its [capacity] (16-4096 events) and later calls return the same
+  /// ring. Null if it can't be created.
+  NoteInputRing? createNoteInput({int capacity = 256}) {
+    _ensureInitialized();
+    
+    _log('Creating note input ring with capacity $capacity');
+    try {
+      final func = _nativeLib!.lookupFunction<Pointer<Uint8> Function(Int32), Pointer<Uint8> Function(int)>('create_note_input');
+      final memory = func(capacity);
+      if (memory == nullptr) {
+        return null;
+      }
+      return NoteInputRing._fromPointer(memory);
+    } catch (e) {
+      _log('Error creating note input ring: $e');
+      return null;
+    }
+  }
+                            
+  /// Start recording the default audio input to a 16-bit WAV file at
+  /// [path]. The take is placed on the timeline through the output clock;
+  /// pass the device's measured round-trip latency as [latencyMs] so it lines
+  /// up with what the performer heard. Needs the RECORD_AUDIO permission.
+  bool startRecording(String path, {int channels = 1, double latencyMs = 0.0}) {
+    _ensureInitialized();
+    
+    _log('Starting recording to $path ($channels channels, ${latencyMs}ms latency)');
+    final pathPointer = path.toNativeUtf8(allocator: malloc);
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Pointer<Utf8>, Int32, Float), int Function(Pointer<Utf8>, int, double)>('start_recording');
+      final result = func(pathPointer, channels, latencyMs);
+      _log('Start recording returned: $result');
+      return result == 1;
+    } catch (e) {
+      _log('Error starting recording: $e');
+      return false;
+    } finally {
+      malloc.free(pathPointer);
+    }
+  }
+  
+  /// Stop recording and finish the file; false if nothing was recording or
+  /// the file couldn't be completed
+  bool stopRecording() {
+    _ensureInitialized();
+    
+    _log('Stopping recording');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(), int Function()>('stop_recording');
+      final result = func();
+      _log('Stop recording returned: $result');
+      return result == 1;
+    } catch (e) {
+      _log('Error stopping recording: $e');
+      return false;
+    }
+  }
+  
+  /// Status of the current or last recording; null if it can't be read
+  RecordingStatus? recordingStatus() {
+    _ensureInitialized();
+    
+    final statusPointer = malloc<_RecordingStatusStruct>();
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Pointer<_RecordingStatusStruct>), int Function(Pointer<_RecordingStatusStruct>)>('get_recording_status');
+      if (func(statusPointer) != 1) {
+        return null;
+      }
+      final status = statusPointer.ref;
+      return RecordingStatus(
+        state: RecordingState.values[status.state.clamp(0, RecordingState.values.length - 1)],
+        framesWritten: status.framesWritten,
+        framesDropped: status.framesDropped,
+        startFrame: status.startFrame,
+        startBeat: status.startBeat,
+        sequenceId: status.sequenceId,
+      );
+    } catch (e) {
+      _log('Error reading recording status: $e');
+      return null;
+    } finally {
+      malloc.free(statusPointer);
+    }
+  }
+  
+  /// Tap of the rendered output that Dart reads in place: the master mix
+  /// after the limiter, or one track after its fader when [trackId] is
+  /// given. A track that doesn't exist yet reads as silence. The first call
+  /// for a source sets its [capacityFrames]; later calls share that tap.
+  /// Null if it can't be created.
+  AudioTap? createAudioTap({int trackId = -1, int capacityFrames = 65536}) {
+    _ensureInitialized();
+    
+    _log('Creating audio tap for track $trackId with $capacityFrames frames');
+    try {
+      final func = _nativeLib!.lookupFunction<Pointer<Uint8> Function(Int32, Int32), Pointer<Uint8> Function(int, int)>('create_audio_tap');
+      final memory = func(trackId, capacityFrames);
+      if (memory == nullptr) {
+        return null;
+      }
+      return AudioTap._fromPointer(memory);
+    } catch (e) {
+      _log('Error creating audio tap: $e');
+      return null;
+    }
+  }
+  
+  /// Playhead backed by the engine's shared clock. Reading it costs no native
+  /// call; null if the engine isn't running a clock.
+  PlaybackClock? playbackClock() {
+    _ensureInitialized();
+    
+    try {
+      final func = _nativeLib!.lookupFunction<Pointer<AudioClockState> Function(),
+          Pointer<AudioClockState> Function()>('get_audio_clock');
+      final state = func();
+      if (state == nullptr) {
+        return null;
+      }
+      final stopwatch = Stopwatch()..start();
+      return PlaybackClock._(state, hostTimeNanos(), stopwatch);
+    } catch (e) {
+      _log('Error getting playback clock: $e');
+      return null;
+    }
+  }
+                            
   /// Set master volume
   int setMasterVolume(double volume) {
     _ensureInitialized();
@@ -543,6 +1704,87 @@ class MultiTrackerFFI {
     }
   }
                             
+  /// Configure the master limiter: output ceiling in dBFS (-24 to 0) and release time in ms
+  int setLimiter({double ceilingDb = -1.0, double releaseMs = 50.0}) {
+    _ensureInitialized();
+    
+    _log('Setting limiter ceiling to: $ceilingDb dB, release: $releaseMs ms');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Float, Float), int Function(double, double)>('set_limiter');
+      final result = func(ceilingDb, releaseMs);
+      _log('Set limiter returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting limiter: $e');
+      return 0;
+    }
+  }
+  
+  /// Start streaming meter levels to [meterLevels] at [rateHz] updates per second
+  int startMeterStream({int rateHz = 30}) {
+    _ensureInitialized();
+    
+    _log('Starting meter stream at $rateHz Hz');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('start_meter_stream');
+      final result = func(rateHz);
+      _log('Start meter stream returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error starting meter stream: $e');
+      return 0;
+    }
+  }
+  
+  /// Stop streaming meter levels
+  int stopMeterStream() {
+    _ensureInitialized();
+    
+    _log('Stopping meter stream');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(), int Function()>('stop_meter_stream');
+      final result = func();
+      _log('Stop meter stream returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error stopping meter stream: $e');
+      return 0;
+    }
+  }
+  
+  /// Start streaming engine events to [engineEvents]. Events are batched
+  /// natively and posted at most [rateHz] times per second.
+  int startEventStream({int rateHz = 60}) {
+    _ensureInitialized();
+    
+    _log('Starting event stream at $rateHz Hz');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('start_event_stream');
+      final result = func(rateHz);
+      _log('Start event stream returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error starting event stream: $e');
+      return 0;
+    }
+  }
+  
+  /// Stop streaming engine events
+  int stopEventStream() {
+    _ensureInitialized();
+    
+    _log('Stopping event stream');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(), int Function()>('stop_event_stream');
+      final result = func();
+      _log('Stop event stream returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error stopping event stream: $e');
+      return 0;
+    }
+  }
+  
   /// Set track volume
   int setTrackVolume(int sequenceId, int trackId, double volume) {
     _ensureInitialized();
@@ -559,6 +1801,73 @@ class MultiTrackerFFI {
     }
   }
   
+  /// Add volume automation points to a track in one call.
+  /// [beats] and [volumes] are parallel lists; returns the number of points added or -1.
+  int addVolumeAutomation(int sequenceId, int trackId, List<double> beats, List<double> volumes) {
+    _ensureInitialized();
+    
+    if (beats.length != volumes.length) {
+      _log('Automation beats and volumes must have the same length');
+      return -1;
+    }
+    
+    _log('Adding ${beats.length} volume automation points to track ID: $trackId in sequence ID: $sequenceId');
+    final count = beats.length;
+    final beatsPointer = malloc<Double>(count == 0 ? 1 : count);
+    final volumesPointer = malloc<Float>(count == 0 ? 1 : count);
+    try {
+      beatsPointer.asTypedList(count).setAll(0, beats);
+      volumesPointer.asTypedList(count).setAll(0, volumes);
+      final func = _nativeLib!.lookupFunction<
+          Int32 Function(Int32, Int32, Pointer<Double>, Pointer<Float>, Int32),
+          int Function(int, int, Pointer<Double>, Pointer<Float>, int)>('add_volume_automation');
+      final result = func(sequenceId, trackId, beatsPointer, volumesPointer, count);
+      _log('Add volume automation returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error adding volume automation: $e');
+      return -1;
+    } finally {
+      malloc.free(beatsPointer);
+      malloc.free(volumesPointer);
+    }
+  }
+  
+  /// Remove all volume automation points of a track in [startBeat, endBeat).
+  /// Returns the number of points removed or -1.
+  int removeVolumeAutomation(int sequenceId, int trackId, double startBeat, double endBeat) {
+    _ensureInitialized();
+    
+    _log('Removing volume automation in [$startBeat, $endBeat) from track ID: $trackId in sequence ID: $sequenceId');
+    try {
+      final func = _nativeLib!.lookupFunction<
+          Int32 Function(Int32, Int32, Double, Double),
+          int Function(int, int, double, double)>('remove_volume_automation');
+      final result = func(sequenceId, trackId, startBeat, endBeat);
+      _log('Remove volume automation returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error removing volume automation: $e');
+      return -1;
+    }
+  }
+  
+  /// Set track pan (-1.0 = left, 0.0 = centre, 1.0 = right)
+  int setTrackPan(int sequenceId, int trackId, double pan) {
+    _ensureInitialized();
+    
+    _log('Setting pan of track ID: $trackId in sequence ID: $sequenceId to: $pan');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int32, Float), int Function(int, int, double)>('set_track_pan');
+      final result = func(sequenceId, trackId, pan);
+      _log('Set track pan returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting track pan: $e');
+      return 0;
+    }
+  }
+  
   /// Send a note on message to play a note
   int sendNoteOn(int instrumentId, int noteNumber, int velocity) {
     _ensureInitialized();
@@ -590,6 +1899,137 @@ class MultiTrackerFFI {
       return 0;
     }
   }
+  
+  /// Current host time in nanoseconds on the clock [sendNoteOnAt] and
+  /// [sendNoteOffAt] expect (CLOCK_MONOTONIC). Read it as early as possible
+  /// in the input handler.
+  int hostTimeNanos() {
+    _ensureInitialized();
+    
+    final func = _nativeLib!.lookupFunction<Int64 Function(), int Function()>('get_host_time_nanos');
+    return func();
+  }
+  
+  /// Play a note at the audio frame matching [hostTimeNanos] plus a fixed
+  /// latency, rather than at whichever buffer renders next. Taps keep their
+  /// exact spacing at the cost of a constant delay. The timestamp defaults
+  /// to now.
+  int sendNoteOnAt(int instrumentId, int noteNumber, int velocity, {int? hostTimeNanos}) {
+    _ensureInitialized();
+    
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int32, Int32, Int64), int Function(int, int, int, int)>('play_note_at');
+      return func(instrumentId, noteNumber, velocity, hostTimeNanos ?? this.hostTimeNanos());
+    } catch (e) {
+      _log('Error sending timed Note On: $e');
+      return 0;
+    }
+  }
+  
+  /// Stop a note at the audio frame matching [hostTimeNanos], with the same
+  /// latency as [sendNoteOnAt] so note lengths are preserved
+  int sendNoteOffAt(int instrumentId, int noteNumber, {int? hostTimeNanos}) {
+    _ensureInitialized();
+    
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int32, Int64), int Function(int, int, int)>('stop_note_at');
+      return func(instrumentId, noteNumber, hostTimeNanos ?? this.hostTimeNanos());
+    } catch (e) {
+      _log('Error sending timed Note Off: $e');
+      return 0;
+    }
+  }
+  
+  /// Set the fixed latency added to [sendNoteOnAt] and [sendNoteOffAt]
+  /// notes. Below one buffer period late taps start bunching up again; a
+  /// negative value restores the default of one buffer.
+  int setLiveLatency(double latencyMs) {
+    _ensureInitialized();
+    
+    _log('Setting live note latency to $latencyMs ms');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Float), int Function(double)>('set_live_latency');
+      final result = func(latencyMs);
+      _log('Set live latency returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting live latency: $e');
+      return 0;
+    }
+  }
+  
+  /// Set the global polyphony limit
+  int setMaxPolyphony(int maxVoices) {
+    _ensureInitialized();
+    
+    _log('Setting max polyphony to: $maxVoices');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('set_max_polyphony');
+      final result = func(maxVoices);
+      _log('Set max polyphony returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting max polyphony: $e');
+      return 0;
+    }
+  }
+  
+  /// Set the polyphony limit (0 = global limit only) and stealing priority of an instrument
+  int setInstrumentPolyphony(int instrumentId, int maxVoices, {int priority = 0}) {
+    _ensureInitialized();
+    
+    _log('Setting polyphony of instrument $instrumentId to: $maxVoices, priority: $priority');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32, Int32, Int32), int Function(int, int, int)>('set_instrument_polyphony');
+      final result = func(instrumentId, maxVoices, priority);
+      _log('Set instrument polyphony returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting instrument polyphony: $e');
+      return 0;
+    }
+  }
+  
+  /// Set the ADSR envelope applied to notes started on an instrument
+  int setInstrumentEnvelope(
+    int instrumentId, {
+    double attackMs = 5.0,
+    double decayMs = 100.0,
+    double sustainLevel = 0.8,
+    double releaseMs = 200.0,
+    EnvelopeCurve curve = EnvelopeCurve.exponential,
+  }) {
+    _ensureInitialized();
+    
+    _log('Setting envelope of instrument $instrumentId: A=$attackMs D=$decayMs S=$sustainLevel R=$releaseMs');
+    try {
+      final func = _nativeLib!.lookupFunction<
+          Int8 Function(Int32, Float, Float, Float, Float, Int32),
+          int Function(int, double, double, double, double, int)>('set_instrument_envelope');
+      final result = func(instrumentId, attackMs, decayMs, sustainLevel, releaseMs, curve.index);
+      _log('Set instrument envelope returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting instrument envelope: $e');
+      return 0;
+    }
+  }
+  
+  /// Set the policy used to steal voices when a polyphony limit is reached
+  int setVoiceStealingPolicy(VoiceStealingPolicy policy) {
+    _ensureInitialized();
+    
+    _log('Setting voice stealing policy to: $policy');
+    try {
+      final func = _nativeLib!.lookupFunction<Int8 Function(Int32), int Function(int)>('set_voice_stealing_policy');
+      final result = func(policy.index);
+      _log('Set voice stealing policy returned: $result');
+      return result;
+    } catch (e) {
+      _log('Error setting voice stealing policy: $e');
+      return 0;
+    }
+  }
                             
   /// Play a test tone to verify audio output
   int playTestTone() {